@@ -34,6 +34,10 @@
 /* include ------------------------------------------------------------------ */
 #include "eos.h"
 #include <string.h>
+#include <stddef.h>
+#if (EOS_USE_TOPIC_TABLE != 0)
+#include "eos_topic.h"
+#endif
 
 EOS_TAG("EventOS")
 
@@ -57,12 +61,22 @@ enum
 };
 
 /* Private define ----------------------------------------------------------- */
-#if ((EOS_MAX_TASKS % 8) == 0)
-#define EOS_MAX_OWNER                       (EOS_MAX_TASKS >> 3)
+#if (EOS_USE_TOPIC_TABLE != 0 && EOS_TOPIC_MAX_OBJECTS != EOS_MAX_OBJECTS)
+#error The topic header is generated with another EOS_MAX_OBJECTS, regenerate it !
+#endif
+
+/* The topic header of tools/eos_phash.py places the static keys by the perfect
+   hash, which take the IDs before the dynamic objects. */
+#if (EOS_USE_TOPIC_TABLE != 0) && defined(EOS_TOPIC_PHASH_BUCKETS)
+#define EOS_USE_PHASH                       1
+#define EOS_PHASH_NUM                       EOS_TOPIC_NUM
 #else
-#define EOS_MAX_OWNER                       (EOS_MAX_TASKS >> 3 + 1)
+#define EOS_USE_PHASH                       0
+#define EOS_PHASH_NUM                       0
 #endif
 
+#define EOS_MAX_OWNER                       ((EOS_MAX_TASKS + 31) >> 5)
+
 #if ((EOS_MAX_OBJECTS % 8) == 0)
 #define EOS_MAX_TASK_OCCUPY                 (EOS_MAX_OBJECTS >> 3)
 #else
@@ -88,34 +102,34 @@ enum
 
 typedef struct eos_owner
 {
-    eos_u8_t data[EOS_MAX_OWNER];
+    eos_u32_t data[EOS_MAX_OWNER];
 } eos_owner_t;
 
-typedef struct eos_heap_block
-{
-    struct eos_heap_block *next;
-    eos_u32_t is_free                           : 1;
-    eos_u32_t size                              : 31;
-} eos_heap_block_t;
-
-typedef struct eos_heap_tag
-{
-    eos_u8_t *data;
-    eos_heap_block_t *list;
-    eos_u32_t size                              : 24;
-    eos_u32_t error_id                          : 8;
-} eos_heap_t;
-
+/* One pending delivery of one event to one task. */
 typedef struct eos_event_data
 {
     struct eos_event_data *next;
-    struct eos_event_data *last;
-    eos_owner_t e_owner;
     eos_u32_t time;
     eos_u16_t id;
-    eos_u8_t type;
 } eos_event_data_t;
 
+/* The free block of the event record pool. */
+typedef union eos_event_block
+{
+    union eos_event_block *next;
+    eos_event_data_t data;
+} eos_event_block_t;
+
+/* All event records have the same size, so they are applied from the fixed
+   block pool first in O(1), and only from the heap when the pool is used up. */
+typedef struct eos_event_pool
+{
+    eos_event_block_t *free;
+    eos_u16_t used;
+    eos_u16_t peak;
+    eos_u32_t exhausted;
+} eos_event_pool_t;
+
 enum
 {
     Stream_OK                       = 0,
@@ -125,25 +139,57 @@ enum
     Stream_MemCovered               = -4,
 };
 
+/* The ring buffer of the stream key. The head and the tail are the running
+   counters in the range [0, 2 * capacity), so the full and the empty stream
+   are told apart without a flag, and the wrap-around is a subtraction. */
 typedef struct eos_stream
 {
-    void *data;
-    eos_u32_t head;
-    eos_u32_t tail;
-    bool empty;
-
+    eos_u8_t *data;
+    eos_u32_t head;                             /* The write counter */
+    eos_u32_t tail;                             /* The read counter */
     eos_u32_t capacity;
+    eos_u32_t mask;                             /* capacity - 1 if power of 2 */
 } eos_stream_t;
 
+/* The frame of the multi-buffer value key, followed by its buffers. Each buffer
+   has the count of the readers pinning it, or is marked as written by a writer.
+   The current buffer is the latest published one, and is never written. The
+   writes finding no back buffer are dropped and counted. */
+#define EOS_DB_FRAME_WRITING            (0xffU)
+#define EOS_DB_FRAME_HEAD_SIZE          ((sizeof(eos_db_frame_t) + 7U) & ~7U)
+
+typedef struct eos_db_frame
+{
+    eos_u32_t stride;                           /* The buffer size, aligned */
+    eos_u32_t drop;                             /* The dropped writes */
+    eos_u8_t current;
+    eos_u8_t pin[EOS_DB_VALUE_BUFFERS];
+} eos_db_frame_t;
+
+#if (EOS_USE_DB_DELTA != 0)
+/* The change record of the change-only value key, following its buffers. The
+   count is increased by each write which changes the value, and each 4-byte
+   word has the low 16 bits of the count when it changed last. */
+typedef struct eos_db_delta
+{
+    eos_u32_t count;
+    eos_u16_t stamp[];
+} eos_db_delta_t;
+
+#define EOS_DB_DELTA_SIZE(size)                                                \
+    (sizeof(eos_db_delta_t) + (((size) + 3U) / 4U) * sizeof(eos_u16_t))
+#else
+#define EOS_DB_DELTA_SIZE(size)         (0U)
+#endif
+
 struct eos_object;
 
 typedef union eos_obj_block
 {
     struct
     {
-        eos_event_data_t *e_item;
         eos_owner_t e_sub;
-        eos_owner_t e_owner;                            /* The event owner */
+        eos_owner_t e_owner;                            /* Tasks holding the pending value/stream event */
     } event;
     struct
     {
@@ -159,24 +205,39 @@ typedef union eos_obj_block
 typedef struct eos_object
 {
     const char *key;                                    /* Key */
+    eos_u32_t hash;                                     /* Hash of the key */
     eos_ocb_t ocb;                                      /* object block */
     eos_u32_t type                   : 8;               /* Object type */
     eos_u32_t attribute              : 8;
     eos_u32_t size                   : 16;              /* Value size */
+    eos_u32_t seq;                                      /* Value sequence */
     union
     {
         void *value;                                    /* for value-event */
         eos_stream_t *stream;                           /* for stream-event */
+        eos_db_frame_t *frame;                          /* for multi-buffer */
     } data;
 } eos_object_t;
 
 typedef struct eos_tag
 {
-    /* Hash table */
+    /* Hash table. The objects keep their index as the ID, and the slots hold
+       the object IDs in the order of Robin Hood probing. The IDs of the deleted
+       objects are counted in object_free, and are reused first. */
     eos_object_t object[EOS_MAX_OBJECTS];
+    eos_u16_t slot[EOS_MAX_OBJECTS];
+    eos_u16_t object_count;
+    eos_u16_t object_free;
+    eos_u16_t probe_max;
     eos_u16_t prime_max;
+    eos_u32_t lookup_count;
+    eos_u32_t lookup_miss;
+    eos_u32_t lookup_probe;
     
     eos_u16_t t_id[EOS_MAX_TASKS];
+    /* The tasks which can receive the events now, neither suspended nor with
+       the event receiving disabled. */
+    eos_owner_t t_recv;
 
     /* Heap */
 #if (EOS_USE_EVENT_DATA != 0)
@@ -184,10 +245,27 @@ typedef struct eos_tag
     eos_u8_t heap_data[EOS_SIZE_HEAP];
 #endif
     eos_heap_t db;
-    eos_event_data_t *e_queue;
+
+    /* The persistent value keys written since the last flush. */
+    const eos_db_persist_t *persist;
+    eos_u32_t db_dirty[(EOS_MAX_OBJECTS + 31) / 32];
+
+    /* Event record pool */
+    eos_event_pool_t e_pool;
+#if (EOS_EVENT_POOL_SIZE != 0)
+    eos_event_block_t e_block[EOS_EVENT_POOL_SIZE];
+#endif
 } eos_t;
 
+#if (EOS_USE_TOPIC_TABLE != 0)
+/* The topics in the manifest are pre-populated in the hash table. */
+eos_t eos =
+{
+    .object = EOS_TOPIC_OBJECT_INIT,
+};
+#else
 eos_t eos;
+#endif
 
 /* data --------------------------------------------------------------------- */
 #if (EOS_USE_SM_MODE != 0)
@@ -225,30 +303,103 @@ static const eos_event_t eos_event_table[Event_User] =
 #endif
 
 /* private hash function ---------------------------------------------------- */
+static char ch_type[EosObj_Max] = { 'A', 'E', 'T' };
+
+#if (EOS_USE_PHASH != 0)
+typedef struct eos_phash_key
+{
+    const char *key;
+    eos_u32_t hash;
+    eos_u8_t type;
+} eos_phash_key_t;
+
+static const eos_u16_t eos_phash_disp[EOS_TOPIC_PHASH_BUCKETS] =
+    EOS_TOPIC_PHASH_DISP_INIT;
+static const eos_phash_key_t eos_phash_key[EOS_TOPIC_NUM] =
+    EOS_TOPIC_PHASH_KEY_INIT;
+
+eos_inline eos_u16_t eos_phash_index(eos_u32_t hash);
+static eos_u16_t eos_phash_get(eos_u8_t obj_type,
+                                eos_u32_t hash, const char *string);
+#endif
+
 static eos_u32_t eos_hash_time33(char ch_type, const char *string);
 static eos_u16_t eos_hash_insert(eos_u8_t obj_type, const char *string);
+static void eos_hash_slot_insert(eos_u16_t id);
+static void eos_hash_delete(eos_u16_t id);
+eos_inline eos_u16_t eos_hash_distance(eos_u16_t id, eos_u16_t index);
 static eos_u16_t eos_hash_get_index(eos_u8_t obj_type, const char *string);
 static bool eos_hash_existed(eos_u8_t obj_type, const char *string);
 
 /* private event functions -------------------------------------------------- */
+void eos_task_receivable_update(eos_task_handle_t task);
 static eos_s8_t eos_event_give_(const char *task,
                                 eos_u32_t task_id,
                                 eos_u8_t give_type,
                                 const char *topic);
-static void eos_e_queue_delete_(eos_event_data_t const *item);
-static inline void eos_event_sub_(eos_task_handle_t const me, const char *topic);
+static eos_s8_t eos_event_give_id_(eos_u16_t t_id, eos_u8_t give_type,
+                                    eos_u16_t e_id);
+static eos_s8_t eos_event_deliver_(eos_u16_t t_id, eos_u8_t give_type,
+                                   eos_u16_t e_id, eos_base_t level);
+static eos_u16_t eos_topic_get_(const char *topic);
+static void eos_event_output_(eos_task_handle_t const task,
+                                eos_event_data_t *e_item,
+                                eos_event_t *const e_out);
+static inline void eos_event_sub_(eos_task_handle_t const me, eos_u16_t e_id);
+
+/* private event pool functions --------------------------------------------- */
+static void eos_event_pool_init(void);
+static inline eos_event_data_t *eos_event_alloc(void);
+static inline void eos_event_free(eos_event_data_t *e_item);
+
+/* private mailbox functions ------------------------------------------------ */
+static inline void eos_mailbox_push(eos_task_handle_t const task,
+                                    eos_event_data_t *e_item);
+static inline eos_event_data_t *eos_mailbox_pop(eos_task_handle_t const task);
 
 /* private actor functions -------------------------------------------------- */
 static void eos_reactor_enter(eos_reactor_t *const me);
 static void eos_sm_enter(eos_sm_t *const me);
 
 /* private database functions ----------------------------------------------- */
-eos_inline void eos_db_write_(eos_u8_t type, const char *key, 
+static eos_u16_t eos_db_key_get_(const char *key);
+static void eos_db_alloc_(eos_u16_t e_id, eos_u32_t size);
+static eos_u16_t eos_db_stream_key_get_(const char *key);
+eos_inline eos_base_t eos_db_lock_(eos_u8_t attribute);
+eos_inline void eos_db_unlock_(eos_u8_t attribute, eos_base_t level);
+eos_inline void eos_db_persist_mark_(eos_u16_t e_id);
+eos_inline bool eos_db_value_write_(eos_u16_t e_id, const void *memory);
+static bool eos_db_change_(eos_u16_t e_id,
+                            eos_u8_t *value, const eos_u8_t *value_new, bool copy);
+#if (EOS_USE_DB_DELTA != 0)
+static eos_db_delta_t *eos_db_delta_get_(eos_u16_t e_id);
+static void eos_db_delta_mask_(eos_u16_t e_id, eos_u32_t *mask, eos_u32_t *version);
+#endif
+eos_inline void eos_db_link_(eos_u16_t e_id, bool changed);
+static void eos_db_snapshot_(const eos_u16_t *e_id,
+                                void *const data[], eos_u32_t count);
+eos_inline void eos_db_value_read_(eos_u16_t e_id, void *memory);
+static eos_u16_t eos_db_frame_key_get_(const char *key);
+eos_inline eos_u8_t *eos_db_frame_buffer_(eos_db_frame_t *frame, eos_u32_t index);
+static eos_u32_t eos_db_frame_index_(eos_db_frame_t *frame, const void *data);
+static void *eos_db_frame_acquire_(eos_u16_t e_id);
+static bool eos_db_frame_publish_(eos_u16_t e_id, void *data);
+eos_inline void *eos_db_value_(eos_u16_t e_id);
+eos_inline void eos_db_write_(eos_u8_t type, eos_u16_t e_id, 
                                 const void *memory, eos_u32_t size);
 eos_inline eos_s32_t eos_db_read_(eos_u8_t type,
-                                    const char *key, 
+                                    eos_u16_t e_id, 
                                     const void *memory, eos_u32_t size);
 
+/* private channel functions ------------------------------------------------ */
+static bool eos_chan_put_(eos_chan_t *const me, const void *data, eos_u32_t size);
+static eos_s32_t eos_chan_get_(eos_chan_t *const me,
+                                void *buffer, eos_u32_t size);
+static eos_s32_t eos_chan_time_left_(eos_s32_t time_ms, eos_u32_t time_start);
+static eos_base_t eos_chan_wait_(eos_u32_t *wait,
+                                    eos_s32_t time_ms, eos_base_t level);
+static void eos_chan_wake_(eos_u32_t *wait);
+
 /* private sm functions ----------------------------------------------------- */
 #if (EOS_USE_SM_MODE != 0)
 static void eos_sm_dispath(eos_sm_t *const me, eos_event_t const * const e);
@@ -259,11 +410,11 @@ static eos_s32_t eos_sm_tran(eos_sm_t *const me,
 #endif
 
 /* private heap functions --------------------------------------------------- */
-#if (EOS_USE_EVENT_DATA != 0)
-static void eos_heap_init(eos_heap_t *const me, void *data, eos_u32_t size);
-static void * eos_heap_malloc(eos_heap_t *const me, eos_u32_t size);
-static void eos_heap_free(eos_heap_t *const me, void * data);
-#endif
+static eos_s32_t eos_heap_fls(eos_u32_t word);
+static void eos_heap_mapping(eos_heap_ctrl_t *ctrl,
+                                eos_u32_t size, eos_u32_t *fl, eos_u32_t *sl);
+static void eos_heap_insert(eos_heap_ctrl_t *ctrl, eos_heap_block_t *block);
+static void eos_heap_remove(eos_heap_ctrl_t *ctrl, eos_heap_block_t *block);
 
 /* private stream functions ------------------------------------------------- */
 static eos_s32_t eos_stream_init(eos_stream_t *const me,
@@ -272,30 +423,38 @@ static eos_s32_t eos_stream_push(eos_stream_t *me, void * data, eos_u32_t size);
 static eos_s32_t eos_stream_pull_pop(eos_stream_t *me,
                                         void * data, eos_u32_t size);
 static bool eos_stream_full(eos_stream_t *me);
-static eos_s32_t eos_stream_size(eos_stream_t *me);
-static eos_s32_t eos_stream_empty_size(eos_stream_t *me);
+static eos_u32_t eos_stream_size(eos_stream_t *me);
+static eos_u32_t eos_stream_empty_size(eos_stream_t *me);
+static eos_u32_t eos_stream_reserve(eos_stream_t *me, void **buffer);
+static void eos_stream_commit(eos_stream_t *me, eos_u32_t size);
+static eos_u32_t eos_stream_peek(eos_stream_t *me, void **buffer);
+static void eos_stream_consume(eos_stream_t *me, eos_u32_t size);
 
 /* private owner functions -------------------------------------------------- */
 static inline bool owner_is_occupied(eos_owner_t *owner, eos_u32_t t_id);
 static inline void owner_or(eos_owner_t *g_owner, eos_owner_t *owner);
+static inline bool owner_and(eos_owner_t *g_owner, eos_owner_t *owner);
 static inline void owner_set_bit(eos_owner_t *owner, eos_u32_t t_id, bool status);
 static inline bool owner_all_cleared(eos_owner_t *owner);
+static inline eos_u32_t owner_pop(eos_owner_t *owner);
 
 /* extern functions --------------------------------------------------------- */
 extern void eos_kernel_init(void);
+extern int __eos_ffs(int value);
 
 /* public functions --------------------------------------------------------- */
 void eos_init(void)
 {
-    eos.e_queue = EOS_NULL;
     for (eos_u16_t i = 0; i < EOS_MAX_TASKS; i++)
     {
         eos.t_id[i] = EOS_MAX_OBJECTS;
     }
+    memset(&eos.t_recv, 0, sizeof(eos_owner_t));
 
 #if (EOS_USE_EVENT_DATA != 0)
     eos_heap_init(&eos.heap, eos.heap_data, EOS_SIZE_HEAP);
 #endif
+    eos_event_pool_init();
 
     /* Find the maximum prime in the range of EOS_MAX_OBJECTS. */
     for (eos_s32_t i = EOS_MAX_OBJECTS; i > 0; i --)
@@ -322,9 +481,32 @@ void eos_init(void)
     
     /* Initialize the hash table. */
     for (eos_u32_t i = 0; i < EOS_MAX_OBJECTS; i++)
+    {
+        eos.slot[i] = EOS_MAX_OBJECTS;
+    }
+    eos.probe_max = 0;
+    eos.object_free = 0;
+    eos.lookup_count = 0;
+    eos.lookup_miss = 0;
+    eos.lookup_probe = 0;
+#if (EOS_USE_PHASH != 0)
+    /* The static objects are found by the perfect hash, not in the slots. */
+    eos.object_count = EOS_TOPIC_NUM;
+#elif (EOS_USE_TOPIC_TABLE != 0)
+    /* The objects of the topics are pre-populated in the order of the manifest,
+       and only their slots are filled. */
+    eos.object_count = EOS_TOPIC_NUM;
+    for (eos_u16_t i = 0; i < EOS_TOPIC_NUM; i++)
+    {
+        eos_hash_slot_insert(i);
+    }
+#else
+    eos.object_count = 0;
+    for (eos_u32_t i = 0; i < EOS_MAX_OBJECTS; i++)
     {
         eos.object[i].key = (const char *)0;
     }
+#endif
 
     eos_kernel_init();
     eos_system_timer_init();
@@ -353,6 +535,8 @@ eos_err_t eos_task_init(eos_task_t *task,
     eos.object[t_id].type = EOS_TASK_ATTRIBUTE_TASK;
     eos.object[t_id].ocb.task.tcb = task;
     task->index = EOS_MAX_TASKS;
+    task->e_head = EOS_NULL;
+    task->e_tail = EOS_NULL;
     for (eos_u16_t i = 0; i < EOS_MAX_TASKS; i++)
     {
         if (eos.t_id[i] == EOS_MAX_OBJECTS)
@@ -363,9 +547,12 @@ eos_err_t eos_task_init(eos_task_t *task,
         }
     }
     EOS_ASSERT(task->index != EOS_MAX_TASKS);
+    task->event_recv_disable = false;
+    task->wait_chan = false;
+    owner_set_bit(&eos.t_recv, task->index, true);
     
 #if (EOS_USE_3RD_KERNEL == 0)
-    task->task_handle = (eos_u32_t)(&task->task_);
+    task->task_handle = (eos_pointer_t)(&task->task_);
 #endif
 
     eos_sem_init(&task->sem, 0);
@@ -377,28 +564,6 @@ eos_err_t eos_task_init(eos_task_t *task,
                         priority, EOS_TIMESLICE);
 }
 
-static bool equeue_no_current_task_event(eos_u16_t t_index)
-{
-    bool ret = true;
-
-    if (eos.e_queue != EOS_NULL)
-    {
-        eos_event_data_t *e_item = eos.e_queue;
-        while (e_item != EOS_NULL)
-        {
-            if (!owner_is_occupied(&e_item->e_owner, t_index))
-            {
-                e_item = e_item->next;
-            }
-
-            ret = false;
-            break;
-        }
-    }
-
-    return ret;
-}
-
 eos_err_t eos_task_delay_no_event(eos_u32_t tick)
 {
     eos_task_handle_t task = eos_task_self();
@@ -406,17 +571,34 @@ eos_err_t eos_task_delay_no_event(eos_u32_t tick)
 
     level = eos_hw_interrupt_disable();
     task->event_recv_disable = true;
+    eos_task_receivable_update(task);
     eos_hw_interrupt_enable(level);
 
     eos_task_delay(tick);
 
     level = eos_hw_interrupt_disable();
     task->event_recv_disable = false;
+    eos_task_receivable_update(task);
     eos_hw_interrupt_enable(level);
 
     return EOS_EOK;
 }
 
+/* Called by the kernel when the task is suspended or resumed, and when its
+   event receiving is disabled or enabled. */
+void eos_task_receivable_update(eos_task_handle_t task)
+{
+    register eos_base_t level = eos_hw_interrupt_disable();
+
+    bool receivable = (task->event_recv_disable == false);
+#if (EOS_USE_3RD_KERNEL == 0)
+    receivable = receivable && (eos_task_get_state(task) != EOS_TASK_SUSPEND);
+#endif
+    owner_set_bit(&eos.t_recv, task->index, receivable);
+
+    eos_hw_interrupt_enable(level);
+}
+
 bool eos_task_wait_event(eos_event_t *const e_out, eos_s32_t time_ms)
 {
     eos_task_handle_t task = eos_task_self();
@@ -427,56 +609,21 @@ bool eos_task_wait_event(eos_event_t *const e_out, eos_s32_t time_ms)
 
     if (ret == EOS_EOK)
     {
-        EOS_ASSERT(eos.e_queue != EOS_NULL);
-
-        /* Find the first event data in e-queue and set it as handled. */
-        eos_event_data_t *e_item = eos.e_queue;
-        while (e_item != EOS_NULL)
+        /* Take the first event data out of the task's mailbox. */
+        eos_event_data_t *e_item = eos_mailbox_pop(task);
+        if (e_item != EOS_NULL)
         {
-            if (!owner_is_occupied(&e_item->e_owner, task->index))
+            eos_event_output_(task, e_item, e_out);
+
+            /* The semaphore may count more than the mailbox holds. */
+            if (task->e_head == EOS_NULL)
             {
-                e_item = e_item->next;
+                eos_sem_reset(&task->sem, 0);
             }
-            else
-            {
-                /* Meet one event */
-                eos_object_t *e_object = &eos.object[e_item->id];
-                EOS_ASSERT(e_object->type == EosObj_Event);
-                eos_u8_t type = e_object->attribute & 0x03;
-                /* Event out */
-                e_out->topic = e_object->key;
-                e_out->eid = e_item->id;
-                if (type == EOS_EVENT_ATTRIBUTE_TOPIC)
-                {
-                    e_out->size = 0;
-                }
-                else if (type == EOS_EVENT_ATTRIBUTE_VALUE)
-                {
-                    e_out->size = e_object->size;
-                }
-                else if (type == EOS_EVENT_ATTRIBUTE_STREAM)
-                {
-                    e_out->size = eos_stream_size(e_object->data.stream);
-                }
 
-                /* If the event data is just the current task's event. */
-                owner_set_bit(&e_item->e_owner, task->index, false);
-                if (owner_all_cleared(&e_item->e_owner))
-                {
-                    eos.object[e_item->id].ocb.event.e_item = EOS_NULL;
-                    /* Delete the event data from the e-queue. */
-                    eos_e_queue_delete_(e_item);
-
-                    if (equeue_no_current_task_event(task->index))
-                    {
-                        eos_sem_reset(&task->sem, 0);
-                    }
-                }
-
-                eos_hw_interrupt_enable(level);
+            eos_hw_interrupt_enable(level);
 
-                return true;
-            }
+            return true;
         }
     }
 
@@ -490,86 +637,35 @@ bool eos_task_wait_specific_event(eos_event_t *const e_out,
                                     const char *topic, eos_s32_t time_ms)
 {
     eos_task_handle_t task = eos_task_self();
-    while (1)
-    {
-        eos_err_t ret = eos_sem_take(&task->sem, time_ms);
-        
-        register eos_base_t level = eos_hw_interrupt_disable();
+    eos_err_t ret = eos_sem_take(&task->sem, time_ms);
+    
+    register eos_base_t level = eos_hw_interrupt_disable();
 
-        if (ret == EOS_EOK)
+    if (ret == EOS_EOK)
+    {
+        /* Events in front of the specific one are handled as discarded. */
+        eos_event_data_t *e_item;
+        while ((e_item = eos_mailbox_pop(task)) != EOS_NULL)
         {
-            EOS_ASSERT(eos.e_queue != EOS_NULL);
-            /* Find the first event data in e-queue and set it as handled. */
-            eos_event_data_t *e_item = eos.e_queue;
-            while (e_item != EOS_NULL)
-            {
-                if (!owner_is_occupied(&e_item->e_owner, task->index))
-                {
-                    e_item = e_item->next;
-                }
-                else
-                {
-                    bool correct_event = false;
-
-                    /* Meet one event */
-                    eos_object_t *e_object = &eos.object[e_item->id];
-                    EOS_ASSERT(e_object->type == EosObj_Event);
-                    if (strcmp(e_object->key, topic) == 0)
-                    {
-                        correct_event = true;
-                    }
-
-                    if (correct_event)
-                    {
-                        eos_u8_t type = e_object->attribute & 0x03;
-                        /* Event out */
-                        e_out->topic = e_object->key;
-                        e_out->eid = e_item->id;
-                        if (type == EOS_EVENT_ATTRIBUTE_TOPIC)
-                        {
-                            e_out->size = 0;
-                        }
-                        else if (type == EOS_EVENT_ATTRIBUTE_VALUE)
-                        {
-                            e_out->size = e_object->size;
-                        }
-                        else if (type == EOS_EVENT_ATTRIBUTE_STREAM)
-                        {
-                            e_out->size = eos_stream_size(e_object->data.stream);
-                        }
-                    }
+            bool correct_event =
+                (strcmp(eos.object[e_item->id].key, topic) == 0) ? true : false;
+            eos_event_output_(task, e_item, correct_event ? e_out : EOS_NULL);
 
-                    /* If the event data is just the current task's event. */
-                    owner_set_bit(&e_item->e_owner, task->index, false);
-                    if (owner_all_cleared(&e_item->e_owner))
-                    {
-                        eos.object[e_item->id].ocb.event.e_item = EOS_NULL;
-                        /* Delete the event data from the e-queue. */
-                        eos_e_queue_delete_(e_item);
-
-                        if (equeue_no_current_task_event(task->index))
-                        {
-                            eos_sem_reset(&task->sem, 0);
-                        }
-                    }
+            if (task->e_head == EOS_NULL)
+            {
+                eos_sem_reset(&task->sem, 0);
+            }
 
-                    if (correct_event)
-                    {
-                        eos_hw_interrupt_enable(level);
-                        return true;
-                    }
-                    else
-                    {
-                        continue;
-                    }
-                }
+            if (correct_event)
+            {
+                eos_hw_interrupt_enable(level);
+                return true;
             }
         }
-
-        eos_hw_interrupt_enable(level);
-        break;
     }
 
+    eos_hw_interrupt_enable(level);
+
     return false;
 }
 
@@ -652,45 +748,43 @@ static void eos_task_function(void *parameter)
     }
 }
 
-static void eos_e_queue_delete_(eos_event_data_t const *item)
+/* Export the event data to the receiver and free it. It must be called between
+   eos_hw_interrupt_disable and eos_hw_interrupt_enable. */
+static void eos_event_output_(eos_task_handle_t const task,
+                                eos_event_data_t *e_item,
+                                eos_event_t *const e_out)
 {
-    /* parameter check */
-    EOS_ASSERT(eos.e_queue != EOS_NULL);
-    EOS_ASSERT(item != EOS_NULL);
+    eos_object_t *e_object = &eos.object[e_item->id];
+    EOS_ASSERT(e_object->type == EosObj_Event);
+    eos_u8_t type = e_object->attribute & EOS_EVENT_ATTRIBUTE_MASK;
 
-    /* disable interrupt */
-    register eos_base_t level = eos_hw_interrupt_disable();
-    
-    /* If the event data is only one in queue. */
-    if (item->last == EOS_NULL && item->next == EOS_NULL)
+    /* Event out */
+    if (e_out != EOS_NULL)
     {
-        EOS_ASSERT(eos.e_queue == item);
-        eos.e_queue = EOS_NULL;
-    }
-    /* If the event data is the first one in queue. */
-    else if (item->last == EOS_NULL && item->next != EOS_NULL)
-    {
-        EOS_ASSERT(eos.e_queue == item);
-        item->next->last = EOS_NULL;
-        eos.e_queue = item->next;
-    }
-    /* If the event item is the last one in queue. */
-    else if (item->last != EOS_NULL && item->next == EOS_NULL)
-    {
-        item->last->next = EOS_NULL;
+        e_out->topic = e_object->key;
+        e_out->eid = e_item->id;
+        if (type == EOS_EVENT_ATTRIBUTE_TOPIC)
+        {
+            e_out->size = 0;
+        }
+        else if (type == EOS_EVENT_ATTRIBUTE_VALUE)
+        {
+            e_out->size = e_object->size;
+        }
+        else if (type == EOS_EVENT_ATTRIBUTE_STREAM)
+        {
+            e_out->size = eos_stream_size(e_object->data.stream);
+        }
     }
-    /* If the event item is in the middle position of the queue. */
-    else
+
+    /* The value or stream event can be given to the task again. */
+    if (type != EOS_EVENT_ATTRIBUTE_TOPIC)
     {
-        item->last->next = item->next;
-        item->next->last = item->last;
+        owner_set_bit(&e_object->ocb.event.e_owner, task->index, false);
     }
-    
-    /* free the event data. */
-    eos_heap_free(&eos.heap, (void *)item);
 
-    /* enable interrupt */
-    eos_hw_interrupt_enable(level);
+    /* free the event data. */
+    eos_event_free(e_item);
 }
 
 /* Reactor ------------------------------------------------------------------ */
@@ -818,17 +912,12 @@ static eos_s8_t eos_event_give_(const char *task, eos_u32_t task_id,
                                 eos_u8_t give_type,
                                 const char *topic)
 {
-    eos_s8_t ret = 0;
-    eos_sem_handle_t sem = EOS_NULL;
     register eos_base_t level;
-    eos_u16_t e_id;
-    eos_u8_t e_type;
+    eos_u16_t t_id = EOS_MAX_OBJECTS;
     
     level = eos_hw_interrupt_disable();
 
     /* Get the task id in the object hash table. */
-    eos_u16_t t_id;
-    eos_task_handle_t tcb;
     if (give_type == EosEventGiveType_Send)
     {
         EOS_ASSERT((task != EOS_NULL && task_id == EOS_MAX_OBJECTS) ||
@@ -844,12 +933,6 @@ static eos_s8_t eos_event_give_(const char *task, eos_u32_t task_id,
         {
             t_id = task_id;
         }
-        
-        tcb = eos.object[t_id].ocb.task.tcb;
-        if (tcb->event_recv_disable == true)
-        {
-            goto exit;
-        }
     }
     else if (give_type == EosEventGiveType_Publish)
     {
@@ -861,21 +944,47 @@ static eos_s8_t eos_event_give_(const char *task, eos_u32_t task_id,
     }
     
     /* Get event id according to the event topic. */
-    e_id = eos_hash_get_index(EosObj_Event, topic);
-    if (e_id == EOS_MAX_OBJECTS)
-    {
-        /* Newly create one event in the hash table. */
-        e_id = eos_hash_insert(EosObj_Event, topic);
-        eos.object[e_id].type = EosObj_Event;
-        eos.object[e_id].attribute &= (~0x03);
-        e_type = EOS_EVENT_ATTRIBUTE_TOPIC;
-    }
-    else
+    eos_u16_t e_id = eos_topic_get_(topic);
+
+    /* The event is given in the same critical section as the lookup, so the
+       task and the topic can not be deleted in between. */
+    return eos_event_deliver_(t_id, give_type, e_id, level);
+}
+
+/* Give the event whose task and topic are both resolved into object ids. */
+static eos_s8_t eos_event_give_id_(eos_u16_t t_id, eos_u8_t give_type,
+                                    eos_u16_t e_id)
+{
+    EOS_ASSERT(e_id < EOS_MAX_OBJECTS);
+
+    register eos_base_t level = eos_hw_interrupt_disable();
+
+    return eos_event_deliver_(t_id, give_type, e_id, level);
+}
+
+/* Give the event with the interrupt disabled by level, which is enabled again
+   before the return. */
+static eos_s8_t eos_event_deliver_(eos_u16_t t_id, eos_u8_t give_type,
+                                   eos_u16_t e_id, eos_base_t level)
+{
+    eos_s8_t ret = 0;
+    eos_task_handle_t tcb = EOS_NULL;
+
+    if (give_type == EosEventGiveType_Send)
     {
-        /* Get the type of the event. */
-        e_type = eos.object[e_id].attribute & 0x03;
-        EOS_ASSERT(eos.object[e_id].type == EosObj_Event);
+        EOS_ASSERT(t_id < EOS_MAX_OBJECTS);
+        EOS_ASSERT(eos.object[t_id].type == EosObj_Actor);
+
+        tcb = eos.object[t_id].ocb.task.tcb;
+        if (tcb->event_recv_disable == true)
+        {
+            goto exit;
+        }
     }
+
+    /* Get the type of the event. */
+    EOS_ASSERT(eos.object[e_id].type == EosObj_Event);
+    eos_u8_t e_type = eos.object[e_id].attribute & EOS_EVENT_ATTRIBUTE_MASK;
     
     eos_owner_t g_owner;
     memset(&g_owner, 0, sizeof(eos_owner_t));
@@ -886,181 +995,92 @@ static eos_s8_t eos_event_give_(const char *task, eos_u32_t task_id,
         /* If the current task is waiting for a specific event, but not the
            current event. */
         if (tcb->wait_specific_event == true &&
-            strcmp(topic, tcb->event_wait) != 0)
-        {
-            goto exit;
-        }
-        if (eos_task_get_state(tcb) == EOS_TASK_SUSPEND)
+            strcmp(eos.object[e_id].key, tcb->event_wait) != 0)
         {
             goto exit;
         }
-        if (tcb->event_recv_disable == true)
+        /* The suspended task does not receive any event. */
+        if (!owner_is_occupied(&eos.t_recv, tcb->index))
         {
             goto exit;
         }
-        g_owner.data[tcb->index / 8] = (1 << (tcb->index % 8));
+        owner_set_bit(&g_owner, tcb->index, true);
     }
     /* The publish-type event. */
     else if (give_type == EosEventGiveType_Publish)
     {
+        /* The subscribers which can receive the events now. */
         memcpy(&g_owner, &eos.object[e_id].ocb.event.e_sub, sizeof(eos_owner_t));
+        if (owner_and(&g_owner, &eos.t_recv) == false)
+        {
+            goto exit;
+        }
+    }
 
-        /* The suspended task does not receive any event. */
-        for (eos_u16_t i = 0; i < EOS_MAX_TASKS; i++)
+    /* Put one event data into the mailbox of every receiver. */
+    eos_owner_t recv = g_owner;
+    for (eos_u32_t i = owner_pop(&recv); i != EOS_MAX_TASKS; i = owner_pop(&recv))
+    {
+        /* The value or stream event is pending in the task's mailbox once. */
+        if (e_type == EOS_EVENT_ATTRIBUTE_VALUE ||
+            e_type == EOS_EVENT_ATTRIBUTE_STREAM)
         {
-            if (eos.t_id[i] != EOS_MAX_OBJECTS)
+            eos_owner_t *e_owner = &eos.object[e_id].ocb.event.e_owner;
+            if (owner_is_occupied(e_owner, i))
             {
-                eos_u16_t _t_id = eos.t_id[i];
-                eos_object_t *obj = &eos.object[_t_id];
-
-                if (obj->ocb.task.tcb->event_recv_disable == true)
-                {
-                    owner_set_bit(&g_owner, i, false);
-                }
-                if (eos_task_get_state(obj->ocb.task.tcb) == EOS_TASK_SUSPEND)
-                {
-                    owner_set_bit(&g_owner, i, false);
-                }
+                owner_set_bit(&g_owner, i, false);
+                continue;
             }
+            owner_set_bit(e_owner, i, true);
         }
-        
-        if (owner_all_cleared(&g_owner) == true)
+        else
         {
-            goto exit;
+            EOS_ASSERT(e_type == EOS_EVENT_ATTRIBUTE_TOPIC);
         }
-    }
 
-    /* If the event type is topic-type. */
-    if (e_type == EOS_EVENT_ATTRIBUTE_TOPIC)
-    {
-        eos_event_data_t *data
-            = eos_heap_malloc(&eos.heap, sizeof(eos_event_data_t));
-        EOS_ASSERT(data != EOS_NULL);
+        eos_event_data_t *data = eos_event_alloc();
+        EOS_ASSERT_NAME(data != EOS_NULL, eos.object[e_id].key);
         data->id = e_id;
-        memset(&data->e_owner, 0, sizeof(eos_owner_t));
-        owner_or(&data->e_owner, &g_owner);
         data->time = eos_tick_get_ms();
+        eos_mailbox_push(eos.object[eos.t_id[i]].ocb.task.tcb, data);
+    }
+
+    /* Wake the receivers which are not waiting for another specific event. The
+       scheduler is locked during the releases, so the scheduling is done once
+       after all of them, not after each one. */
+    bool in_isr = (eos_interrupt_get_nest() != 0) ? true : false;
+    eos_enter_critical();
+    for (eos_u32_t i = owner_pop(&g_owner); i != EOS_MAX_TASKS; i = owner_pop(&g_owner))
+    {
+        eos_task_handle_t task = eos.object[eos.t_id[i]].ocb.task.tcb;
 
-        /* Attach the event data to the event queue. */
-        if (eos.e_queue == EOS_NULL)
+        if (!in_isr && task == eos_task_self())
         {
-            eos.e_queue = data;
-            data->next = EOS_NULL;
-            data->last = EOS_NULL;
+            continue;
         }
-        else
+        if (task->wait_specific_event &&
+            strcmp(eos.object[e_id].key, task->event_wait) != 0)
         {
-            eos_event_data_t *edata = eos.e_queue;
-            while (edata->next != EOS_NULL)
-            {
-                edata = edata->next;
-            }
-            data->next = EOS_NULL;
-            edata->next = data;
-            data->last = edata;
-        }
-    }
-    /* If the event is value-type or stream-type. */
-    else if (e_type == EOS_EVENT_ATTRIBUTE_VALUE ||
-             e_type == EOS_EVENT_ATTRIBUTE_STREAM)
-    {
-        if (eos.object[e_id].ocb.event.e_item == EOS_NULL)
-        {
-            eos_event_data_t *data;
-
-            /* Apply one data for the event. */
-            data = eos_heap_malloc(&eos.heap, sizeof(eos_event_data_t));
-            EOS_ASSERT_NAME(data != EOS_NULL, topic);
-            memset(&data->e_owner, 0, sizeof(eos_owner_t));
-            owner_or(&data->e_owner, &g_owner);
-            data->id = e_id;
-            data->time = eos_tick_get_ms();
-            eos.object[e_id].ocb.event.e_item = data;
-            
-            /* Attach the event data to the event queue. */
-            if (eos.e_queue == EOS_NULL)
-            {
-                eos.e_queue = data;
-                data->next = EOS_NULL;
-                data->last = EOS_NULL;
-            }
-            else
-            {
-                eos_event_data_t *edata = eos.e_queue;
-                while (edata->next != EOS_NULL)
-                {
-                    edata = edata->next;
-                }
-                data->next = EOS_NULL;
-                edata->next = data;
-                data->last = edata;
-            }
+            continue;
         }
-        else
+        /* The task waiting for a channel gets the event after the wait. */
+        if (task->wait_chan)
         {
-            owner_or(&eos.object[e_id].ocb.event.e_item->e_owner, &g_owner);
-            eos.object[e_id].ocb.event.e_item->time = eos_tick_get_ms();
+            continue;
         }
-    }
-    /* Event has no other type. */
-    else
-    {
-        EOS_ASSERT(0);
-    }
 
-    /* Check if the related tasks are waiting for the specific event or not. */
-    for (eos_u16_t i = 0; i < EOS_MAX_TASKS; i++)
-    {
-        if (eos.t_id[i] != EOS_MAX_OBJECTS)
+        eos_sem_release(&task->sem);
+        if (!in_isr)
         {
-            eos_u16_t _t_id = eos.t_id[i];
-            eos_object_t *obj = &eos.object[_t_id];
-
-            if (eos_interrupt_get_nest() == 0)
-            {
-                if (owner_is_occupied(&g_owner, obj->ocb.task.tcb->index) &&
-                    obj->ocb.task.tcb != eos_task_self())
-                {
-                    if (!obj->ocb.task.tcb->wait_specific_event)
-                    {
-                        sem = &obj->ocb.task.tcb->sem;
-                        eos_sem_release(sem);
-                        eos_hw_interrupt_enable(level);
-                        level = eos_hw_interrupt_disable();
-                    }
-                    else
-                    {
-                        if (strcmp(topic, obj->ocb.task.tcb->event_wait) == 0)
-                        {
-                            sem = &obj->ocb.task.tcb->sem;
-                            eos_sem_release(sem);
-                            eos_hw_interrupt_enable(level);
-                            level = eos_hw_interrupt_disable();
-                        }
-                    }
-                }
-            }
-            else
-            {
-                if (owner_is_occupied(&g_owner, obj->ocb.task.tcb->index))
-                {
-                    if (!obj->ocb.task.tcb->wait_specific_event)
-                    {
-                        sem = &obj->ocb.task.tcb->sem;
-                        eos_sem_release(sem);
-                    }
-                    else
-                    {
-                        if (strcmp(topic, obj->ocb.task.tcb->event_wait) == 0)
-                        {
-                            sem = &obj->ocb.task.tcb->sem;
-                            eos_sem_release(sem);
-                        }
-                    }
-                }
-            }
+            /* Leave a window to the interrupts between the releases. */
+            eos_hw_interrupt_enable(level);
+            level = eos_hw_interrupt_disable();
         }
     }
+    eos_hw_interrupt_enable(level);
+    eos_exit_critical();
+
+    return ret;
 
 exit:
     eos_hw_interrupt_enable(level);
@@ -1068,15 +1088,47 @@ exit:
     return ret;
 }
 
-eos_u32_t eos_get_task_id(const char *task)
+/* Get the event id of the topic. The topic-type event is newly created if the
+   topic does not exist. It must be called between eos_hw_interrupt_disable and
+   eos_hw_interrupt_enable. */
+static eos_u16_t eos_topic_get_(const char *topic)
 {
-    eos_u16_t t_id = eos_hash_get_index(EosObj_Actor, task);
-    EOS_ASSERT_NAME(t_id != EOS_MAX_OBJECTS, task);
-    EOS_ASSERT(eos.object[t_id].type == EosObj_Actor);
-
-    return t_id;
-}
-
+    eos_u16_t e_id = eos_hash_get_index(EosObj_Event, topic);
+    if (e_id == EOS_MAX_OBJECTS)
+    {
+        /* Newly create one event in the hash table. */
+        e_id = eos_hash_insert(EosObj_Event, topic);
+        eos.object[e_id].type = EosObj_Event;
+        eos.object[e_id].attribute &= (~EOS_EVENT_ATTRIBUTE_MASK);
+    }
+    else
+    {
+        EOS_ASSERT(eos.object[e_id].type == EosObj_Event);
+    }
+
+    return e_id;
+}
+
+eos_topic_handle_t eos_topic_handle(const char *topic)
+{
+    register eos_base_t level = eos_hw_interrupt_disable();
+    eos_u16_t e_id = eos_topic_get_(topic);
+    eos_hw_interrupt_enable(level);
+
+    return (eos_topic_handle_t)e_id;
+}
+
+eos_u32_t eos_get_task_id(const char *task)
+{
+    register eos_base_t level = eos_hw_interrupt_disable();
+    eos_u16_t t_id = eos_hash_get_index(EosObj_Actor, task);
+    EOS_ASSERT_NAME(t_id != EOS_MAX_OBJECTS, task);
+    EOS_ASSERT(eos.object[t_id].type == EosObj_Actor);
+    eos_hw_interrupt_enable(level);
+
+    return t_id;
+}
+
 void eos_event_send(const char *task, const char *topic)
 {
     eos_event_give_(task, EOS_MAX_OBJECTS, EosEventGiveType_Send, topic);
@@ -1092,39 +1144,43 @@ void eos_event_publish(const char *topic)
     eos_event_give_(EOS_NULL, EOS_MAX_OBJECTS, EosEventGiveType_Publish, topic);
 }
 
-static inline void eos_event_sub_(eos_task_handle_t const me, const char *topic)
+void eos_event_send_h(eos_u32_t task_id, eos_topic_handle_t topic)
+{
+    eos_event_give_id_(task_id, EosEventGiveType_Send, topic);
+}
+
+void eos_event_publish_h(eos_topic_handle_t topic)
+{
+    eos_event_give_id_(EOS_MAX_OBJECTS, EosEventGiveType_Publish, topic);
+}
+
+static inline void eos_event_sub_(eos_task_handle_t const me, eos_u16_t e_id)
 {
+    EOS_ASSERT(e_id < EOS_MAX_OBJECTS);
+
     register eos_base_t level = eos_hw_interrupt_disable();
 
-    /* Find the object by the event topic. */
-    eos_u16_t index;
-    index = eos_hash_get_index(EosObj_Event, topic);
-    if (index == EOS_MAX_OBJECTS)
-    {
-        index = eos_hash_insert(EosObj_Event, topic);
-        eos.object[index].type = EosObj_Event;
-        eos.object[index].attribute &=~ EOS_EVENT_ATTRIBUTE_MASK;
-    }
-    else
-    {
-        EOS_ASSERT(eos.object[index].type == EosObj_Event);
+    EOS_ASSERT(eos.object[e_id].type == EosObj_Event);
 
-        /* The stream event can only be subscribed by one task. */
-        eos_u8_t e_type = eos.object[index].attribute & 0x03;
-        if (e_type == EOS_EVENT_ATTRIBUTE_STREAM)
-        {
-            EOS_ASSERT(owner_all_cleared(&eos.object[index].ocb.event.e_sub));
-        }
+    /* The stream event can only be subscribed by one task. */
+    eos_u8_t e_type = eos.object[e_id].attribute & EOS_EVENT_ATTRIBUTE_MASK;
+    if (e_type == EOS_EVENT_ATTRIBUTE_STREAM)
+    {
+        EOS_ASSERT(owner_all_cleared(&eos.object[e_id].ocb.event.e_sub));
     }
 
     /* Write the subscribing information into the object data. */
-    owner_set_bit(&eos.object[index].ocb.event.e_sub,
-                    eos_task_self()->index, true);
+    owner_set_bit(&eos.object[e_id].ocb.event.e_sub, me->index, true);
 
     eos_hw_interrupt_enable(level);
 }
 
 void eos_event_sub(const char *topic)
+{
+    eos_event_sub_(eos_task_self(), eos_topic_handle(topic));
+}
+
+void eos_event_sub_h(eos_topic_handle_t topic)
 {
     eos_event_sub_(eos_task_self(), topic);
 }
@@ -1254,16 +1310,34 @@ void eos_event_send_period(const char *task,
 
 void eos_event_time_cancel(const char *topic)
 {
+    register eos_base_t level = eos_hw_interrupt_disable();
+
     /* Timer ID */
     eos_u16_t tim_id = eos_hash_get_index(EosObj_Timer, topic);
     EOS_ASSERT(tim_id != EOS_MAX_OBJECTS);
 
-    /* Initialize the timer. */
-    eos_timer_t *timer = &eos.object[tim_id].ocb.timer.timer;
-    eos.object[tim_id].key = EOS_NULL;
-    eos_timer_stop(timer);
+    /* The timer is detached from the kernel before its object is reused. */
+    eos_timer_detach(&eos.object[tim_id].ocb.timer.timer);
+    eos_hash_delete(tim_id);
+
+    eos_hw_interrupt_enable(level);
+}
+
+#ifdef EOS_USING_TIMER_SLACK
+void eos_event_time_slack(const char *topic, eos_u32_t slack_ms)
+{
+    register eos_base_t level = eos_hw_interrupt_disable();
+
+    /* Timer ID */
+    eos_u16_t tim_id = eos_hash_get_index(EosObj_Timer, topic);
+    EOS_ASSERT(tim_id != EOS_MAX_OBJECTS);
+
+    eos_timer_set_slack(&eos.object[tim_id].ocb.timer.timer, slack_ms);
+
+    eos_hw_interrupt_enable(level);
 }
 #endif
+#endif
 
 bool eos_event_topic(eos_event_t const * const e, const char *topic)
 {
@@ -1277,12 +1351,133 @@ bool eos_event_topic(eos_event_t const * const e, const char *topic)
     }
 }
 
+void eos_event_pool_stat(eos_event_pool_stat_t *stat)
+{
+    EOS_ASSERT(stat != EOS_NULL);
+
+    register eos_base_t level = eos_hw_interrupt_disable();
+    stat->total = EOS_EVENT_POOL_SIZE;
+    stat->used = eos.e_pool.used;
+    stat->peak = eos.e_pool.peak;
+    stat->exhausted = eos.e_pool.exhausted;
+    eos_hw_interrupt_enable(level);
+}
+
+void eos_hash_stat(eos_hash_stat_t *stat)
+{
+    EOS_ASSERT(stat != EOS_NULL);
+
+    memset(stat, 0, sizeof(eos_hash_stat_t));
+    stat->total = EOS_MAX_OBJECTS;
+
+    register eos_base_t level = eos_hw_interrupt_disable();
+
+    /* The run wrapping around the end of the slots is joined with the head. */
+    eos_u16_t run = 0, run_head = EOS_MAX_OBJECTS;
+    for (eos_u16_t i = 0; i < EOS_MAX_OBJECTS; i++)
+    {
+        eos_u16_t id = eos.slot[i];
+        if (id == EOS_MAX_OBJECTS)
+        {
+            run_head = (run_head == EOS_MAX_OBJECTS) ? run : run_head;
+            run = 0;
+            continue;
+        }
+        run ++;
+        stat->run_max = (run > stat->run_max) ? run : stat->run_max;
+
+        stat->used ++;
+        if (eos.object[id].type == EosObj_Actor)
+        {
+            stat->actor ++;
+        }
+        else if (eos.object[id].type == EosObj_Event)
+        {
+            stat->event ++;
+        }
+        else
+        {
+            stat->timer ++;
+        }
+
+        eos_u16_t distance = eos_hash_distance(id, i);
+        stat->hist[(distance < EOS_HASH_HIST_SIZE) ?
+                   distance : (EOS_HASH_HIST_SIZE - 1)] ++;
+    }
+    if (run_head != EOS_MAX_OBJECTS)
+    {
+        run += run_head;
+        stat->run_max = (run > stat->run_max) ? run : stat->run_max;
+    }
+#if (EOS_USE_PHASH != 0)
+    /* The static objects are always found in one probe. */
+    for (eos_u16_t i = 0; i < EOS_TOPIC_NUM; i++)
+    {
+        if (eos.object[i].key != (const char *)0)
+        {
+            stat->used ++;
+            stat->actor += (eos.object[i].type == EosObj_Actor) ? 1 : 0;
+            stat->event += (eos.object[i].type == EosObj_Event) ? 1 : 0;
+            stat->timer += (eos.object[i].type == EosObj_Timer) ? 1 : 0;
+            stat->hist[0] ++;
+        }
+    }
+#endif
+    stat->probe_max = eos.probe_max;
+    stat->lookup = eos.lookup_count;
+    stat->miss = eos.lookup_miss;
+    stat->probe = eos.lookup_probe;
+
+    eos_hw_interrupt_enable(level);
+
+    stat->load = (eos_u16_t)((eos_u32_t)stat->used * 100 / stat->total);
+}
+
+void eos_hash_walk(eos_u16_t distance_min,
+                    eos_hash_walker_t walker, void *parameter)
+{
+    EOS_ASSERT(walker != EOS_NULL);
+
+    register eos_base_t level = eos_hw_interrupt_disable();
+
+    for (eos_u16_t i = 0; i < EOS_MAX_OBJECTS; i++)
+    {
+        eos_u16_t id = eos.slot[i];
+        if (id == EOS_MAX_OBJECTS)
+        {
+            continue;
+        }
+
+        eos_u16_t distance = eos_hash_distance(id, i);
+        if (distance >= distance_min)
+        {
+            walker(eos.object[id].key, ch_type[eos.object[id].type],
+                   i, distance, parameter);
+        }
+    }
+
+    eos_hw_interrupt_enable(level);
+}
+
 /* -----------------------------------------------------------------------------
 Database
 ----------------------------------------------------------------------------- */
 void eos_db_init(void *const memory, eos_u32_t size)
 {
     eos_heap_init(&eos.db, memory, size);
+
+#if (EOS_USE_TOPIC_TABLE != 0)
+    /* Apply the memory for the value and stream keys in the topic table. */
+    for (eos_u32_t i = 0; i < EOS_MAX_OBJECTS; i ++)
+    {
+        if (eos.object[i].key != (const char *)0 &&
+            eos.object[i].type == EosObj_Event &&
+            eos.object[i].data.value == EOS_NULL)
+        {
+            eos_db_alloc_(i, eos.object[i].size);
+        }
+    }
+#endif
 }
 
 eos_u8_t eos_db_get_attribute(const char *key)
@@ -1316,6 +1511,20 @@ void eos_db_register(const char *key, eos_u32_t size, eos_u8_t attribute)
     /* Check the argument. */
     eos_u8_t temp8 = EOS_EVENT_ATTRIBUTE_VALUE | EOS_EVENT_ATTRIBUTE_STREAM;
     EOS_ASSERT((attribute & temp8) != temp8);
+    /* Only the stream key can be accessed without the lock. */
+    EOS_ASSERT((attribute & EOS_DB_ATTRIBUTE_SPSC) == 0 ||
+               (attribute & EOS_DB_ATTRIBUTE_STREAM) != 0);
+    /* Only the value key can be persistent or multi-buffer. */
+    EOS_ASSERT((attribute & EOS_DB_ATTRIBUTE_PERSISTENT) == 0 ||
+               (attribute & EOS_DB_ATTRIBUTE_VALUE) != 0);
+    EOS_ASSERT((attribute & EOS_DB_ATTRIBUTE_MULTI_BUFFER) == 0 ||
+               (attribute & EOS_DB_ATTRIBUTE_VALUE) != 0);
+    EOS_ASSERT((attribute & EOS_DB_ATTRIBUTE_CHANGE_ONLY) == 0 ||
+               (attribute & EOS_DB_ATTRIBUTE_VALUE) != 0);
+    /* The persistent key must fit in the storage. */
+    EOS_ASSERT((attribute & EOS_DB_ATTRIBUTE_PERSISTENT) == 0 ||
+               (size <= 0xffff &&
+                (eos.persist == EOS_NULL || size <= eos.persist->size_max)));
 
     /* Check the event key's attribute. */
     register eos_base_t level = eos_hw_interrupt_disable();
@@ -1332,172 +1541,1151 @@ void eos_db_register(const char *key, eos_u32_t size, eos_u8_t attribute)
 
     /* Apply the the memory for event. */
     eos.object[e_id].attribute = attribute;
-    if ((attribute & EOS_DB_ATTRIBUTE_VALUE) != 0)
+    memset(&eos.object[e_id].ocb.event.e_owner, 0, sizeof(eos_owner_t));
+    if (eos.object[e_id].data.value != EOS_NULL)
     {
-        /* Apply a memory for the db key. */
-        void *data = eos_heap_malloc(&eos.db, size);
-        EOS_ASSERT(data != EOS_NULL);
-
-        eos.object[e_id].data.value = data;
-        eos.object[e_id].size = size;
+        /* The key is pre-populated by the topic table, and its memory has been
+           applied in eos_db_init. */
+        EOS_ASSERT(eos.object[e_id].size == size);
     }
-    else if ((attribute & EOS_DB_ATTRIBUTE_STREAM) != 0)
+    else
     {
-        /* Apply a memory for the db key. */
-        void *data = eos_heap_malloc(&eos.db, (size + sizeof(eos_stream_t)));
-        EOS_ASSERT(data != EOS_NULL);
-
-        eos.object[e_id].data.stream = (eos_stream_t *)data;
-        eos.object[e_id].size = size;
-
-        eos_stream_init(eos.object[e_id].data.stream,
-                        (void *)((eos_u32_t)data + sizeof(eos_stream_t)),
-                        eos.object[e_id].size);
-
-        eos_owner_t *e_sub = &eos.object[e_id].ocb.event.e_sub;
-        memset(e_sub, 0, sizeof(eos_owner_t));
+        eos_db_alloc_(e_id, size);
     }
 
     eos_hw_interrupt_enable(level);
+
+    /* Restore the latest value of the persistent key. */
+    if ((attribute & EOS_DB_ATTRIBUTE_PERSISTENT) != 0 &&
+        eos.persist != EOS_NULL && eos.persist->load != EOS_NULL)
+    {
+        eos.persist->load(key, eos_db_value_(e_id), size);
+    }
 }
 
 void eos_db_block_read(const char *key, void * const data)
 {
-    eos_db_read_(EOS_DB_ATTRIBUTE_VALUE, key, data, 0);
+    eos_db_read_(EOS_DB_ATTRIBUTE_VALUE, eos_db_key_get_(key), data, 0);
 }
 
 void eos_db_block_write(const char *key, void * const data)
+{
+    eos_db_write_(EOS_DB_ATTRIBUTE_VALUE, eos_db_key_get_(key), data, 0);
+}
+
+void eos_db_block_read_h(eos_topic_handle_t key, void * const data)
+{
+    eos_db_read_(EOS_DB_ATTRIBUTE_VALUE, key, data, 0);
+}
+
+void eos_db_block_write_h(eos_topic_handle_t key, void * const data)
 {
     eos_db_write_(EOS_DB_ATTRIBUTE_VALUE, key, data, 0);
 }
 
 eos_s32_t eos_db_stream_read(const char *key, void *const buffer, eos_u32_t size)
 {
-    return eos_db_read_(EOS_DB_ATTRIBUTE_STREAM, key, buffer, size);
+    return eos_db_read_(EOS_DB_ATTRIBUTE_STREAM,
+                        eos_db_key_get_(key), buffer, size);
 }
 
 void eos_db_stream_write(const char *key, void *const buffer, eos_u32_t size)
+{
+    eos_db_write_(EOS_DB_ATTRIBUTE_STREAM, eos_db_key_get_(key), buffer, size);
+}
+
+eos_s32_t eos_db_stream_read_h(eos_topic_handle_t key,
+                                void *const buffer, eos_u32_t size)
+{
+    return eos_db_read_(EOS_DB_ATTRIBUTE_STREAM, key, buffer, size);
+}
+
+void eos_db_stream_write_h(eos_topic_handle_t key,
+                            void *const buffer, eos_u32_t size)
 {
     eos_db_write_(EOS_DB_ATTRIBUTE_STREAM, key, buffer, size);
 }
 
-/* private db function ------------------------------------------------------ */
-eos_inline void eos_db_write_(eos_u8_t type, const char *key, 
-                                const void *memory, eos_u32_t size)
+eos_u32_t eos_db_stream_space(const char *key)
 {
-    /* If in interrupt service function, disable the interrupt. */
-    register eos_base_t level = eos_hw_interrupt_disable();
+    return eos_db_stream_space_h(eos_db_stream_key_get_(key));
+}
 
-    /* Get event id according the topic. */
-    eos_u16_t e_id = eos_hash_get_index(EosObj_Event, key);
-    EOS_ASSERT(e_id != EOS_MAX_OBJECTS);
-    EOS_ASSERT(eos.object[e_id].type == EosObj_Event);
-    eos_u8_t attribute = eos.object[e_id].attribute;
-    EOS_ASSERT((attribute & type) != 0);
-    eos_u32_t bits = (1 << eos_task_get_priority(eos_task_self()));
+eos_u32_t eos_db_stream_space_h(eos_topic_handle_t key)
+{
+    EOS_ASSERT(key < EOS_MAX_OBJECTS);
+    eos_u8_t attribute = eos.object[key].attribute;
+    EOS_ASSERT((attribute & EOS_DB_ATTRIBUTE_STREAM) != 0);
 
-    eos_u32_t size_remain;
-    /* Value type event key. */
-    if (type == EOS_EVENT_ATTRIBUTE_VALUE)
-    {
-        /* Update the event's value. */
-        for (eos_u32_t i = 0; i < eos.object[e_id].size; i++)
-        {
-            ((eos_u8_t *)(eos.object[e_id].data.value))[i] = ((eos_u8_t *)memory)[i];
-        }
-    }
-    /* Stream type event key. */
-    else if (type == EOS_EVENT_ATTRIBUTE_STREAM)
-    {
-        /* Check if the remaining memory is enough or not. */
-        eos_stream_t *queue = eos.object[e_id].data.stream;
-        size_remain = eos_stream_empty_size(queue);
-        EOS_ASSERT(size_remain >= size);
-        /* Push all data to the queue. */
-        eos_stream_push(queue, (void *)memory, size);
-    }
+    eos_base_t level = eos_db_lock_(attribute);
+    eos_u32_t size = eos_stream_empty_size(eos.object[key].data.stream);
+    eos_db_unlock_(attribute, level);
 
-    eos_hw_interrupt_enable(level);
+    return size;
 }
 
-eos_inline eos_s32_t eos_db_read_(eos_u8_t type,
-                                    const char *key, 
-                                    const void *memory, eos_u32_t size)
+eos_u32_t eos_db_stream_reserve(const char *key, void **buffer)
 {
-    /* If in interrupt service function, disable the interrupt. */
-    register eos_base_t level = eos_hw_interrupt_disable();
-
-    /* Get event id according the topic. */
-    eos_u16_t e_id = eos_hash_get_index(EosObj_Event, key);
-    EOS_ASSERT(e_id != EOS_MAX_OBJECTS);
-    EOS_ASSERT(eos.object[e_id].type == EosObj_Event);
+    eos_u16_t e_id = eos_db_stream_key_get_(key);
     eos_u8_t attribute = eos.object[e_id].attribute;
-    EOS_ASSERT((attribute & type) != 0);
-    eos_u32_t bits = (1 << eos_task_get_priority(eos_task_self()));
 
-    /* Value type. */
-    eos_s32_t ret_size = 0;
-    if (type == EOS_EVENT_ATTRIBUTE_VALUE)
-    {
-        /* Update the event's value. */
-        for (eos_u32_t i = 0; i < eos.object[e_id].size; i++)
-        {
-            ((eos_u8_t *)memory)[i] =
-                ((eos_u8_t *)(eos.object[e_id].data.value))[i];
-        }
+    eos_base_t level = eos_db_lock_(attribute);
+    eos_u32_t size = eos_stream_reserve(eos.object[e_id].data.stream, buffer);
+    eos_db_unlock_(attribute, level);
 
-        ret_size = size;
-    }
-    /* Stream type. */
-    else if (type == EOS_EVENT_ATTRIBUTE_STREAM)
-    {
-        /* Check if the remaining memory is enough or not. */
-        eos_stream_t *queue = eos.object[e_id].data.stream;
-        /* Push all data to the queue. */
-        ret_size = eos_stream_pull_pop(queue, (void *)memory, size);
-    }
+    return size;
+}
 
-    eos_hw_interrupt_enable(level);
+void eos_db_stream_commit(const char *key, eos_u32_t size)
+{
+    eos_u16_t e_id = eos_db_stream_key_get_(key);
+    eos_u8_t attribute = eos.object[e_id].attribute;
 
-    return ret_size;
+    eos_base_t level = eos_db_lock_(attribute);
+    eos_stream_commit(eos.object[e_id].data.stream, size);
+    eos_db_unlock_(attribute, level);
 }
 
-/* private sm function ------------------------------------------------------ */
-#if (EOS_USE_SM_MODE != 0)
-eos_ret_t eos_tran(eos_sm_t *const me, eos_state_handler state)
+eos_u32_t eos_db_stream_peek(const char *key, void **buffer)
 {
-    me->state = state;
+    eos_u16_t e_id = eos_db_stream_key_get_(key);
+    eos_u8_t attribute = eos.object[e_id].attribute;
 
-    return EOS_Ret_Tran;
+    eos_base_t level = eos_db_lock_(attribute);
+    eos_u32_t size = eos_stream_peek(eos.object[e_id].data.stream, buffer);
+    eos_db_unlock_(attribute, level);
+
+    return size;
 }
 
-eos_ret_t eos_super(eos_sm_t *const me, eos_state_handler state)
+void eos_db_stream_consume(const char *key, eos_u32_t size)
 {
-    me->state = state;
+    eos_u16_t e_id = eos_db_stream_key_get_(key);
+    eos_u8_t attribute = eos.object[e_id].attribute;
 
-    return EOS_Ret_Super;
+    eos_base_t level = eos_db_lock_(attribute);
+    eos_stream_consume(eos.object[e_id].data.stream, size);
+    eos_db_unlock_(attribute, level);
 }
 
-eos_ret_t eos_state_top(eos_sm_t *const me, eos_event_t const * const e)
+void *eos_db_value_acquire(const char *key)
 {
-    (void)me;
-    (void)e;
+    eos_u16_t e_id = eos_db_frame_key_get_(key);
 
-    return EOS_Ret_Null;
+    register eos_base_t level = eos_hw_interrupt_disable();
+    void *data = eos_db_frame_acquire_(e_id);
+    eos_hw_interrupt_enable(level);
+
+    return data;
 }
-#endif
 
-#if (EOS_USE_SM_MODE != 0)
-static void eos_sm_dispath(eos_sm_t *const me, eos_event_t const * const e)
+void eos_db_value_publish(const char *key, void *data)
 {
-#if (EOS_USE_HSM_MODE != 0)
-    eos_state_handler path[EOS_MAX_HSM_NEST_DEPTH];
-#endif
-    eos_ret_t r;
+    eos_u16_t e_id = eos_db_frame_key_get_(key);
 
-    EOS_ASSERT(e != (eos_event_t *)0);
+    register eos_base_t level = eos_hw_interrupt_disable();
+    bool changed = eos_db_frame_publish_(e_id, data);
+    eos_hw_interrupt_enable(level);
 
-#if (EOS_USE_HSM_MODE == 0)
+    eos_db_link_(e_id, changed);
+}
+
+const void *eos_db_value_pin(const char *key)
+{
+    eos_db_frame_t *frame = eos.object[eos_db_frame_key_get_(key)].data.frame;
+
+    register eos_base_t level = eos_hw_interrupt_disable();
+    eos_u8_t current = frame->current;
+    EOS_ASSERT(frame->pin[current] < (EOS_DB_FRAME_WRITING - 1));
+    frame->pin[current] ++;
+    eos_hw_interrupt_enable(level);
+
+    return eos_db_frame_buffer_(frame, current);
+}
+
+eos_u32_t eos_db_value_drop(const char *key)
+{
+    return eos.object[eos_db_frame_key_get_(key)].data.frame->drop;
+}
+
+void eos_db_value_unpin(const char *key, const void *data)
+{
+    eos_db_frame_t *frame = eos.object[eos_db_frame_key_get_(key)].data.frame;
+    eos_u32_t index = eos_db_frame_index_(frame, data);
+
+    register eos_base_t level = eos_hw_interrupt_disable();
+    EOS_ASSERT(frame->pin[index] != 0 &&
+               frame->pin[index] != EOS_DB_FRAME_WRITING);
+    frame->pin[index] --;
+    eos_hw_interrupt_enable(level);
+}
+
+#if (EOS_USE_DB_DELTA != 0)
+void eos_db_block_read_delta(const char *key, void * const data,
+                                eos_u32_t *mask, eos_u32_t *version)
+{
+    eos_u16_t e_id = eos_db_key_get_(key);
+    eos_object_t *object = &eos.object[e_id];
+    EOS_ASSERT_NAME((object->attribute & EOS_DB_ATTRIBUTE_CHANGE_ONLY) != 0, key);
+    eos_u32_t version_last = *version;
+
+    /* The mask of the pinned buffer is got when it is pinned. */
+    if ((object->attribute & EOS_DB_ATTRIBUTE_MULTI_BUFFER) != 0)
+    {
+        eos_db_frame_t *frame = object->data.frame;
+
+        register eos_base_t level = eos_hw_interrupt_disable();
+        eos_u8_t current = frame->current;
+        frame->pin[current] ++;
+        eos_db_delta_mask_(e_id, mask, version);
+        eos_hw_interrupt_enable(level);
+
+        memcpy(data, eos_db_frame_buffer_(frame, current), object->size);
+
+        level = eos_hw_interrupt_disable();
+        frame->pin[current] --;
+        eos_hw_interrupt_enable(level);
+
+        return;
+    }
+
+    /* The value and the mask are read under the sequence counter. */
+    while (1)
+    {
+        eos_u32_t seq = EOS_LOAD_ACQUIRE(&object->seq);
+        if ((seq & 1) != 0)
+        {
+            continue;
+        }
+        memcpy(data, object->data.value, object->size);
+        *version = version_last;
+        eos_db_delta_mask_(e_id, mask, version);
+        EOS_FENCE();
+        if (seq == EOS_LOAD_ACQUIRE(&object->seq))
+        {
+            break;
+        }
+    }
+}
+#endif
+
+void eos_db_snapshot_read(const char *const topics[],
+                            void *const data[], eos_u32_t count)
+{
+    eos_u16_t e_id[EOS_DB_SNAPSHOT_MAX];
+    EOS_ASSERT(count <= EOS_DB_SNAPSHOT_MAX);
+
+    register eos_base_t level = eos_hw_interrupt_disable();
+    for (eos_u32_t i = 0; i < count; i ++)
+    {
+        e_id[i] = eos_hash_get_index(EosObj_Event, topics[i]);
+    }
+    eos_hw_interrupt_enable(level);
+    for (eos_u32_t i = 0; i < count; i ++)
+    {
+        EOS_ASSERT_NAME(e_id[i] != EOS_MAX_OBJECTS, topics[i]);
+    }
+
+    eos_db_snapshot_(e_id, data, count);
+}
+
+void eos_db_snapshot_read_h(const eos_topic_handle_t topics[],
+                            void *const data[], eos_u32_t count)
+{
+    eos_db_snapshot_(topics, data, count);
+}
+
+void eos_db_persist_set(const eos_db_persist_t *persist)
+{
+    EOS_ASSERT(persist != EOS_NULL && persist->save != EOS_NULL);
+    EOS_ASSERT(persist->buffer != EOS_NULL);
+
+    /* The persistent keys registered before must fit in the storage too. */
+    for (eos_u16_t i = 0; i < EOS_MAX_OBJECTS; i ++)
+    {
+        EOS_ASSERT(eos.object[i].type != EosObj_Event ||
+                   (eos.object[i].attribute & EOS_DB_ATTRIBUTE_PERSISTENT) == 0 ||
+                   eos.object[i].size <= persist->size_max);
+    }
+
+    eos.persist = persist;
+}
+
+eos_s32_t eos_db_persist_flush(void)
+{
+    EOS_ASSERT(eos.persist != EOS_NULL);
+
+    eos_s32_t count = 0;
+    bool failed = false;
+    for (eos_u16_t i = 0; i < EOS_MAX_OBJECTS; i ++)
+    {
+        eos_u32_t bit = (1U << (i & 31));
+        if ((eos.db_dirty[i >> 5] & bit) == 0)
+        {
+            continue;
+        }
+
+        /* Save a copy, as the value may be written during the save. */
+        register eos_base_t level = eos_hw_interrupt_disable();
+        eos_u32_t size = eos.object[i].size;
+        eos.db_dirty[i >> 5] &= ~bit;
+        memcpy(eos.persist->buffer, eos_db_value_(i), size);
+        eos_hw_interrupt_enable(level);
+
+        bool saved = eos.persist->save(eos.object[i].key,
+                                       eos.persist->buffer, size);
+
+        level = eos_hw_interrupt_disable();
+        /* Mark the key again if it is not saved, such as the flash is full. */
+        if (!saved)
+        {
+            eos.db_dirty[i >> 5] |= bit;
+        }
+        eos_hw_interrupt_enable(level);
+
+        if (saved)
+        {
+            count ++;
+        }
+        else
+        {
+            failed = true;
+        }
+    }
+
+    return failed ? EOS_ERROR : count;
+}
+
+/* -----------------------------------------------------------------------------
+Channel
+----------------------------------------------------------------------------- */
+void eos_chan_init(eos_chan_t *const me, const char *key)
+{
+    me->e_id = EOS_MAX_OBJECTS;
+    if (key != EOS_NULL)
+    {
+        me->e_id = eos_db_key_get_(key);
+        EOS_ASSERT_NAME((eos.object[me->e_id].attribute &
+                         (EOS_DB_ATTRIBUTE_VALUE | EOS_DB_ATTRIBUTE_STREAM)) != 0,
+                        key);
+    }
+
+    me->pending = false;
+    me->busy = false;
+    me->data = EOS_NULL;
+    me->size = 0;
+    memset(me->recv_wait, 0, sizeof(me->recv_wait));
+    memset(me->send_wait, 0, sizeof(me->send_wait));
+}
+
+eos_err_t eos_chan_send(eos_chan_t *const me,
+                        const void *data, eos_u32_t size, eos_s32_t time_ms)
+{
+    EOS_ASSERT(size != 0);
+    EOS_ASSERT(time_ms == EOS_WAIT_NO || eos_interrupt_get_nest() == 0);
+    EOS_ASSERT(me->e_id != EOS_MAX_OBJECTS || eos_interrupt_get_nest() == 0);
+
+    eos_u32_t time_start = eos_tick_get_ms();
+    register eos_base_t level = eos_hw_interrupt_disable();
+
+    /* Wait for the room of the stream, or the rendezvous in progress. */
+    while (eos_chan_put_(me, data, size) == false)
+    {
+        eos_s32_t time_left = eos_chan_time_left_(time_ms, time_start);
+        if (time_left == 0)
+        {
+            eos_hw_interrupt_enable(level);
+            return EOS_ETIMEOUT;
+        }
+
+        level = eos_chan_wait_(me->send_wait, time_left, level);
+    }
+
+    /* The buffered channel is done, and the rendezvous waits for a receiver to
+       copy the data. */
+    eos_err_t ret = EOS_EOK;
+    if (me->e_id == EOS_MAX_OBJECTS)
+    {
+        while (me->pending)
+        {
+            eos_s32_t time_left = eos_chan_time_left_(time_ms, time_start);
+            if (time_left == 0)
+            {
+                break;
+            }
+            level = eos_chan_wait_(me->send_wait, time_left, level);
+        }
+
+        /* Withdraw the data if no receiver has taken it. */
+        if (me->pending)
+        {
+            me->pending = false;
+            ret = EOS_ETIMEOUT;
+        }
+        me->busy = false;
+        eos_chan_wake_(me->send_wait);
+    }
+
+    eos_hw_interrupt_enable(level);
+
+    return ret;
+}
+
+eos_s32_t eos_chan_recv(eos_chan_t *const me,
+                        void *buffer, eos_u32_t size, eos_s32_t time_ms)
+{
+    EOS_ASSERT(size != 0);
+    EOS_ASSERT(time_ms == EOS_WAIT_NO || eos_interrupt_get_nest() == 0);
+
+    eos_u32_t time_start = eos_tick_get_ms();
+    register eos_base_t level = eos_hw_interrupt_disable();
+
+    eos_s32_t ret;
+    while ((ret = eos_chan_get_(me, buffer, size)) == 0)
+    {
+        eos_s32_t time_left = eos_chan_time_left_(time_ms, time_start);
+        if (time_left == 0)
+        {
+            ret = EOS_ETIMEOUT;
+            break;
+        }
+
+        level = eos_chan_wait_(me->recv_wait, time_left, level);
+    }
+
+    eos_hw_interrupt_enable(level);
+
+    return ret;
+}
+
+/* private db function ------------------------------------------------------ */
+static void eos_db_alloc_(eos_u16_t e_id, eos_u32_t size)
+{
+    eos_u8_t attribute = eos.object[e_id].attribute;
+
+    if ((attribute & EOS_DB_ATTRIBUTE_MULTI_BUFFER) != 0)
+    {
+        /* Apply a memory for the frame and all the buffers. */
+        eos_u32_t stride = (size + 7U) & ~7U;
+        eos_u32_t size_total = EOS_DB_FRAME_HEAD_SIZE + stride * EOS_DB_VALUE_BUFFERS;
+        if ((attribute & EOS_DB_ATTRIBUTE_CHANGE_ONLY) != 0)
+        {
+            size_total += EOS_DB_DELTA_SIZE(size);
+        }
+        eos_db_frame_t *frame =
+            (eos_db_frame_t *)eos_heap_malloc(&eos.db, size_total);
+        EOS_ASSERT(frame != EOS_NULL);
+        memset(frame, 0, size_total);
+        frame->stride = stride;
+
+        eos.object[e_id].data.frame = frame;
+        eos.object[e_id].size = size;
+    }
+    else if ((attribute & EOS_DB_ATTRIBUTE_VALUE) != 0)
+    {
+        /* Apply a memory for the db key, and the change record. */
+        void *data;
+        if ((attribute & EOS_DB_ATTRIBUTE_CHANGE_ONLY) != 0)
+        {
+            eos_u32_t size_total = ((size + 3U) & ~3U) + EOS_DB_DELTA_SIZE(size);
+            data = eos_heap_malloc(&eos.db, size_total);
+            EOS_ASSERT(data != EOS_NULL);
+            memset(data, 0, size_total);
+        }
+        else
+        {
+            data = eos_heap_malloc(&eos.db, size);
+            EOS_ASSERT(data != EOS_NULL);
+        }
+
+        eos.object[e_id].data.value = data;
+        eos.object[e_id].size = size;
+    }
+    else if ((attribute & EOS_DB_ATTRIBUTE_STREAM) != 0)
+    {
+        /* Apply a memory for the db key. */
+        void *data = eos_heap_malloc(&eos.db, (size + sizeof(eos_stream_t)));
+        EOS_ASSERT(data != EOS_NULL);
+
+        eos.object[e_id].data.stream = (eos_stream_t *)data;
+        eos.object[e_id].size = size;
+
+        eos_stream_init(eos.object[e_id].data.stream,
+                        (void *)((eos_u8_t *)data + sizeof(eos_stream_t)),
+                        eos.object[e_id].size);
+
+        eos_owner_t *e_sub = &eos.object[e_id].ocb.event.e_sub;
+        memset(e_sub, 0, sizeof(eos_owner_t));
+    }
+
+#if (EOS_USE_DB_DELTA != 0)
+    /* The version 0 of the reader is never the latest one. */
+    if ((attribute & EOS_DB_ATTRIBUTE_CHANGE_ONLY) != 0)
+    {
+        eos_db_delta_get_(e_id)->count = 1;
+    }
+#endif
+}
+
+static eos_u16_t eos_db_key_get_(const char *key)
+{
+    register eos_base_t level = eos_hw_interrupt_disable();
+    eos_u16_t e_id = eos_hash_get_index(EosObj_Event, key);
+    eos_hw_interrupt_enable(level);
+    EOS_ASSERT_NAME(e_id != EOS_MAX_OBJECTS, key);
+
+    return e_id;
+}
+
+static eos_u16_t eos_db_stream_key_get_(const char *key)
+{
+    eos_u16_t e_id = eos_db_key_get_(key);
+    EOS_ASSERT_NAME((eos.object[e_id].attribute & EOS_DB_ATTRIBUTE_STREAM) != 0,
+                    key);
+
+    return e_id;
+}
+
+/* The SPSC stream key is written by one producer and read by one consumer
+   without the lock, and the other keys are accessed with the interrupt
+   disabled. */
+eos_inline eos_base_t eos_db_lock_(eos_u8_t attribute)
+{
+    if ((attribute & EOS_DB_ATTRIBUTE_SPSC) != 0)
+    {
+        return 0;
+    }
+
+    return eos_hw_interrupt_disable();
+}
+
+eos_inline void eos_db_unlock_(eos_u8_t attribute, eos_base_t level)
+{
+    if ((attribute & EOS_DB_ATTRIBUTE_SPSC) == 0)
+    {
+        eos_hw_interrupt_enable(level);
+    }
+}
+
+/* Mark the written persistent value key to be saved, with the interrupt
+   disabled. */
+eos_inline void eos_db_persist_mark_(eos_u16_t e_id)
+{
+    if ((eos.object[e_id].attribute & EOS_DB_ATTRIBUTE_PERSISTENT) != 0 &&
+        eos.persist != EOS_NULL)
+    {
+        eos.db_dirty[e_id >> 5] |= (1U << (e_id & 31));
+        if (eos.persist->notify != EOS_NULL)
+        {
+            eos.persist->notify();
+        }
+    }
+}
+
+/* The value is written with the interrupt disabled, so the writers are in
+   order. The sequence is odd during the copy, and the reader copies the value
+   again if the sequence is odd or changed, so it never disables the interrupt,
+   and never gets a value half written. */
+eos_inline bool eos_db_value_write_(eos_u16_t e_id, const void *memory)
+{
+    eos_object_t *object = &eos.object[e_id];
+
+    if ((object->attribute & EOS_DB_ATTRIBUTE_MULTI_BUFFER) != 0)
+    {
+        void *data = eos_db_frame_acquire_(e_id);
+        if (data == EOS_NULL)
+        {
+            return false;
+        }
+        memcpy(data, memory, object->size);
+
+        return eos_db_frame_publish_(e_id, data);
+    }
+
+    eos_u32_t seq = object->seq;
+    bool changed = true;
+
+    object->seq = seq + 1;
+    EOS_FENCE();
+    if ((object->attribute & EOS_DB_ATTRIBUTE_CHANGE_ONLY) != 0)
+    {
+        changed = eos_db_change_(e_id, (eos_u8_t *)object->data.value,
+                                 (const eos_u8_t *)memory, true);
+    }
+    else
+    {
+        memcpy(object->data.value, memory, object->size);
+    }
+    EOS_STORE_RELEASE(&object->seq, seq + 2);
+
+    if (changed)
+    {
+        eos_db_persist_mark_(e_id);
+    }
+
+    return changed;
+}
+
+/* Compare the new value with the value by 4-byte words, copy the changed words
+   if copy, and stamp them in the change record. Return true if it changed. */
+static bool eos_db_change_(eos_u16_t e_id,
+                            eos_u8_t *value, const eos_u8_t *value_new, bool copy)
+{
+    eos_u32_t size = eos.object[e_id].size;
+    bool changed = false;
+
+#if (EOS_USE_DB_DELTA != 0)
+    eos_db_delta_t *delta = eos_db_delta_get_(e_id);
+    eos_u16_t stamp = (eos_u16_t)(delta->count + 1);
+
+    for (eos_u32_t i = 0; i < size; i += 4)
+    {
+        eos_u32_t size_word = ((size - i) < 4) ? (size - i) : 4;
+        if (memcmp(&value[i], &value_new[i], size_word) != 0)
+        {
+            if (copy)
+            {
+                memcpy(&value[i], &value_new[i], size_word);
+            }
+            delta->stamp[i / 4] = stamp;
+            changed = true;
+        }
+    }
+    if (changed)
+    {
+        delta->count ++;
+
+        /* The stamps of the words unchanged for long are moved up to 0x8000
+           versions ago now and then, or they would wrap and look new. */
+        if ((delta->count & 0x3fffU) == 0)
+        {
+            for (eos_u32_t i = 0; i < (size + 3U) / 4U; i ++)
+            {
+                if ((eos_u16_t)(delta->count - delta->stamp[i]) >= 0x8000U)
+                {
+                    delta->stamp[i] = (eos_u16_t)(delta->count - 0x8000U);
+                }
+            }
+        }
+    }
+#else
+    (void)e_id;
+    changed = (memcmp(value, value_new, size) != 0) ? true : false;
+    if (changed && copy)
+    {
+        memcpy(value, value_new, size);
+    }
+#endif
+
+    return changed;
+}
+
+#if (EOS_USE_DB_DELTA != 0)
+static eos_db_delta_t *eos_db_delta_get_(eos_u16_t e_id)
+{
+    eos_object_t *object = &eos.object[e_id];
+
+    if ((object->attribute & EOS_DB_ATTRIBUTE_MULTI_BUFFER) != 0)
+    {
+        return (eos_db_delta_t *)eos_db_frame_buffer_(object->data.frame,
+                                                      EOS_DB_VALUE_BUFFERS);
+    }
+
+    return (eos_db_delta_t *)((eos_u8_t *)object->data.value +
+                              ((object->size + 3U) & ~3U));
+}
+
+/* Set the bits of the words changed since the version, and update it to the
+   latest one. All the words are set for the version 0, or a version too old to
+   be told by the 16-bit stamps. */
+static void eos_db_delta_mask_(eos_u16_t e_id, eos_u32_t *mask, eos_u32_t *version)
+{
+    eos_db_delta_t *delta = eos_db_delta_get_(e_id);
+    eos_u32_t words = (eos.object[e_id].size + 3U) / 4U;
+    eos_u32_t distance = delta->count - *version;
+    bool all = (*version == 0 || distance >= 0x8000U) ? true : false;
+
+    memset(mask, 0, ((words + 31U) / 32U) * sizeof(eos_u32_t));
+    for (eos_u32_t i = 0; i < words; i ++)
+    {
+        if (all || (eos_u16_t)(delta->count - delta->stamp[i]) < distance)
+        {
+            mask[i >> 5] |= (1U << (i & 31));
+        }
+    }
+    *version = delta->count;
+}
+#endif
+
+/* Copy the value keys as a coherent set. The sequences of all the keys are read
+   before the copy and checked after it, and the copy is done again if any key
+   is written in between. If the writers keep interleaving, all the keys are
+   copied in one critical section at last. */
+static void eos_db_snapshot_(const eos_u16_t *e_id,
+                                void *const data[], eos_u32_t count)
+{
+    eos_u32_t seq[EOS_DB_SNAPSHOT_MAX];
+    EOS_ASSERT(count <= EOS_DB_SNAPSHOT_MAX);
+
+    for (eos_u32_t i = 0; i < count; i ++)
+    {
+        EOS_ASSERT(e_id[i] < EOS_MAX_OBJECTS);
+        EOS_ASSERT(eos.object[e_id[i]].type == EosObj_Event);
+        EOS_ASSERT_NAME((eos.object[e_id[i]].attribute &
+                         EOS_DB_ATTRIBUTE_VALUE) != 0, eos.object[e_id[i]].key);
+    }
+
+    for (eos_u32_t times = 0; times < EOS_DB_SNAPSHOT_RETRY; times ++)
+    {
+        bool writing = false;
+        for (eos_u32_t i = 0; i < count; i ++)
+        {
+            seq[i] = EOS_LOAD_ACQUIRE(&eos.object[e_id[i]].seq);
+            writing = ((seq[i] & 1) != 0) ? true : writing;
+        }
+        if (writing)
+        {
+            continue;
+        }
+
+        for (eos_u32_t i = 0; i < count; i ++)
+        {
+            memcpy(data[i], eos_db_value_(e_id[i]), eos.object[e_id[i]].size);
+        }
+        EOS_FENCE();
+
+        bool changed = false;
+        for (eos_u32_t i = 0; i < count; i ++)
+        {
+            if (EOS_LOAD_ACQUIRE(&eos.object[e_id[i]].seq) != seq[i])
+            {
+                changed = true;
+                break;
+            }
+        }
+        if (!changed)
+        {
+            return;
+        }
+    }
+
+    register eos_base_t level = eos_hw_interrupt_disable();
+    for (eos_u32_t i = 0; i < count; i ++)
+    {
+        memcpy(data[i], eos_db_value_(e_id[i]), eos.object[e_id[i]].size);
+    }
+    eos_hw_interrupt_enable(level);
+}
+
+/* Publish the event of the linked value key after a write, with the interrupt
+   enabled. The change-only key publishes it only if the value changed. */
+eos_inline void eos_db_link_(eos_u16_t e_id, bool changed)
+{
+    if (changed &&
+        (eos.object[e_id].attribute & EOS_DB_ATTRIBUTE_LINK_EVENT) != 0)
+    {
+        eos_event_give_id_(EOS_MAX_OBJECTS, EosEventGiveType_Publish, e_id);
+    }
+}
+
+eos_inline void eos_db_value_read_(eos_u16_t e_id, void *memory)
+{
+    eos_object_t *object = &eos.object[e_id];
+
+    /* The pinned buffer of the multi-buffer key is copied without the lock. */
+    if ((object->attribute & EOS_DB_ATTRIBUTE_MULTI_BUFFER) != 0)
+    {
+        eos_db_frame_t *frame = object->data.frame;
+
+        register eos_base_t level = eos_hw_interrupt_disable();
+        eos_u8_t current = frame->current;
+        frame->pin[current] ++;
+        eos_hw_interrupt_enable(level);
+
+        memcpy(memory, eos_db_frame_buffer_(frame, current), object->size);
+
+        level = eos_hw_interrupt_disable();
+        frame->pin[current] --;
+        eos_hw_interrupt_enable(level);
+
+        return;
+    }
+
+    /* If the writers keep interleaving, such as an interrupt rewriting a large
+       value faster than one copy, it is copied in one critical section at last,
+       as the snapshot read. */
+    for (eos_u32_t times = 0; times < EOS_DB_READ_RETRY; times ++)
+    {
+        eos_u32_t seq = EOS_LOAD_ACQUIRE(&object->seq);
+        if ((seq & 1) != 0)
+        {
+            continue;
+        }
+        memcpy(memory, object->data.value, object->size);
+        EOS_FENCE();
+        if (seq == EOS_LOAD_ACQUIRE(&object->seq))
+        {
+            return;
+        }
+    }
+
+    register eos_base_t level = eos_hw_interrupt_disable();
+    memcpy(memory, object->data.value, object->size);
+    eos_hw_interrupt_enable(level);
+}
+
+eos_inline void eos_db_write_(eos_u8_t type, eos_u16_t e_id, 
+                                const void *memory, eos_u32_t size)
+{
+    EOS_ASSERT(e_id < EOS_MAX_OBJECTS);
+    EOS_ASSERT(eos.object[e_id].type == EosObj_Event);
+    eos_u8_t attribute = eos.object[e_id].attribute;
+    EOS_ASSERT((attribute & type) != 0);
+
+    /* The back buffer of the multi-buffer key is filled without the lock. */
+    if ((attribute & EOS_DB_ATTRIBUTE_MULTI_BUFFER) != 0)
+    {
+        register eos_base_t level = eos_hw_interrupt_disable();
+        void *data = eos_db_frame_acquire_(e_id);
+        eos_hw_interrupt_enable(level);
+        if (data == EOS_NULL)
+        {
+            return;
+        }
+
+        memcpy(data, memory, eos.object[e_id].size);
+
+        level = eos_hw_interrupt_disable();
+        bool changed = eos_db_frame_publish_(e_id, data);
+        eos_hw_interrupt_enable(level);
+
+        eos_db_link_(e_id, changed);
+
+        return;
+    }
+
+    /* If in interrupt service function, disable the interrupt. */
+    eos_base_t level = eos_db_lock_(attribute);
+
+    eos_u32_t size_remain;
+    bool changed = false;
+    /* Value type event key. */
+    if (type == EOS_EVENT_ATTRIBUTE_VALUE)
+    {
+        /* Update the event's value. */
+        changed = eos_db_value_write_(e_id, memory);
+    }
+    /* Stream type event key. */
+    else if (type == EOS_EVENT_ATTRIBUTE_STREAM)
+    {
+        /* Check if the remaining memory is enough or not. */
+        eos_stream_t *queue = eos.object[e_id].data.stream;
+        size_remain = eos_stream_empty_size(queue);
+        EOS_ASSERT(size_remain >= size);
+        /* Push all data to the queue. */
+        eos_stream_push(queue, (void *)memory, size);
+    }
+
+    eos_db_unlock_(attribute, level);
+
+    eos_db_link_(e_id, changed);
+}
+
+eos_inline eos_s32_t eos_db_read_(eos_u8_t type,
+                                    eos_u16_t e_id, 
+                                    const void *memory, eos_u32_t size)
+{
+    EOS_ASSERT(e_id < EOS_MAX_OBJECTS);
+    EOS_ASSERT(eos.object[e_id].type == EosObj_Event);
+    eos_u8_t attribute = eos.object[e_id].attribute;
+    EOS_ASSERT((attribute & type) != 0);
+
+    /* Value type, read without the lock. */
+    if (type == EOS_EVENT_ATTRIBUTE_VALUE)
+    {
+        eos_db_value_read_(e_id, (void *)memory);
+
+        return size;
+    }
+
+    /* If in interrupt service function, disable the interrupt. */
+    eos_base_t level = eos_db_lock_(attribute);
+
+    /* Stream type. */
+    eos_s32_t ret_size = 0;
+    if (type == EOS_EVENT_ATTRIBUTE_STREAM)
+    {
+        /* Check if the remaining memory is enough or not. */
+        eos_stream_t *queue = eos.object[e_id].data.stream;
+        /* Push all data to the queue. */
+        ret_size = eos_stream_pull_pop(queue, (void *)memory, size);
+    }
+
+    eos_db_unlock_(attribute, level);
+
+    return ret_size;
+}
+
+static eos_u16_t eos_db_frame_key_get_(const char *key)
+{
+    eos_u16_t e_id = eos_db_key_get_(key);
+    EOS_ASSERT_NAME((eos.object[e_id].attribute &
+                     EOS_DB_ATTRIBUTE_MULTI_BUFFER) != 0, key);
+
+    return e_id;
+}
+
+eos_inline eos_u8_t *eos_db_frame_buffer_(eos_db_frame_t *frame, eos_u32_t index)
+{
+    return (eos_u8_t *)frame + EOS_DB_FRAME_HEAD_SIZE + frame->stride * index;
+}
+
+static eos_u32_t eos_db_frame_index_(eos_db_frame_t *frame, const void *data)
+{
+    eos_u32_t offset = (eos_u32_t)((eos_u8_t *)data - eos_db_frame_buffer_(frame, 0));
+    EOS_ASSERT((offset % frame->stride) == 0);
+    EOS_ASSERT((offset / frame->stride) < EOS_DB_VALUE_BUFFERS);
+
+    return offset / frame->stride;
+}
+
+/* Get a back buffer which is neither the current one nor pinned, with the
+   interrupt disabled. Return EOS_NULL and count the dropped write if all are
+   in use, so the writer, often an ISR, is never stopped by the readers. */
+static void *eos_db_frame_acquire_(eos_u16_t e_id)
+{
+    eos_db_frame_t *frame = eos.object[e_id].data.frame;
+
+    for (eos_u32_t i = 0; i < EOS_DB_VALUE_BUFFERS; i ++)
+    {
+        if (i != frame->current && frame->pin[i] == 0)
+        {
+            frame->pin[i] = EOS_DB_FRAME_WRITING;
+
+            return eos_db_frame_buffer_(frame, i);
+        }
+    }
+    frame->drop ++;
+
+    return EOS_NULL;
+}
+
+/* Make the written back buffer the current one, with the interrupt disabled.
+   The readers pinning the last one keep reading it until unpin. The back buffer
+   of the change-only key is dropped if it is the same as the current one.
+   Return true if the value changed. */
+static bool eos_db_frame_publish_(eos_u16_t e_id, void *data)
+{
+    eos_db_frame_t *frame = eos.object[e_id].data.frame;
+    eos_u32_t index = eos_db_frame_index_(frame, data);
+    EOS_ASSERT(frame->pin[index] == EOS_DB_FRAME_WRITING);
+
+    frame->pin[index] = 0;
+    if ((eos.object[e_id].attribute & EOS_DB_ATTRIBUTE_CHANGE_ONLY) != 0 &&
+        eos_db_change_(e_id, eos_db_frame_buffer_(frame, frame->current),
+                       (const eos_u8_t *)data, false) == false)
+    {
+        return false;
+    }
+
+    /* The sequence tells the snapshot reader that the current one changed. */
+    frame->current = (eos_u8_t)index;
+    EOS_STORE_RELEASE(&eos.object[e_id].seq, eos.object[e_id].seq + 2);
+    eos_db_persist_mark_(e_id);
+
+    return true;
+}
+
+/* The latest value of the value key, with the interrupt disabled. */
+eos_inline void *eos_db_value_(eos_u16_t e_id)
+{
+    if ((eos.object[e_id].attribute & EOS_DB_ATTRIBUTE_MULTI_BUFFER) != 0)
+    {
+        eos_db_frame_t *frame = eos.object[e_id].data.frame;
+
+        return eos_db_frame_buffer_(frame, frame->current);
+    }
+
+    return eos.object[e_id].data.value;
+}
+
+/* private channel function ------------------------------------------------- */
+/* Put the data into the channel, with the interrupt disabled. */
+static bool eos_chan_put_(eos_chan_t *const me, const void *data, eos_u32_t size)
+{
+    if (me->e_id == EOS_MAX_OBJECTS)
+    {
+        /* Only one sender offers its data at a time in the rendezvous. */
+        if (me->busy)
+        {
+            return false;
+        }
+        me->busy = true;
+        me->pending = true;
+        me->data = data;
+        me->size = size;
+    }
+    else if ((eos.object[me->e_id].attribute & EOS_DB_ATTRIBUTE_STREAM) != 0)
+    {
+        eos_stream_t *stream = eos.object[me->e_id].data.stream;
+        EOS_ASSERT(size <= stream->capacity);
+        if (eos_stream_empty_size(stream) < size)
+        {
+            return false;
+        }
+        eos_stream_push(stream, (void *)data, size);
+    }
+    else
+    {
+        /* The value is overwritten, so the sender never waits. */
+        EOS_ASSERT(size == eos.object[me->e_id].size);
+        eos_db_value_write_(me->e_id, data);
+        me->pending = true;
+    }
+
+    eos_chan_wake_(me->recv_wait);
+
+    return true;
+}
+
+/* Get the data out of the channel, with the interrupt disabled. Return 0 if the
+   channel is empty. */
+static eos_s32_t eos_chan_get_(eos_chan_t *const me,
+                                void *buffer, eos_u32_t size)
+{
+    eos_s32_t ret = 0;
+
+    if (me->e_id == EOS_MAX_OBJECTS)
+    {
+        if (me->pending)
+        {
+            /* The data exceeding the buffer is discarded. */
+            ret = (me->size < size) ? me->size : size;
+            memcpy(buffer, me->data, ret);
+            me->pending = false;
+            eos_chan_wake_(me->send_wait);
+        }
+    }
+    else if ((eos.object[me->e_id].attribute & EOS_DB_ATTRIBUTE_STREAM) != 0)
+    {
+        ret = eos_stream_pull_pop(eos.object[me->e_id].data.stream, buffer, size);
+        if (ret > 0)
+        {
+            eos_chan_wake_(me->send_wait);
+        }
+    }
+    else if (me->pending)
+    {
+        EOS_ASSERT(size >= eos.object[me->e_id].size);
+        ret = eos.object[me->e_id].size;
+        memcpy(buffer, eos_db_value_(me->e_id), ret);
+        me->pending = false;
+    }
+
+    return ret;
+}
+
+/* The time left before the timeout, 0 if it is timeout. */
+static eos_s32_t eos_chan_time_left_(eos_s32_t time_ms, eos_u32_t time_start)
+{
+    if (time_ms < 0)
+    {
+        return EOS_WAIT_FOREVER;
+    }
+
+    eos_u32_t time_past = eos_tick_get_ms() - time_start;
+
+    return (time_past >= (eos_u32_t)time_ms) ? 0 : (time_ms - time_past);
+}
+
+/* Wait for the channel on the semaphore of the task, with the interrupt
+   disabled, which is enabled during the wait. The events given to the task
+   during the wait are kept in the mailbox without releasing the semaphore, so
+   only the channel wakes it, and the semaphore counts the mailbox events
+   again after the wait. A release to a task which has just timed out is
+   cleared so too. A task may be woken for nothing, and checks the channel
+   again, but is never missed. */
+static eos_base_t eos_chan_wait_(eos_u32_t *wait,
+                                    eos_s32_t time_ms, eos_base_t level)
+{
+    eos_task_handle_t task = eos_task_self();
+    eos_u32_t index = task->index;
+
+    task->wait_chan = true;
+    wait[index >> 5] |= (1U << (index & 31));
+    eos_sem_reset(&task->sem, 0);
+    eos_hw_interrupt_enable(level);
+
+    eos_sem_take(&task->sem, time_ms);
+
+    level = eos_hw_interrupt_disable();
+    wait[index >> 5] &= ~(1U << (index & 31));
+    task->wait_chan = false;
+    eos_u32_t count = 0;
+    for (eos_event_data_t *e_item = task->e_head;
+         e_item != EOS_NULL; e_item = e_item->next)
+    {
+        count ++;
+    }
+    eos_sem_reset(&task->sem, count);
+
+    return level;
+}
+
+/* Wake all the waiting tasks, with the interrupt disabled. The waiters are
+   taken out first, as a woken task of higher priority may run during the
+   release, and wait again. */
+static void eos_chan_wake_(eos_u32_t *wait)
+{
+    for (eos_u32_t i = 0; i < EOS_MAX_OWNER; i ++)
+    {
+        eos_u32_t word = wait[i];
+        wait[i] = 0;
+        while (word != 0)
+        {
+            eos_u32_t index = (i << 5) + (eos_u32_t)__eos_ffs((int)word) - 1;
+            word &= (word - 1);
+            eos_sem_release(&eos.object[eos.t_id[index]].ocb.task.tcb->sem);
+        }
+    }
+}
+
+/* private sm function ------------------------------------------------------ */
+#if (EOS_USE_SM_MODE != 0)
+eos_ret_t eos_tran(eos_sm_t *const me, eos_state_handler state)
+{
+    me->state = state;
+
+    return EOS_Ret_Tran;
+}
+
+eos_ret_t eos_super(eos_sm_t *const me, eos_state_handler state)
+{
+    me->state = state;
+
+    return EOS_Ret_Super;
+}
+
+eos_ret_t eos_state_top(eos_sm_t *const me, eos_event_t const * const e)
+{
+    (void)me;
+    (void)e;
+
+    return EOS_Ret_Null;
+}
+#endif
+
+#if (EOS_USE_SM_MODE != 0)
+static void eos_sm_dispath(eos_sm_t *const me, eos_event_t const * const e)
+{
+#if (EOS_USE_HSM_MODE != 0)
+    eos_state_handler path[EOS_MAX_HSM_NEST_DEPTH];
+#endif
+    eos_ret_t r;
+
+    EOS_ASSERT(e != (eos_event_t *)0);
+
+#if (EOS_USE_HSM_MODE == 0)
     eos_state_handler s = me->state;
     eos_state_handler t;
     
@@ -1712,282 +2900,676 @@ static eos_s32_t eos_sm_tran(eos_sm_t *const me,
         }
     }
 
-    return ip;
+    return ip;
+}
+#endif
+#endif
+
+/* public heap function ----------------------------------------------------- */
+#define EOS_HEAP_BLOCK_FREE             (1U)
+#define EOS_HEAP_BLOCK_HEAD             offsetof(eos_heap_block_t, next_free)
+#define EOS_HEAP_BLOCK_MIN              (sizeof(eos_heap_block_t) - EOS_HEAP_BLOCK_HEAD)
+
+#define HEAP_ALIGN_UP(x_)                                                      \
+                (((x_) + EOS_HEAP_ALIGN - 1) & ~((eos_u32_t)EOS_HEAP_ALIGN - 1))
+#define HEAP_BLOCK_SIZE(block_)         ((block_)->size & ~EOS_HEAP_BLOCK_FREE)
+#define HEAP_BLOCK_IS_FREE(block_)      (((block_)->size & EOS_HEAP_BLOCK_FREE) != 0)
+#define HEAP_BLOCK_PAYLOAD(block_)                                             \
+                ((void *)((eos_u8_t *)(block_) + EOS_HEAP_BLOCK_HEAD))
+#define HEAP_BLOCK_FROM_PAYLOAD(data_)                                         \
+                ((eos_heap_block_t *)((eos_u8_t *)(data_) - EOS_HEAP_BLOCK_HEAD))
+#define HEAP_BLOCK_NEXT(block_)                                                \
+                ((eos_heap_block_t *)((eos_u8_t *)HEAP_BLOCK_PAYLOAD(block_) + \
+                                      HEAP_BLOCK_SIZE(block_)))
+
+void eos_heap_init(eos_heap_t *const me, void *data, eos_u32_t size)
+{
+    EOS_ASSERT(data != EOS_NULL);
+
+    /* Align the heap memory. */
+    eos_u32_t mod = (eos_u32_t)((eos_pointer_t)data % EOS_HEAP_ALIGN);
+    if (mod != 0)
+    {
+        EOS_ASSERT(size > (EOS_HEAP_ALIGN - mod));
+        data = (void *)((eos_u8_t *)data + EOS_HEAP_ALIGN - mod);
+        size -= (EOS_HEAP_ALIGN - mod);
+    }
+    size &= ~((eos_u32_t)EOS_HEAP_ALIGN - 1);
+
+    /* The control block is at the start of the heap memory, with the first
+       levels up to the heap size, and the end of the heap is a zero-sized used
+       block, which stops the coalescing. */
+    EOS_ASSERT(size != 0);
+    eos_u32_t fl_index = (eos_u32_t)eos_heap_fls(size) + 1;
+    if (fl_index < EOS_HEAP_FL_SHIFT)
+    {
+        fl_index = EOS_HEAP_FL_SHIFT;
+    }
+    if (fl_index > EOS_HEAP_FL_INDEX_MAX)
+    {
+        fl_index = EOS_HEAP_FL_INDEX_MAX;
+    }
+    eos_u32_t fl_count = fl_index - EOS_HEAP_FL_SHIFT + 1;
+    eos_u32_t size_ctrl =
+        HEAP_ALIGN_UP((eos_u32_t)(sizeof(eos_heap_ctrl_t) +
+                                  fl_count * sizeof(eos_heap_list_t)));
+    EOS_ASSERT(size > (size_ctrl + 2 * EOS_HEAP_BLOCK_HEAD + EOS_HEAP_BLOCK_MIN));
+
+    me->ctrl = (eos_heap_ctrl_t *)data;
+    me->data = (eos_u8_t *)data + size_ctrl;
+    me->size = size - size_ctrl;
+    me->error_id = 0;
+    me->used = 0;
+    me->peak = 0;
+    me->alloc_count = 0;
+    me->free_count = 0;
+    me->failed_count = 0;
+    memset(me->ctrl, 0, size_ctrl);
+    me->ctrl->fl_count = fl_count;
+    me->ctrl->block_max = (1U << fl_index) - EOS_HEAP_ALIGN;
+
+    /* The memory is divided into the free blocks no larger than the maximum
+       block size. */
+    eos_heap_block_t *prev = EOS_NULL;
+    eos_heap_block_t *block = (eos_heap_block_t *)me->data;
+    eos_u32_t remain = me->size - EOS_HEAP_BLOCK_HEAD;
+    while (remain >= (EOS_HEAP_BLOCK_HEAD + EOS_HEAP_BLOCK_MIN))
+    {
+        eos_u32_t size_block = remain - EOS_HEAP_BLOCK_HEAD;
+        if (size_block > me->ctrl->block_max)
+        {
+            size_block = me->ctrl->block_max;
+        }
+
+        block->prev_phys = prev;
+        block->size = size_block;
+        eos_heap_insert(me->ctrl, block);
+
+        remain -= (EOS_HEAP_BLOCK_HEAD + size_block);
+        prev = block;
+        block = HEAP_BLOCK_NEXT(block);
+    }
+
+    /* The sentinel block takes the remaining bytes. */
+    block->prev_phys = prev;
+    block->size = 0;
+}
+
+void *eos_heap_malloc(eos_heap_t *const me, eos_u32_t size)
+{
+    if (size == 0)
+    {
+        me->error_id = 1;
+        me->failed_count ++;
+        return EOS_NULL;
+    }
+
+    /* Align the size, and round it up to the next list size, so that any block
+       in the found list is large enough. */
+    size = HEAP_ALIGN_UP(size);
+    if (size < EOS_HEAP_BLOCK_MIN)
+    {
+        size = EOS_HEAP_BLOCK_MIN;
+    }
+    eos_heap_ctrl_t *ctrl = me->ctrl;
+    if (size > ctrl->block_max)
+    {
+        me->error_id = 2;
+        me->failed_count ++;
+        return EOS_NULL;
+    }
+    eos_u32_t size_search = size;
+    if (size_search >= (1U << EOS_HEAP_FL_SHIFT))
+    {
+        eos_u32_t round = (1U << (eos_heap_fls(size_search) - EOS_HEAP_SL_LOG2)) - 1;
+        size_search += round;
+        if (size_search > ctrl->block_max)
+        {
+            me->error_id = 2;
+            me->failed_count ++;
+            return EOS_NULL;
+        }
+    }
+
+    /* Find the suitable free list by the bitmaps. */
+    eos_u32_t fl, sl;
+    eos_heap_mapping(ctrl, size_search, &fl, &sl);
+    eos_u32_t sl_map = ctrl->list[fl].sl_bitmap & (~0U << sl);
+    if (sl_map == 0)
+    {
+        eos_u32_t fl_map = (fl + 1) < 32 ? (ctrl->fl_bitmap & (~0U << (fl + 1))) : 0;
+        if (fl_map == 0)
+        {
+            me->error_id = 2;
+            me->failed_count ++;
+            return EOS_NULL;
+        }
+        fl = __eos_ffs(fl_map) - 1;
+        sl_map = ctrl->list[fl].sl_bitmap;
+    }
+    sl = __eos_ffs(sl_map) - 1;
+
+    eos_heap_block_t *block = ctrl->list[fl].blocks[sl];
+    EOS_ASSERT(block != EOS_NULL && HEAP_BLOCK_SIZE(block) >= size);
+    eos_heap_remove(ctrl, block);
+
+    /* Split the remaining bytes into a new free block. */
+    eos_u32_t size_block = HEAP_BLOCK_SIZE(block);
+    if (size_block >= (size + EOS_HEAP_BLOCK_HEAD + EOS_HEAP_BLOCK_MIN))
+    {
+        eos_heap_block_t *remain =
+            (eos_heap_block_t *)((eos_u8_t *)HEAP_BLOCK_PAYLOAD(block) + size);
+        remain->prev_phys = block;
+        remain->size = size_block - size - EOS_HEAP_BLOCK_HEAD;
+        HEAP_BLOCK_NEXT(remain)->prev_phys = remain;
+        eos_heap_insert(ctrl, remain);
+        size_block = size;
+    }
+    block->size = size_block;
+
+    me->used += (size_block + EOS_HEAP_BLOCK_HEAD);
+    if (me->used > me->peak)
+    {
+        me->peak = me->used;
+    }
+    me->alloc_count ++;
+    me->error_id = 0;
+
+    return HEAP_BLOCK_PAYLOAD(block);
+}
+
+void eos_heap_free(eos_heap_t *const me, void *data)
+{
+    eos_heap_block_t *block = HEAP_BLOCK_FROM_PAYLOAD(data);
+
+    /* Check the block is a used block of this heap. */
+    if ((eos_u8_t *)block < me->data ||
+        (eos_u8_t *)block >= (me->data + me->size - EOS_HEAP_BLOCK_HEAD) ||
+        ((eos_pointer_t)data % EOS_HEAP_ALIGN) != 0 ||
+        HEAP_BLOCK_IS_FREE(block) ||
+        HEAP_BLOCK_SIZE(block) == 0 ||
+        (eos_u8_t *)HEAP_BLOCK_NEXT(block) >
+            (me->data + me->size - EOS_HEAP_BLOCK_HEAD) ||
+        HEAP_BLOCK_NEXT(block)->prev_phys != block ||
+        (block->prev_phys != EOS_NULL &&
+         HEAP_BLOCK_NEXT(block->prev_phys) != block))
+    {
+        me->error_id = 4;
+        return;
+    }
+
+    eos_heap_ctrl_t *ctrl = me->ctrl;
+    me->used -= (HEAP_BLOCK_SIZE(block) + EOS_HEAP_BLOCK_HEAD);
+    me->free_count ++;
+
+    /* Coalesce with the previous physical block. */
+    eos_heap_block_t *prev = block->prev_phys;
+    if (prev != EOS_NULL && HEAP_BLOCK_IS_FREE(prev) &&
+        (HEAP_BLOCK_SIZE(prev) + EOS_HEAP_BLOCK_HEAD + HEAP_BLOCK_SIZE(block))
+            <= ctrl->block_max)
+    {
+        eos_heap_remove(ctrl, prev);
+        prev->size = HEAP_BLOCK_SIZE(prev) + EOS_HEAP_BLOCK_HEAD + block->size;
+        block = prev;
+        HEAP_BLOCK_NEXT(block)->prev_phys = block;
+    }
+
+    /* Coalesce with the next physical block. */
+    eos_heap_block_t *next = HEAP_BLOCK_NEXT(block);
+    if (HEAP_BLOCK_IS_FREE(next) &&
+        (HEAP_BLOCK_SIZE(block) + EOS_HEAP_BLOCK_HEAD + HEAP_BLOCK_SIZE(next))
+            <= ctrl->block_max)
+    {
+        eos_heap_remove(ctrl, next);
+        block->size = HEAP_BLOCK_SIZE(block) + EOS_HEAP_BLOCK_HEAD +
+                      HEAP_BLOCK_SIZE(next);
+        HEAP_BLOCK_NEXT(block)->prev_phys = block;
+    }
+
+    eos_heap_insert(ctrl, block);
+
+    me->error_id = 0;
+}
+
+eos_heap_t *eos_heap_get(eos_u8_t heap_id)
+{
+    if (heap_id == EosHeap_Event)
+    {
+        return &eos.heap;
+    }
+
+    EOS_ASSERT(heap_id == EosHeap_Db);
+    return &eos.db;
+}
+
+/* The fragmentation index is 100 * (1 - largest free block / free bytes). It
+   is 0 if all free bytes are in one block, and gets close to 100 when the free
+   bytes are scattered in small blocks. */
+void eos_heap_stat(eos_heap_t *const me, eos_heap_stat_t *stat)
+{
+    EOS_ASSERT(me->ctrl != EOS_NULL);
+    EOS_ASSERT(stat != EOS_NULL);
+
+    register eos_base_t level = eos_hw_interrupt_disable();
+
+    stat->total = me->size;
+    stat->used = me->used;
+    stat->peak = me->peak;
+    stat->alloc_count = me->alloc_count;
+    stat->free_count = me->free_count;
+    stat->failed_count = me->failed_count;
+    stat->free_size = 0;
+    stat->free_blocks = 0;
+    stat->largest_free = 0;
+
+    eos_heap_block_t *block = (eos_heap_block_t *)me->data;
+    while (HEAP_BLOCK_SIZE(block) != 0)
+    {
+        if (HEAP_BLOCK_IS_FREE(block))
+        {
+            stat->free_size += HEAP_BLOCK_SIZE(block);
+            stat->free_blocks ++;
+            if (HEAP_BLOCK_SIZE(block) > stat->largest_free)
+            {
+                stat->largest_free = HEAP_BLOCK_SIZE(block);
+            }
+        }
+        block = HEAP_BLOCK_NEXT(block);
+    }
+
+    eos_hw_interrupt_enable(level);
+
+    stat->frag = 0;
+    if (stat->free_size != 0)
+    {
+        stat->frag = 100 - (eos_u32_t)((eos_u64_t)stat->largest_free * 100 /
+                                        stat->free_size);
+    }
 }
-#endif
-#endif
 
-/* private heap function ---------------------------------------------------- */
-void eos_heap_init(eos_heap_t *const me, void *data, eos_u32_t size)
+void eos_heap_walk(eos_heap_t *const me,
+                    eos_heap_walker_t walker, void *parameter)
 {
-    EOS_ASSERT(data != EOS_NULL);
-    EOS_ASSERT(size > sizeof(eos_heap_block_t));
+    EOS_ASSERT(me->ctrl != EOS_NULL);
+    EOS_ASSERT(walker != EOS_NULL);
 
-    eos_u32_t mod = ((eos_u32_t)data % 4);
-    if (mod != 0)
+    register eos_base_t level = eos_hw_interrupt_disable();
+
+    eos_heap_block_t *block = (eos_heap_block_t *)me->data;
+    while (HEAP_BLOCK_SIZE(block) != 0)
     {
-        data = (void *)((eos_u32_t)data + 4 - mod);
-        size = size - 4;
+        walker(HEAP_BLOCK_PAYLOAD(block), HEAP_BLOCK_SIZE(block),
+               !HEAP_BLOCK_IS_FREE(block), parameter);
+        block = HEAP_BLOCK_NEXT(block);
     }
-    
-    /* block start */
-    me->data = data;
-    me->list = (eos_heap_block_t *)me->data;
-    me->size = size;
-    me->error_id = 0;
 
-    /* the 1st free block */
-    eos_heap_block_t *block_1st;
-    block_1st = (eos_heap_block_t *)me->data;
-    block_1st->next = EOS_NULL;
-    block_1st->size = size - (eos_u32_t)sizeof(eos_heap_block_t);
-    block_1st->is_free = 1;
+    eos_hw_interrupt_enable(level);
 }
 
-void * eos_heap_malloc(eos_heap_t *const me, eos_u32_t size)
+/* private heap function ---------------------------------------------------- */
+/* The index of the most significant set bit. */
+static eos_s32_t eos_heap_fls(eos_u32_t word)
 {
-    eos_heap_block_t *block;
-    
-    if (size == 0)
+    eos_s32_t bit = 31;
+
+    if ((word & 0xffff0000U) == 0) { word <<= 16; bit -= 16; }
+    if ((word & 0xff000000U) == 0) { word <<= 8; bit -= 8; }
+    if ((word & 0xf0000000U) == 0) { word <<= 4; bit -= 4; }
+    if ((word & 0xc0000000U) == 0) { word <<= 2; bit -= 2; }
+    if ((word & 0x80000000U) == 0) { bit -= 1; }
+
+    return bit;
+}
+
+static void eos_heap_mapping(eos_heap_ctrl_t *ctrl,
+                                eos_u32_t size, eos_u32_t *fl, eos_u32_t *sl)
+{
+    /* The small blocks are in the first list, linearly by the alignment. */
+    if (size < (1U << EOS_HEAP_FL_SHIFT))
     {
-        me->error_id = 1;
-        return EOS_NULL;
+        *fl = 0;
+        *sl = size >> EOS_HEAP_ALIGN_LOG2;
     }
-
-    eos_u32_t mod = (size % 4);
-    if (mod != 0)
+    else
     {
-        size = size + 4 - mod;
+        eos_s32_t bit = eos_heap_fls(size);
+        *sl = (size >> (bit - EOS_HEAP_SL_LOG2)) ^ EOS_HEAP_SL_COUNT;
+        *fl = bit - (EOS_HEAP_FL_SHIFT - 1);
     }
 
-    /* Find the first free block in the block-list. */
-    block = (eos_heap_block_t *)me->list;
-    do
-    {
-        if (block->is_free == 1 &&
-            block->size > (size + sizeof(eos_heap_block_t)))
-        {
-            break;
-        }
-        else
-        {
-            block = block->next;
-        }
-    } while (block != EOS_NULL);
+    EOS_ASSERT(*fl < ctrl->fl_count && *sl < EOS_HEAP_SL_COUNT);
+}
 
-    if (block == EOS_NULL)
+static void eos_heap_insert(eos_heap_ctrl_t *ctrl, eos_heap_block_t *block)
+{
+    eos_u32_t fl, sl;
+    eos_heap_mapping(ctrl, HEAP_BLOCK_SIZE(block), &fl, &sl);
+
+    eos_heap_block_t *head = ctrl->list[fl].blocks[sl];
+    block->size |= EOS_HEAP_BLOCK_FREE;
+    block->prev_free = EOS_NULL;
+    block->next_free = head;
+    if (head != EOS_NULL)
     {
-        me->error_id = 2;
-        return EOS_NULL;
+        head->prev_free = block;
     }
+    ctrl->list[fl].blocks[sl] = block;
+
+    ctrl->fl_bitmap |= (1U << fl);
+    ctrl->list[fl].sl_bitmap |= (1U << sl);
+}
+
+static void eos_heap_remove(eos_heap_ctrl_t *ctrl, eos_heap_block_t *block)
+{
+    eos_u32_t fl, sl;
+    eos_heap_mapping(ctrl, HEAP_BLOCK_SIZE(block), &fl, &sl);
 
-    /* If the block's byte number is NOT enough to create a new block. */
-    if (block->size <= (eos_u32_t)((eos_u32_t)size + sizeof(eos_heap_block_t)))
+    if (block->prev_free != EOS_NULL)
     {
-        block->is_free = 0;
+        block->prev_free->next_free = block->next_free;
     }
-    /* Divide the block into two blocks. */
     else
     {
-        eos_heap_block_t *new_block
-            = (eos_heap_block_t *)((eos_u32_t)block + size + sizeof(eos_heap_block_t));
-        new_block->size = block->size - size - sizeof(eos_heap_block_t);
-        new_block->is_free = 1;
-        new_block->next = EOS_NULL;
+        ctrl->list[fl].blocks[sl] = block->next_free;
+    }
+    if (block->next_free != EOS_NULL)
+    {
+        block->next_free->prev_free = block->prev_free;
+    }
+    block->size &= ~EOS_HEAP_BLOCK_FREE;
 
-        /* Update the list. */
-        new_block->next = block->next;
-        block->next = new_block;
-        block->size = size;
-        block->is_free = 0;
+    /* Clear the bitmaps if the list is empty. */
+    if (ctrl->list[fl].blocks[sl] == EOS_NULL)
+    {
+        ctrl->list[fl].sl_bitmap &= ~(1U << sl);
+        if (ctrl->list[fl].sl_bitmap == 0)
+        {
+            ctrl->fl_bitmap &= ~(1U << fl);
+        }
     }
+}
 
-    me->error_id = 0;
+/* private hash function ---------------------------------------------------- */
+static eos_u32_t eos_hash_time33(char ch_type, const char *string)
+{
+    eos_u32_t hash = 5381;
+    hash += (hash << 5) + ch_type;
+    while (*string)
+    {
+        hash += (hash << 5) + (*string++);
+    }
 
-    return (void *)((eos_u32_t)block + (eos_u32_t)sizeof(eos_heap_block_t));
+    return (eos_u32_t)(hash & (0x7fffffff));
 }
 
-void eos_heap_free(eos_heap_t *const me, void * data)
+/* The displacement of the object in the slot from its home slot. */
+eos_inline eos_u16_t eos_hash_distance(eos_u16_t id, eos_u16_t index)
 {
-    eos_heap_block_t *block_crt =
-        (eos_heap_block_t *)((eos_u32_t)data - sizeof(eos_heap_block_t));
+    eos_u16_t home = eos.object[id].hash % eos.prime_max;
 
-    /* Search for this block in the block-list. */
-    eos_heap_block_t *block = me->list;
-    eos_heap_block_t *block_last = EOS_NULL;
-    do
+    return (eos_u16_t)((index + EOS_MAX_OBJECTS - home) % EOS_MAX_OBJECTS);
+}
+
+/* Put the object into the slots by Robin Hood probing. The object farther from
+   its home slot takes the slot of the nearer one, which then moves on, so the
+   displacements are kept even and small even if the table is almost full. */
+static void eos_hash_slot_insert(eos_u16_t id)
+{
+    eos_u16_t index = eos.object[id].hash % eos.prime_max;
+    eos_u16_t distance = 0;
+
+    for (eos_u32_t i = 0; i < EOS_MAX_OBJECTS; i++)
     {
-        if (block->is_free == 0 && block == block_crt)
+        eos_u16_t id_slot = eos.slot[index];
+        if (id_slot == EOS_MAX_OBJECTS)
         {
-            break;
+            eos.slot[index] = id;
+            eos.probe_max = (distance > eos.probe_max) ? distance : eos.probe_max;
+            return;
         }
-        else
+
+        eos_u16_t distance_slot = eos_hash_distance(id_slot, index);
+        if (distance_slot < distance)
         {
-            block_last = block;
-            block = block->next;
+            eos.slot[index] = id;
+            eos.probe_max = (distance > eos.probe_max) ? distance : eos.probe_max;
+            id = id_slot;
+            distance = distance_slot;
         }
-    } while (block != EOS_NULL);
 
-    /* Not found. */
-    if (block == EOS_NULL)
+        index = (index + 1) % EOS_MAX_OBJECTS;
+        distance ++;
+    }
+
+    /* The slots are as many as the objects, and never run out. */
+    EOS_ASSERT(0);
+}
+
+/* Remove the object from the slots by backward shift. The objects behind it in
+   the same run move one slot back towards their home slots, so no tombstone is
+   left, and the lookups still stop at the first empty slot. */
+static void eos_hash_delete(eos_u16_t id)
+{
+#if (EOS_USE_PHASH != 0)
+    /* The ID of the static object is kept for its key. */
+    if (id < EOS_PHASH_NUM)
     {
-        me->error_id = 4;
+        memset(&eos.object[id], 0, sizeof(eos_object_t));
         return;
     }
+#endif
 
-    block->is_free = 1;
-    /* Check the block can be combined with the front one. */
-    if (block_last != (eos_heap_block_t *)NULL && block_last->is_free == 1)
+    eos_u16_t index = eos.object[id].hash % eos.prime_max;
+    while (eos.slot[index] != id)
     {
-        block_last->size += (block->size + sizeof(eos_heap_block_t));
-        block_last->next = block->next;
-        block = block_last;
+        index = (index + 1) % EOS_MAX_OBJECTS;
     }
 
-    /* Check the block can be combined with the later one. */
-    if (block->next != (eos_heap_block_t *)EOS_NULL && block->next->is_free == 1)
+    bool probe_update = (eos_hash_distance(id, index) == eos.probe_max);
+    eos_u16_t index_next = (index + 1) % EOS_MAX_OBJECTS;
+    while (eos.slot[index_next] != EOS_MAX_OBJECTS)
     {
-        block->size += (block->next->size + (eos_u32_t)sizeof(eos_heap_block_t));
-        block->next = block->next->next;
-        block->is_free = 1;
+        eos_u16_t distance = eos_hash_distance(eos.slot[index_next], index_next);
+        if (distance == 0)
+        {
+            break;
+        }
+        if (distance == eos.probe_max)
+        {
+            probe_update = true;
+        }
+        eos.slot[index] = eos.slot[index_next];
+        index = index_next;
+        index_next = (index + 1) % EOS_MAX_OBJECTS;
     }
+    eos.slot[index] = EOS_MAX_OBJECTS;
 
-    me->error_id = 0;
-}
-
-/* private hash function ---------------------------------------------------- */
-static char ch_type[EosObj_Max] = { 'A', 'E', 'T' };
+    /* The object is cleared as a new one, and its ID is left for reuse. */
+    memset(&eos.object[id], 0, sizeof(eos_object_t));
+    eos.object_free ++;
 
-static eos_u32_t eos_hash_time33(char ch_type, const char *string)
-{
-    eos_u32_t hash = 5381;
-    hash += (hash << 5) + ch_type;
-    while (*string)
+    /* The longest probe may be shortened, and then it is counted again. */
+    if (probe_update)
     {
-        hash += (hash << 5) + (*string++);
+        eos.probe_max = 0;
+        for (eos_u16_t i = 0; i < EOS_MAX_OBJECTS; i++)
+        {
+            if (eos.slot[i] != EOS_MAX_OBJECTS)
+            {
+                eos_u16_t distance = eos_hash_distance(eos.slot[i], i);
+                eos.probe_max = (distance > eos.probe_max) ? distance : eos.probe_max;
+            }
+        }
     }
-
-    return (eos_u32_t)(hash & (0x7fffffff));
 }
 
 static eos_u16_t eos_hash_insert(eos_u8_t obj_type, const char *string)
 {
-    eos_u16_t index = 0;
+    eos_u16_t index = eos_hash_get_index(obj_type, string);
+    if (index != EOS_MAX_OBJECTS)
+    {
+        return index;
+    }
 
-    /* Calculate the hash value of the string. */
+#if (EOS_USE_PHASH != 0)
+    /* The static key takes its own ID, out of the slots. */
     eos_u32_t hash = eos_hash_time33(ch_type[obj_type], string);
-    eos_u16_t index_init = hash % eos.prime_max;
+    index = eos_phash_get(obj_type, hash, string);
+    if (index != EOS_MAX_OBJECTS)
+    {
+        eos.object[index].key = string;
+        eos.object[index].hash = hash;
+        eos.object[index].type = obj_type;
+
+        return index;
+    }
+#endif
 
-    for (eos_u16_t i = 0; i < (EOS_MAX_OBJECTS / 2 + 1); i++)
+    /* The ID of the deleted object is reused first. */
+    if (eos.object_free != 0)
     {
-        for (eos_s8_t j = -1; j <= 1; j += 2)
+        for (index = EOS_PHASH_NUM; index < eos.object_count; index++)
         {
-            index = index_init + i * j + 2 * (eos_s16_t)EOS_MAX_OBJECTS;
-            index %= EOS_MAX_OBJECTS;
-
-            /* Find the empty object. */
             if (eos.object[index].key == (const char *)0)
             {
-                eos.object[index].key = string;
-                goto exit;
-            }
-            if (strcmp(eos.object[index].key, string) == 0 &&
-                eos.object[index].type == obj_type)
-            {
-                goto exit;
+                break;
             }
         }
-
-        /* Ensure the finding speed is not slow. */
-        if (i >= EOS_MAX_HASH_SEEK_TIMES)
-        {
-            /* If this assert is trigged, you need to enlarge the hash table size. */
-            EOS_ASSERT(0);
-        }
+        EOS_ASSERT(index < eos.object_count);
+        eos.object_free --;
     }
+    else
+    {
+        /* If this assert is trigged, you need to enlarge the hash table size. */
+        EOS_ASSERT(eos.object_count < EOS_MAX_OBJECTS);
+        index = eos.object_count ++;
+    }
+    eos.object[index].key = string;
+    eos.object[index].hash = eos_hash_time33(ch_type[obj_type], string);
+    eos.object[index].type = obj_type;
+    eos_hash_slot_insert(index);
 
-exit:
     return index;
 }
 
 static eos_u16_t eos_hash_get_index(eos_u8_t obj_type, const char *string)
 {
-    eos_u16_t index = 0;
-
     /* Calculate the hash value of the string. */
     eos_u32_t hash = eos_hash_time33(ch_type[obj_type], string);
-    eos_u16_t index_init = hash % eos.prime_max;
+    eos.lookup_count ++;
 
-    for (eos_u16_t i = 0; i < (EOS_MAX_OBJECTS / 2 + 1); i++)
+#if (EOS_USE_PHASH != 0)
+    eos_u16_t id_static = eos_phash_get(obj_type, hash, string);
+    if (id_static != EOS_MAX_OBJECTS)
     {
-        for (eos_s8_t j = -1; j <= 1; j += 2)
+        eos.lookup_probe ++;
+        if (eos.object[id_static].key == (const char *)0)
         {
-            index = index_init + i * j + 2 * (eos_s16_t)EOS_MAX_OBJECTS;
-            index %= EOS_MAX_OBJECTS;
-
-            if (eos.object[index].key != (const char *)0 &&
-                eos.object[index].type == obj_type &&
-                strcmp(eos.object[index].key, string) == 0)
-            {
-                goto exit;
-            }
+            eos.lookup_miss ++;
+            return EOS_MAX_OBJECTS;
         }
 
-        /* Ensure the finding speed is not slow. */
-        if (i >= EOS_MAX_HASH_SEEK_TIMES)
+        return id_static;
+    }
+#endif
+
+    /* The key is compared only if the whole hash is the same, and the probing
+       stops at the object nearer to its home slot than the key would be. */
+    eos_u16_t index = hash % eos.prime_max;
+    for (eos_u16_t distance = 0; distance <= eos.probe_max; distance++)
+    {
+        eos.lookup_probe ++;
+        eos_u16_t id = eos.slot[index];
+        if (id == EOS_MAX_OBJECTS || eos_hash_distance(id, index) < distance)
         {
-            index = EOS_MAX_OBJECTS;
-            goto exit;
+            break;
+        }
+        if (eos.object[id].hash == hash &&
+            eos.object[id].type == obj_type &&
+            strcmp(eos.object[id].key, string) == 0)
+        {
+            return id;
         }
+
+        index = (index + 1) % EOS_MAX_OBJECTS;
     }
+    eos.lookup_miss ++;
 
-exit:
-    return index;
+    return EOS_MAX_OBJECTS;
 }
 
 static bool eos_hash_existed(eos_u8_t obj_type, const char *string)
 {
-    bool ret = false;
+    return (eos_hash_get_index(obj_type, string) != EOS_MAX_OBJECTS) ? true : false;
+}
+
+#if (EOS_USE_PHASH != 0)
+/* The ID of the static key given by the perfect hash. */
+eos_inline eos_u16_t eos_phash_index(eos_u32_t hash)
+{
+    eos_u32_t x = hash ^
+                  ((eos_u32_t)eos_phash_disp[hash % EOS_TOPIC_PHASH_BUCKETS] *
+                   0x9e3779b9U);
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
 
-    /* Calculate the hash value of the string. */
-    eos_u32_t hash = eos_hash_time33(ch_type[obj_type], string);
-    eos_u16_t index_init = hash % eos.prime_max;
+    return (eos_u16_t)(x % EOS_TOPIC_NUM);
+}
 
-    for (eos_u16_t i = 0; i < (EOS_MAX_OBJECTS / 2 + 1); i++)
+/* Return the ID if the key is static, created or not, or EOS_MAX_OBJECTS if it
+   is a dynamic one. */
+static eos_u16_t eos_phash_get(eos_u8_t obj_type,
+                                eos_u32_t hash, const char *string)
+{
+    eos_u16_t id = eos_phash_index(hash);
+    if (eos_phash_key[id].hash == hash &&
+        eos_phash_key[id].type == obj_type &&
+        strcmp(eos_phash_key[id].key, string) == 0)
     {
-        for (eos_s8_t j = -1; j <= 1; j += 2)
-        {
-            eos_u16_t index = index_init + i * j + 2 * (eos_s16_t)EOS_MAX_OBJECTS;
-            index %= EOS_MAX_OBJECTS;
+        return id;
+    }
 
-            if (eos.object[index].key != (const char *)0 &&
-                eos.object[index].type == obj_type &&
-                strcmp(eos.object[index].key, string) == 0)
-            {
-                ret = true;
-                goto exit;
-            }
-        }
+    return EOS_MAX_OBJECTS;
+}
+#endif
 
-        /* Ensure the finding speed is not slow. */
-        if (i >= EOS_MAX_HASH_SEEK_TIMES)
-        {
-            goto exit;
-        }
+/* private stream function -------------------------------------------------- */
+/* Convert the running counter into the index of the ring buffer. */
+static inline eos_u32_t eos_stream_index(eos_stream_t *const me, eos_u32_t count)
+{
+    if (me->mask != 0)
+    {
+        return (count & me->mask);
     }
 
-exit:
-    return ret;
+    return (count < me->capacity) ? count : (count - me->capacity);
+}
+
+/* Move the running counter forward by size bytes. */
+static inline eos_u32_t eos_stream_forward(eos_stream_t *const me,
+                                            eos_u32_t count, eos_u32_t size)
+{
+    count += size;
+    if (count >= (me->capacity << 1))
+    {
+        count -= (me->capacity << 1);
+    }
+
+    return count;
 }
 
-/* private stream function -------------------------------------------------- */
 static eos_s32_t eos_stream_init(eos_stream_t *const me, void *memory, eos_u32_t capacity)
 {
-    me->data = memory;
+    EOS_ASSERT(capacity != 0 && capacity < 0x80000000U);
+
+    me->data = (eos_u8_t *)memory;
     me->capacity = capacity;
+    me->mask = ((capacity & (capacity - 1)) == 0) ? (capacity - 1) : 0;
     me->head = 0;
     me->tail = 0;
-    me->empty = true;
 
     return Stream_OK;
 }
@@ -2003,80 +3585,201 @@ static eos_s32_t eos_stream_push(eos_stream_t *const me, void * data, eos_u32_t
         return Stream_NotEnough;
     }
 
-    eos_u8_t *stream = (eos_u8_t *)me->data;
-    for (int i = 0; i < size; i++)
+    /* Copy the data in at most two segments, before and after the wrap. */
+    eos_u32_t index = eos_stream_index(me, me->head);
+    eos_u32_t size_1st = me->capacity - index;
+    if (size_1st > size)
     {
-        stream[me->head] = ((eos_u8_t *)data)[i];
-        me->head = ((me->head + 1) % me->capacity);
+        size_1st = size;
     }
-    me->empty = false;
+    memcpy(&me->data[index], data, size_1st);
+    memcpy(me->data, (eos_u8_t *)data + size_1st, size - size_1st);
+    EOS_STORE_RELEASE(&me->head, eos_stream_forward(me, me->head, size));
 
     return Stream_OK;
 }
 
 static eos_s32_t eos_stream_pull_pop(eos_stream_t *const me, void * data, eos_u32_t size)
 {
-    if (me->empty)
+    eos_u32_t size_stream = eos_stream_size(me);
+    size = (size_stream < size) ? size_stream : size;
+    if (size == 0)
     {
         return 0;
     }
 
-    eos_u32_t size_stream = eos_stream_size(me);
-    size = (size_stream < size) ? size_stream : size;
-
-    eos_u8_t *stream = (eos_u8_t *)me->data;
-    for (int i = 0; i < size; i++)
+    /* Copy the data out in at most two segments, before and after the wrap. */
+    eos_u32_t index = eos_stream_index(me, me->tail);
+    eos_u32_t size_1st = me->capacity - index;
+    if (size_1st > size)
     {
-        ((eos_u8_t *)data)[i] = stream[me->tail];
-        me->tail = (me->tail + 1) % me->capacity;
+        size_1st = size;
     }
-    
-    if (me->tail == me->head)
+    memcpy(data, &me->data[index], size_1st);
+    memcpy((eos_u8_t *)data + size_1st, me->data, size - size_1st);
+    EOS_STORE_RELEASE(&me->tail, eos_stream_forward(me, me->tail, size));
+
+    return size;
+}
+
+static bool eos_stream_full(eos_stream_t *const me)
+{
+    return (eos_stream_size(me) == me->capacity) ? true : false;
+}
+
+/* The head is only moved by the producer and the tail only by the consumer, so
+   the stream works without the lock for one producer and one consumer. Each
+   side loads the counter of the other side with acquire, and moves its own
+   counter with release after the data is copied. */
+static eos_u32_t eos_stream_size(eos_stream_t *const me)
+{
+    eos_u32_t head = EOS_LOAD_ACQUIRE(&me->head);
+    eos_u32_t tail = EOS_LOAD_ACQUIRE(&me->tail);
+
+    return (head >= tail) ? (head - tail) : (head + (me->capacity << 1) - tail);
+}
+
+static eos_u32_t eos_stream_empty_size(eos_stream_t *const me)
+{
+    return me->capacity - eos_stream_size(me);
+}
+
+/* Get the contiguous free memory at the head, to be written in place. */
+static eos_u32_t eos_stream_reserve(eos_stream_t *const me, void **buffer)
+{
+    eos_u32_t index = eos_stream_index(me, me->head);
+    eos_u32_t size = eos_stream_empty_size(me);
+    if (size > (me->capacity - index))
     {
-        me->tail = 0;
-        me->head = 0;
-        me->empty = true;
+        size = me->capacity - index;
     }
+    *buffer = &me->data[index];
 
     return size;
 }
 
-static bool eos_stream_full(eos_stream_t *const me)
+static void eos_stream_commit(eos_stream_t *const me, eos_u32_t size)
+{
+    EOS_ASSERT(size <= eos_stream_empty_size(me));
+    EOS_STORE_RELEASE(&me->head, eos_stream_forward(me, me->head, size));
+}
+
+/* Get the contiguous data at the tail, to be read in place. */
+static eos_u32_t eos_stream_peek(eos_stream_t *const me, void **buffer)
 {
-    eos_s32_t size = me->head - me->tail;
-    if (size < 0)
+    eos_u32_t index = eos_stream_index(me, me->tail);
+    eos_u32_t size = eos_stream_size(me);
+    if (size > (me->capacity - index))
     {
-        size += me->capacity;
+        size = me->capacity - index;
     }
+    *buffer = &me->data[index];
+
+    return size;
+}
 
-    return (size == 0 && me->empty == false) ? true : false;
+static void eos_stream_consume(eos_stream_t *const me, eos_u32_t size)
+{
+    EOS_ASSERT(size <= eos_stream_size(me));
+    EOS_STORE_RELEASE(&me->tail, eos_stream_forward(me, me->tail, size));
 }
 
-static eos_s32_t eos_stream_size(eos_stream_t *const me)
+/* private event pool function --------------------------------------------- */
+static void eos_event_pool_init(void)
 {
-    if (me->empty == true)
+    eos.e_pool.free = EOS_NULL;
+    eos.e_pool.used = 0;
+    eos.e_pool.peak = 0;
+    eos.e_pool.exhausted = 0;
+
+#if (EOS_EVENT_POOL_SIZE != 0)
+    /* Link all blocks into the free list. */
+    for (eos_u32_t i = 0; i < EOS_EVENT_POOL_SIZE; i ++)
     {
-        return 0;
+        eos.e_block[i].next = eos.e_pool.free;
+        eos.e_pool.free = &eos.e_block[i];
+    }
+#endif
+}
+
+/* It must be called between eos_hw_interrupt_disable and
+   eos_hw_interrupt_enable. */
+static inline eos_event_data_t *eos_event_alloc(void)
+{
+    eos_event_block_t *block = eos.e_pool.free;
+
+    /* The pool is used up, fall back to the heap. */
+    if (block == EOS_NULL)
+    {
+        eos.e_pool.exhausted ++;
+        return eos_heap_malloc(&eos.heap, sizeof(eos_event_data_t));
     }
 
-    eos_s32_t size = me->head - me->tail;
-    if (size <= 0)
+    eos.e_pool.free = block->next;
+    eos.e_pool.used ++;
+    if (eos.e_pool.used > eos.e_pool.peak)
     {
-        size += me->capacity;
+        eos.e_pool.peak = eos.e_pool.used;
     }
 
-    return size;
+    return &block->data;
 }
 
-static eos_s32_t eos_stream_empty_size(eos_stream_t *const me)
+/* It must be called between eos_hw_interrupt_disable and
+   eos_hw_interrupt_enable. */
+static inline void eos_event_free(eos_event_data_t *e_item)
 {
-    return me->capacity - eos_stream_size(me);
+#if (EOS_EVENT_POOL_SIZE != 0)
+    eos_event_block_t *block = (eos_event_block_t *)e_item;
+
+    /* The record is in the pool, or else it is from the heap. */
+    if (block >= &eos.e_block[0] && block < &eos.e_block[EOS_EVENT_POOL_SIZE])
+    {
+        block->next = eos.e_pool.free;
+        eos.e_pool.free = block;
+        eos.e_pool.used --;
+        return;
+    }
+#endif
+
+    eos_heap_free(&eos.heap, (void *)e_item);
+}
+
+/* private mailbox function ------------------------------------------------- */
+static inline void eos_mailbox_push(eos_task_handle_t const task,
+                                    eos_event_data_t *e_item)
+{
+    e_item->next = EOS_NULL;
+    if (task->e_tail == EOS_NULL)
+    {
+        task->e_head = e_item;
+    }
+    else
+    {
+        task->e_tail->next = e_item;
+    }
+    task->e_tail = e_item;
+}
+
+static inline eos_event_data_t *eos_mailbox_pop(eos_task_handle_t const task)
+{
+    eos_event_data_t *e_item = task->e_head;
+    if (e_item != EOS_NULL)
+    {
+        task->e_head = e_item->next;
+        if (task->e_head == EOS_NULL)
+        {
+            task->e_tail = EOS_NULL;
+        }
+    }
+
+    return e_item;
 }
 
 /* private owner function --------------------------------------------------- */
 static inline bool owner_is_occupied(eos_owner_t *owner, eos_u32_t t_index)
 {
-    if (owner->data[t_index >> 3] & (1 << (t_index % 8)))
+    if (owner->data[t_index >> 5] & (1U << (t_index & 31)))
     {
         return true;
     }
@@ -2098,11 +3801,11 @@ static inline void owner_set_bit(eos_owner_t *owner, eos_u32_t t_id, bool status
 {
     if (status == true)
     {
-        owner->data[t_id >> 3] |= (1 << (t_id % 8));
+        owner->data[t_id >> 5] |= (1U << (t_id & 31));
     }
     else
     {
-        owner->data[t_id >> 3] &= ~(1 << (t_id % 8));
+        owner->data[t_id >> 5] &= ~(1U << (t_id & 31));
     }
 }
 
@@ -2121,6 +3824,37 @@ static inline bool owner_all_cleared(eos_owner_t *owner)
     return all_cleared;
 }
 
+/* Mask the owner by the other one, and return true if any bit is left. */
+static inline bool owner_and(eos_owner_t *g_owner, eos_owner_t *owner)
+{
+    eos_u32_t left = 0;
+    for (eos_u32_t i = 0; i < EOS_MAX_OWNER; i++)
+    {
+        g_owner->data[i] &= owner->data[i];
+        left |= g_owner->data[i];
+    }
+
+    return (left != 0) ? true : false;
+}
+
+/* Clear the lowest set bit and return its index, or EOS_MAX_TASKS if no bit is
+   set, so only the set bits are visited. */
+static inline eos_u32_t owner_pop(eos_owner_t *owner)
+{
+    for (eos_u32_t i = 0; i < EOS_MAX_OWNER; i++)
+    {
+        eos_u32_t word = owner->data[i];
+        if (word != 0)
+        {
+            owner->data[i] = word & (word - 1);
+
+            return (i << 5) + (eos_u32_t)__eos_ffs((int)word) - 1;
+        }
+    }
+
+    return EOS_MAX_TASKS;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -72,6 +72,38 @@ EventOS Default Configuration
 #define EOS_USE_EVENT_BRIDGE                    0
 #endif
 
+#ifndef EOS_HEAP_FL_INDEX_MAX
+#define EOS_HEAP_FL_INDEX_MAX                   24
+#endif
+
+#ifndef EOS_EVENT_POOL_SIZE
+#define EOS_EVENT_POOL_SIZE                     64
+#endif
+
+#ifndef EOS_USE_TOPIC_TABLE
+#define EOS_USE_TOPIC_TABLE                     0
+#endif
+
+#ifndef EOS_DB_VALUE_BUFFERS
+#define EOS_DB_VALUE_BUFFERS                    3
+#endif
+
+#ifndef EOS_USE_DB_DELTA
+#define EOS_USE_DB_DELTA                        1
+#endif
+
+#ifndef EOS_DB_SNAPSHOT_MAX
+#define EOS_DB_SNAPSHOT_MAX                     16
+#endif
+
+#ifndef EOS_DB_SNAPSHOT_RETRY
+#define EOS_DB_SNAPSHOT_RETRY                   3
+#endif
+
+#ifndef EOS_DB_READ_RETRY
+#define EOS_DB_READ_RETRY                       3
+#endif
+
 /* -----------------------------------------------------------------------------
 Includes
 ----------------------------------------------------------------------------- */
@@ -99,6 +131,12 @@ void eos_interrupt_leave(void);
 eos_u8_t eos_interrupt_get_nest(void);
 eos_base_t eos_hw_interrupt_disable(void);
 void eos_hw_interrupt_enable(eos_base_t level);
+#ifdef EOS_USING_TICKLESS
+/* Implemented by the port for the tickless idle. Called with the interrupts
+   disabled, it stops the tick, sleeps until the ticks pass or any interrupt
+   comes, and returns the ticks passed. EOS_WAIT_FOREVER means no timeout. */
+eos_u32_t eos_hw_tick_sleep(eos_u32_t tick);
+#endif
 
 /* -----------------------------------------------------------------------------
 Task
@@ -153,18 +191,23 @@ typedef struct eos_timer *eos_timer_handle_t;
 #define EOS_TASK_CTRL_INFO             0x03                /**< Get task information. */
 #define EOS_TASK_CTRL_BIND_CPU         0x04                /**< Set task bind cpu. */
 
+struct eos_event_data;
+
 typedef struct eos_task
 {
 #if (EOS_USE_3RD_KERNEL == 0)
     ek_task_t task_;
 #endif
 
-    eos_u32_t task_handle;
+    eos_pointer_t task_handle;
     eos_sem_t sem;
     eos_u16_t index;
     bool event_recv_disable;
     bool wait_specific_event;
+    bool wait_chan;                         /* Woken only by the channel */
     const char *event_wait;
+    struct eos_event_data *e_head;          /* The head of the event mailbox. */
+    struct eos_event_data *e_tail;          /* The tail of the event mailbox. */
 } eos_task_t;
 
 typedef eos_task_t *eos_task_handle_t;
@@ -224,6 +267,13 @@ eos_u32_t eos_timer_remaining_time(eos_timer_handle_t timer);
 eos_err_t eos_timer_set_time(eos_timer_handle_t timer, eos_u32_t time);
 eos_u32_t eos_timer_get_time(eos_timer_handle_t timer);
 eos_err_t eos_timer_reset(eos_timer_handle_t timer);
+#ifdef EOS_USING_TIMER_SLACK
+/* The timer may be called up to slack ticks after its timeout, and is grouped
+   with the other timers of overlapping windows. The slack takes effect from
+   the next start or restart, and a running timer keeps its current window
+   until then. The time plus the slack should be less than EOS_TICK_MAX / 2. */
+eos_err_t eos_timer_set_slack(eos_timer_handle_t timer, eos_u32_t slack);
+#endif
 
 /* -----------------------------------------------------------------------------
 Semaphore
@@ -264,7 +314,16 @@ eos_err_t eos_mutex_release(eos_mutex_handle_t mutex);
 #endif
 
 /* Event interface ---------------------------------------------------------- */
+/* The topic handle is the object index of the topic, resolved once by the name
+   and used on the hot path without the hash lookup. */
+typedef eos_u16_t eos_topic_handle_t;
+
+eos_topic_handle_t eos_topic_handle(const char *topic);
+eos_u32_t eos_get_task_id(const char *task);
+
 void eos_event_send(const char *task, const char *topic);
+void eos_event_send_id(eos_u32_t task_id, const char *topic);
+void eos_event_send_h(eos_u32_t task_id, eos_topic_handle_t topic);
 void eos_event_send_delay(const char *task,
                             const char *topic,
                             eos_u32_t time_delay_ms);
@@ -273,30 +332,300 @@ void eos_event_send_period(const char *task,
                             eos_u32_t time_period_ms);
 
 void eos_event_publish(const char *topic);
+void eos_event_publish_h(eos_topic_handle_t topic);
 void eos_event_publish_delay(const char *topic, eos_u32_t time_delay_ms);
 void eos_event_publish_period(const char *topic, eos_u32_t time_period_ms);
 
+/* The timer is deleted from the object table on cancel, and the same topic can
+   be delayed or repeated again after it. */
 void eos_event_time_cancel(const char *topic);
+#ifdef EOS_USING_TIMER_SLACK
+/* The time event may come up to slack_ms late, grouped with the other timers.
+   It is called after the time event is published, so the slack takes effect
+   from the next period, when the timer is restarted. */
+void eos_event_time_slack(const char *topic, eos_u32_t slack_ms);
+#endif
 
 void eos_event_sub(const char *topic);
+void eos_event_sub_h(eos_topic_handle_t topic);
 void eos_event_unsub(const char *topic);
 
 bool eos_event_topic(eos_event_t const * const e, const char *topic);
 
+/* The statistics of the event record pool. */
+typedef struct eos_event_pool_stat
+{
+    eos_u16_t total;                        /* The number of the blocks. */
+    eos_u16_t used;                         /* The blocks in use now. */
+    eos_u16_t peak;                         /* The peak of the blocks in use. */
+    eos_u32_t exhausted;                    /* The times falling back to heap. */
+} eos_event_pool_stat_t;
+
+void eos_event_pool_stat(eos_event_pool_stat_t *stat);
+
+/* The statistics of the object hash table, for sizing EOS_MAX_OBJECTS and for
+   finding the colliding keys. The displacement is the distance of the object
+   from its home slot, which is the probes of its lookup minus 1. */
+#define EOS_HASH_HIST_SIZE                      8
+
+typedef struct eos_hash_stat
+{
+    eos_u16_t total;                        /* The number of the objects. */
+    eos_u16_t used;                         /* The objects in use now. */
+    eos_u16_t actor;                        /* The tasks. */
+    eos_u16_t event;                        /* The topics and the db keys. */
+    eos_u16_t timer;                        /* The time events. */
+    eos_u16_t load;                         /* 0 - 100, used / total. */
+    eos_u16_t probe_max;                    /* The longest displacement. */
+    eos_u16_t run_max;                      /* The longest run of used slots. */
+    eos_u16_t hist[EOS_HASH_HIST_SIZE];     /* The objects of each displacement,
+                                               the last one for all the longer. */
+    eos_u32_t lookup;                       /* The lookups, with the inserts. */
+    eos_u32_t miss;                         /* The lookups not found. */
+    eos_u32_t probe;                        /* The slots probed by the lookups. */
+} eos_hash_stat_t;
+
+/* The walker is called with the interrupt disabled, and the type is the prefix
+   of the object, 'A', 'E' or 'T'. */
+typedef void (* eos_hash_walker_t)(const char *key, char type,
+                                    eos_u16_t slot, eos_u16_t distance,
+                                    void *parameter);
+
+void eos_hash_stat(eos_hash_stat_t *stat);
+/* Walk the objects displaced at least distance_min, in the slot order. Walking
+   with the probe_max of the statistics lists the ends of the longest chains. */
+void eos_hash_walk(eos_u16_t distance_min,
+                    eos_hash_walker_t walker, void *parameter);
+
+/* -----------------------------------------------------------------------------
+Heap
+----------------------------------------------------------------------------- */
+/*
+ * The heap is a two-level segregated fit (TLSF) allocator. The free blocks are
+ * kept in the lists segregated by size, the first level by the power of two
+ * and the second level by EOS_HEAP_SL_COUNT linear steps in it. The bitmaps
+ * of the non-empty lists give the fitting list in O(1), and the boundary tags
+ * (the previous physical block in the block header) make the coalescing on
+ * free O(1). The control block lives at the start of the heap memory, and has
+ * one first level for each power of two up to the heap size, so the largest
+ * block is the whole heap, unless EOS_HEAP_FL_INDEX_MAX caps it to save RAM.
+ * Each first level takes 9 words (17 on the 64-bit), about 336 bytes for a
+ * heap of 4 - 8 KB on the 32-bit MCU.
+ */
+#if (UINTPTR_MAX > 0xffffffffU)
+#define EOS_HEAP_ALIGN_LOG2                     3
+#else
+#define EOS_HEAP_ALIGN_LOG2                     2
+#endif
+#define EOS_HEAP_ALIGN                          (1U << EOS_HEAP_ALIGN_LOG2)
+#define EOS_HEAP_SL_LOG2                        3
+#define EOS_HEAP_SL_COUNT                       (1U << EOS_HEAP_SL_LOG2)
+#define EOS_HEAP_FL_SHIFT                       (EOS_HEAP_SL_LOG2 + EOS_HEAP_ALIGN_LOG2)
+
+typedef struct eos_heap_block
+{
+    struct eos_heap_block *prev_phys;           /* The previous physical block */
+    eos_u32_t size;                             /* Bit 0 is the free flag */
+    /* The free-list links, only valid in the free block. */
+    struct eos_heap_block *next_free;
+    struct eos_heap_block *prev_free;
+} eos_heap_block_t;
+
+typedef struct eos_heap_list
+{
+    eos_u32_t sl_bitmap;
+    eos_heap_block_t *blocks[EOS_HEAP_SL_COUNT];
+} eos_heap_list_t;
+
+typedef struct eos_heap_ctrl
+{
+    eos_u32_t fl_bitmap;
+    eos_u32_t fl_count;
+    eos_u32_t block_max;                        /* The largest block size */
+    eos_heap_list_t list[];                     /* The first levels */
+} eos_heap_ctrl_t;
+
+typedef struct eos_heap_tag
+{
+    eos_heap_ctrl_t *ctrl;
+    eos_u8_t *data;                             /* The first block */
+    eos_u32_t size                              : 24;
+    eos_u32_t error_id                          : 8;
+
+    /* Statistics */
+    eos_u32_t used;                             /* Bytes in use, with heads */
+    eos_u32_t peak;                             /* The peak of used */
+    eos_u32_t alloc_count;
+    eos_u32_t free_count;
+    eos_u32_t failed_count;
+} eos_heap_t;
+
+typedef struct eos_heap_stat
+{
+    eos_u32_t total;                            /* Bytes of the blocks */
+    eos_u32_t used;                             /* Bytes in use, with heads */
+    eos_u32_t peak;                             /* The peak of used */
+    eos_u32_t alloc_count;                      /* Successful mallocs */
+    eos_u32_t free_count;                       /* Successful frees */
+    eos_u32_t failed_count;                     /* Failed mallocs */
+    eos_u32_t free_size;                        /* Bytes of all free blocks */
+    eos_u32_t free_blocks;                      /* The number of free blocks */
+    eos_u32_t largest_free;                     /* The largest free block */
+    eos_u32_t frag;                             /* 0 - 100, see eos_heap_stat */
+} eos_heap_stat_t;
+
+enum
+{
+    EosHeap_Event = 0,                          /* The heap of event records */
+    EosHeap_Db,                                 /* The heap of db keys */
+};
+
+/* The walker is called with the interrupt disabled, for each block in the
+   physical order, so it must be short. */
+typedef void (* eos_heap_walker_t)(void *data, eos_u32_t size,
+                                    bool used, void *parameter);
+
+void eos_heap_init(eos_heap_t *const me, void *data, eos_u32_t size);
+void *eos_heap_malloc(eos_heap_t *const me, eos_u32_t size);
+void eos_heap_free(eos_heap_t *const me, void *data);
+eos_heap_t *eos_heap_get(eos_u8_t heap_id);
+void eos_heap_stat(eos_heap_t *const me, eos_heap_stat_t *stat);
+void eos_heap_walk(eos_heap_t *const me,
+                    eos_heap_walker_t walker, void *parameter);
+
 /* -----------------------------------------------------------------------------
 Database
 ----------------------------------------------------------------------------- */
+/* Each write of the value key publishes the event of the key. */
 #define EOS_DB_ATTRIBUTE_LINK_EVENT      ((eos_u8_t)0x40U)
 #define EOS_DB_ATTRIBUTE_PERSISTENT      ((eos_u8_t)0x20U)
 #define EOS_DB_ATTRIBUTE_VALUE           ((eos_u8_t)0x01U)
 #define EOS_DB_ATTRIBUTE_STREAM          ((eos_u8_t)0x02U)
+/* The stream key is written by only one producer (an ISR or a task) and read by
+   only one consumer, and is accessed without disabling the interrupt. */
+#define EOS_DB_ATTRIBUTE_SPSC            ((eos_u8_t)0x04U)
+/* The value key has EOS_DB_VALUE_BUFFERS buffers. The writer fills a back
+   buffer and publishes it, and the readers pin the latest one and read it in
+   place, so a large value is never copied under the lock. */
+#define EOS_DB_ATTRIBUTE_MULTI_BUFFER    ((eos_u8_t)0x08U)
+/* The write of the value key is compared with the value, and is a change only
+   if any byte differs. The unchanged write never publishes the linked event,
+   or marks the persistent key. */
+#define EOS_DB_ATTRIBUTE_CHANGE_ONLY     ((eos_u8_t)0x10U)
 
 void eos_db_init(void *const memory, eos_u32_t size);
 void eos_db_register(const char *topic, eos_u32_t size, eos_u8_t attribute);
+/* The value key is read without disabling the interrupt. A sequence counter
+   is bumped around each write, and the read is retried if it changed. */
 void eos_db_block_read(const char *topic, void * const data);
 void eos_db_block_write(const char *topic, void * const data);
+void eos_db_block_read_h(eos_topic_handle_t topic, void * const data);
+void eos_db_block_write_h(eos_topic_handle_t topic, void * const data);
+/* Read at most EOS_DB_SNAPSHOT_MAX value keys as a coherent set, which no write
+   interleaves, with one lookup for each key. The i-th key is copied into
+   data[i]. */
+void eos_db_snapshot_read(const char *const topics[],
+                            void *const data[], eos_u32_t count);
+void eos_db_snapshot_read_h(const eos_topic_handle_t topics[],
+                            void *const data[], eos_u32_t count);
+#if (EOS_USE_DB_DELTA != 0)
+/* Read the change-only value key, and get the mask of its 4-byte words changed
+   since the version, one bit for each word in (size + 127) / 128 words. The
+   version is then updated to the latest, and the version 0 marks all words. */
+void eos_db_block_read_delta(const char *topic, void * const data,
+                                eos_u32_t *mask, eos_u32_t *version);
+#endif
 eos_s32_t eos_db_stream_read(const char *topic, void *const buffer, eos_u32_t size);
 void eos_db_stream_write(const char *topic, void *const buffer, eos_u32_t size);
+eos_s32_t eos_db_stream_read_h(eos_topic_handle_t topic,
+                                void *const buffer, eos_u32_t size);
+void eos_db_stream_write_h(eos_topic_handle_t topic,
+                            void *const buffer, eos_u32_t size);
+/* The free bytes of the stream key, which can be written without the assert. */
+eos_u32_t eos_db_stream_space(const char *topic);
+eos_u32_t eos_db_stream_space_h(eos_topic_handle_t topic);
+
+/* The storage of the persistent value keys, such as the ekv service. The value
+   is restored by load in eos_db_register(). Each write of the key marks it and
+   calls notify, with the interrupt disabled, and the storage task then saves
+   the marked keys by eos_db_persist_flush(), so the writer never waits for
+   the flash. A key not saved stays marked, and the flush returns EOS_ERROR
+   instead of the number of the saved keys, so the storage task can try it
+   again later. size_max is the largest key the storage keeps, and buffer has
+   size_max bytes, where each key is copied before it is saved, as its value
+   may be written during the save. The flush is called by one task only. */
+typedef struct eos_db_persist
+{
+    bool (* load)(const char *key, void *data, eos_u32_t size);
+    bool (* save)(const char *key, const void *data, eos_u32_t size);
+    void (* notify)(void);
+    eos_u32_t size_max;
+    void *buffer;
+} eos_db_persist_t;
+
+void eos_db_persist_set(const eos_db_persist_t *persist);
+eos_s32_t eos_db_persist_flush(void);
+
+/* The zero-copy access of the stream key. The producer writes at most the
+   returned size bytes into the buffer from reserve, and then commits them. The
+   consumer reads the returned size bytes from the buffer of peek, and then
+   consumes them. The returned buffer is contiguous, so it may be shorter than
+   all the free or filled bytes at the wrap of the ring buffer. */
+eos_u32_t eos_db_stream_reserve(const char *topic, void **buffer);
+void eos_db_stream_commit(const char *topic, eos_u32_t size);
+eos_u32_t eos_db_stream_peek(const char *topic, void **buffer);
+void eos_db_stream_consume(const char *topic, eos_u32_t size);
+
+/* The zero-copy access of the multi-buffer value key. The writer fills the
+   buffer from acquire, which is EOS_NULL if all the back buffers are pinned,
+   and then publishes it as the latest value. The reader gets the latest value
+   by pin, which is read-only and never changed until unpin. A buffer pinned
+   for long keeps one back buffer from the writer, so EOS_DB_VALUE_BUFFERS
+   should exceed the number of such readers by 2. If all are pinned, the write
+   of the key, by acquire or eos_db_block_write(), is dropped, and drop gets
+   the count of such writes. */
+void *eos_db_value_acquire(const char *topic);
+void eos_db_value_publish(const char *topic, void *data);
+const void *eos_db_value_pin(const char *topic);
+void eos_db_value_unpin(const char *topic, const void *data);
+eos_u32_t eos_db_value_drop(const char *topic);
+
+/* -----------------------------------------------------------------------------
+Channel
+----------------------------------------------------------------------------- */
+/*
+ * The channel is a blocking access of a db key, in the way of the channel of
+ * CSP. On a stream key, it is a buffered channel: the sender blocks until the
+ * stream has room for all the data, and the receiver blocks until the stream
+ * is not empty. On a value key, it is a channel of depth 1 which never blocks
+ * the sender: the sender overwrites the value, and the receiver blocks until
+ * a new value is sent. Without a key, it is a rendezvous channel: the sender
+ * blocks until a receiver has copied its data. The waiting task blocks on its
+ * own semaphore, the one of eos_task_wait_event(), and the peer releases it
+ * as soon as the data or the room is available, so the consumer need not poll
+ * the stream with the time events. The events sent to the task during the
+ * wait stay in its mailbox, and are got by eos_task_wait_event() later.
+ *
+ * The time is in ms, and EOS_WAIT_FOREVER or EOS_WAIT_NO. The channel can be
+ * used in the ISR only with EOS_WAIT_NO, and not in the rendezvous mode.
+ */
+typedef struct eos_chan
+{
+    eos_u16_t e_id;                         /* The db key, EOS_MAX_OBJECTS if none */
+    bool pending;                           /* A new value, or the offered data */
+    bool busy;                              /* A sender is in the rendezvous */
+    const void *data;                       /* The data offered in the rendezvous */
+    eos_u32_t size;
+    /* The bitmaps of the waiting tasks, by the task index. */
+    eos_u32_t recv_wait[(EOS_MAX_TASKS + 31) / 32];
+    eos_u32_t send_wait[(EOS_MAX_TASKS + 31) / 32];
+} eos_chan_t;
+
+void eos_chan_init(eos_chan_t *const me, const char *topic);
+eos_err_t eos_chan_send(eos_chan_t *const me,
+                        const void *data, eos_u32_t size, eos_s32_t time_ms);
+eos_s32_t eos_chan_recv(eos_chan_t *const me,
+                        void *buffer, eos_u32_t size, eos_s32_t time_ms);
 
 /* -----------------------------------------------------------------------------
 Reactor
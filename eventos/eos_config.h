@@ -45,7 +45,6 @@
 
 //   <o>  The maximum number of objects: 16 - 65536
 #define EOS_MAX_OBJECTS                         128
-#define EOS_MAX_HASH_SEEK_TIMES                 5
 
 //   <o>  The time of system tick.
 #define EOS_TICK_MS                             1
@@ -83,6 +82,9 @@
 #define EOS_USING_SOFT_TIMER
 #define EOS_USING_CPU_USAGE
 #define EOS_USING_OVERFLOW_CHECK
+// #define EOS_USING_TICKLESS          /* The port has eos_hw_tick_sleep(). */
+// #define EOS_USING_TIMER_WHEEL       /* The timers are in a timing wheel, not a sorted list. */
+// #define EOS_USING_TIMER_SLACK       /* The timers may be called late to be grouped. */
 
 #define EOS_USE_ASSERT                          1
 
@@ -118,7 +120,37 @@
 //   <o>  The maximum size of event heap (128 - 32767) <128-32767>
 #define EOS_SIZE_HEAP                           5120
 
+//   <o>  The largest heap block is at most 2^EOS_HEAP_FL_INDEX_MAX bytes (8 - 24)
+//   The first levels of each heap are sized by its size up to this limit, and
+//   the control block at the start of the heap takes 9 words for each one,
+//   about 336 bytes of a 4 - 8 KB heap, which is why the db memory of the
+//   tests is 6144 bytes, not 5120. A heap larger than the limit is split into
+//   the blocks of the limit.
+#define EOS_HEAP_FL_INDEX_MAX                   24
+
+//   <o>  The number of the event records in the fixed-block pool (0 - 65535)
+#define EOS_EVENT_POOL_SIZE                     64
+
+/* Topic Table Configuration ------------------------------------------------ */
+//   <o>  use the topic table generated by tools/eos_topic.py or eos_phash.py (0 or 1) <0-1>
+#ifndef EOS_USE_TOPIC_TABLE
+#define EOS_USE_TOPIC_TABLE                     0
+#endif
+
+//   <o>  The buffers of each multi-buffer value key (2 - 8) <2-8>
+#define EOS_DB_VALUE_BUFFERS                    3
+
+//   <o>  record the changed words of the change-only value key (0 or 1) <0-1>
+#define EOS_USE_DB_DELTA                        1
+
+//   <o>  The maximum value keys of one snapshot read (1 - 64) <1-64>
+#define EOS_DB_SNAPSHOT_MAX                     16
+
 /* Error -------------------------------------------------------------------- */
+#if (EOS_DB_VALUE_BUFFERS < 2 || EOS_DB_VALUE_BUFFERS > 8)
+#error The buffers of the multi-buffer value key must be 2 ~ 8 !
+#endif
+
 #if (EOS_MAX_PRIORITY > 32 || EOS_MAX_PRIORITY <= 0)
 #error The maximum number of priority levels must be 1 ~ 32 !
 #endif
@@ -143,6 +175,14 @@
     #error The number of time events must be less than 256 !
 #endif
 
+#if (EOS_HEAP_FL_INDEX_MAX < 8 || EOS_HEAP_FL_INDEX_MAX > 24)
+    #error The maximum first level index of the heap must be 8 ~ 24 !
+#endif
+
+#if (EOS_EVENT_POOL_SIZE < 0 || EOS_EVENT_POOL_SIZE > 65535)
+    #error The size of the event pool must be 0 ~ 65535 !
+#endif
+
 #if (EOS_USE_EVENT_DATA != 0)
     #if (EOS_USE_HEAP != 0 && (EOS_SIZE_HEAP < 128 || EOS_SIZE_HEAP > EOS_HEAP_MAX))
         #error The heap size must be 128 ~ 32767 (32KB) if the function is enabled !
@@ -35,6 +35,7 @@
 #define EVENTOS_DEF_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 
 /* basic data type ---------------------------------------------------------- */
 typedef unsigned int                    eos_u32_t;
@@ -48,6 +49,7 @@ typedef unsigned int                    eos_size_t;      /**< Type for size numb
 typedef signed int                      eos_base_t;      /**< Nbit CPU related date type */
 typedef unsigned int                    eos_ubase_t;     /**< Nbit unsigned CPU related data type */
 typedef signed int                      eos_err_t;       /**< Type for error number */
+typedef uintptr_t                       eos_pointer_t;   /**< Type for pointer arithmetic */
 
 typedef unsigned long long              eos_u64_t;
 typedef signed long long                eos_s64_t;
@@ -101,6 +103,47 @@ typedef bool                            eos_bool_t;
     #define ALIGN(n)                    __attribute__((aligned(n)))
 #endif
 
+/*
+ * The memory ordering of the counters shared by one producer and one consumer
+ * without the lock, such as a stream written by an ISR and read by a task. The
+ * load with acquire makes the data written before the store with release of the
+ * peer visible. The fence keeps the memory accesses on both sides of it in
+ * order, as the sequence counter of a value key needs.
+ */
+#if defined(__GNUC__) || defined(__clang__) ||                                 \
+    (defined(__ARMCC_VERSION) && (__ARMCC_VERSION >= 6000000))
+    #define EOS_LOAD_ACQUIRE(p)         __atomic_load_n((p), __ATOMIC_ACQUIRE)
+    #define EOS_STORE_RELEASE(p, v)     __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+    #define EOS_FENCE()                 __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+    #if defined(__ARMCC_VERSION)        /* ARM Compiler 5 */
+        #define EOS_DMB()               __dmb(0xf)
+    #elif defined(__IAR_SYSTEMS_ICC__)  /* IAR Compiler */
+        #include <intrinsics.h>
+        #define EOS_DMB()               __DMB()
+    #else
+        #define EOS_DMB()
+    #endif
+
+eos_inline eos_u32_t eos_load_acquire(volatile eos_u32_t *p)
+{
+    eos_u32_t value = *p;
+    EOS_DMB();
+
+    return value;
+}
+
+eos_inline void eos_store_release(volatile eos_u32_t *p, eos_u32_t value)
+{
+    EOS_DMB();
+    *p = value;
+}
+
+    #define EOS_LOAD_ACQUIRE(p)         eos_load_acquire((p))
+    #define EOS_STORE_RELEASE(p, v)     eos_store_release((p), (v))
+    #define EOS_FENCE()                 EOS_DMB()
+#endif
+
 /*
  * task state definitions
  */
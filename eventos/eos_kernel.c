@@ -56,6 +56,9 @@ static eos_err_t eos_timer_control(eos_timer_handle_t timer_, int cmd, void *arg
 static void eos_task_defunct_enqueue(eos_task_handle_t task);
 static eos_task_handle_t eos_task_defunct_dequeue(void);
 static eos_err_t eos_task_block(eos_task_handle_t task);
+#ifdef EOS_USING_TICKLESS
+static void eos_tick_sleep(void);
+#endif
 
 eos_u8_t *eos_hw_stack_init(void *entry,
                             void *parameter,
@@ -64,9 +67,9 @@ eos_u8_t *eos_hw_stack_init(void *entry,
 /*
  * Context interfaces
  */
-void eos_task_switch(eos_ubase_t from, eos_ubase_t to);
-void eos_task_switch_to(eos_ubase_t to);
-void eos_task_switch_interrupt(eos_ubase_t from, eos_ubase_t to);
+void eos_task_switch(eos_pointer_t from, eos_pointer_t to);
+void eos_task_switch_to(eos_pointer_t to);
+void eos_task_switch_interrupt(eos_pointer_t from, eos_pointer_t to);
 
 /**
  * ek_container_of - return the member address of ptr, if the type of ptr is the
@@ -450,6 +453,7 @@ ek_list_t eos_task_priority_table[EOS_MAX_PRIORITY];
 eos_u32_t eos_task_ready_priority_group;
 
 extern volatile eos_u8_t eos_interrupt_nest;
+extern void eos_task_receivable_update(eos_task_handle_t task);
 static eos_s16_t eos_scheduler_lock_nest;
 ek_task_handle_t eos_current_task = EOS_NULL;
 eos_u8_t eos_current_priority;
@@ -460,13 +464,13 @@ static void _eos_scheduler_stack_check(ek_task_handle_t task)
     EOS_ASSERT(task != EOS_NULL);
 
 #ifdef ARCH_CPU_STACK_GROWS_UPWARD
-    if (*((eos_u8_t *)((eos_ubase_t)task->stack_addr + task->stack_size - 1)) != '#' ||
+    if (*((eos_u8_t *)((eos_pointer_t)task->stack_addr + task->stack_size - 1)) != '#' ||
 #else
     if (*((eos_u8_t *)task->stack_addr) != '#' ||
 #endif /* ARCH_CPU_STACK_GROWS_UPWARD */
-        (eos_ubase_t)task->sp <= (eos_ubase_t)task->stack_addr ||
-        (eos_ubase_t)task->sp >
-        (eos_ubase_t)task->stack_addr + (eos_ubase_t)task->stack_size)
+        (eos_pointer_t)task->sp <= (eos_pointer_t)task->stack_addr ||
+        (eos_pointer_t)task->sp >
+        (eos_pointer_t)task->stack_addr + (eos_pointer_t)task->stack_size)
     {
         eos_ubase_t level;
 
@@ -474,12 +478,12 @@ static void _eos_scheduler_stack_check(ek_task_handle_t task)
         while (level);
     }
 #ifdef ARCH_CPU_STACK_GROWS_UPWARD
-    else if ((eos_ubase_t)task->sp > ((eos_ubase_t)task->stack_addr + task->stack_size))
+    else if ((eos_pointer_t)task->sp > ((eos_pointer_t)task->stack_addr + task->stack_size))
     {
 
     }
 #else
-    else if ((eos_ubase_t)task->sp <= ((eos_ubase_t)task->stack_addr + 32))
+    else if ((eos_pointer_t)task->sp <= ((eos_pointer_t)task->stack_addr + 32))
     {
 
     }
@@ -542,7 +546,7 @@ void eos_kernel_start(void)
     to_task->status = EOS_TASK_RUNNING;
 
     /* switch to new task */
-    eos_task_switch_to((eos_ubase_t)&to_task->sp);
+    eos_task_switch_to((eos_pointer_t)&to_task->sp);
 
     /* never come back */
 }
@@ -617,8 +621,8 @@ void eos_schedule(void)
 
             
 
-                    eos_task_switch((eos_ubase_t)&from_task->sp,
-                            (eos_ubase_t)&to_task->sp);
+                    eos_task_switch((eos_pointer_t)&from_task->sp,
+                            (eos_pointer_t)&to_task->sp);
 
                     /* enable interrupt */
                     eos_hw_interrupt_enable(level);
@@ -628,8 +632,8 @@ void eos_schedule(void)
                 else
                 {
 
-                    eos_task_switch_interrupt((eos_ubase_t)&from_task->sp,
-                            (eos_ubase_t)&to_task->sp);
+                    eos_task_switch_interrupt((eos_pointer_t)&from_task->sp,
+                            (eos_pointer_t)&to_task->sp);
                 }
             }
             else
@@ -1327,6 +1331,8 @@ eos_err_t eos_task_suspend(eos_task_handle_t task_)
     /* change task stat */
     eos_schedule_remove_task(task);
     task->status = EOS_TASK_SUSPEND | (task->status & ~EOS_TASK_STAT_MASK);
+    /* the suspended task receives no event */
+    eos_task_receivable_update(task_);
 
     /* stop task timer anyway */
     eos_timer_stop((eos_timer_handle_t)&(task->task_timer));
@@ -1353,8 +1359,8 @@ eos_err_t eos_task_resume(eos_task_handle_t task_)
     EOS_ASSERT(task != EOS_NULL);
     EOS_ASSERT(eos_object_get_type((ek_obj_handle_t)task) == EOS_Object_Task);
 
-    if ((task->status & EOS_TASK_STAT_MASK) != EOS_TASK_BLOCK &&
-        (task->status & EOS_TASK_STAT_MASK) != EOS_TASK_SUSPEND)
+    eos_u8_t stat = task->status & EOS_TASK_STAT_MASK;
+    if (stat != EOS_TASK_BLOCK && stat != EOS_TASK_SUSPEND)
     {
         return EOS_ERROR;
     }
@@ -1369,6 +1375,11 @@ eos_err_t eos_task_resume(eos_task_handle_t task_)
 
     /* insert to schedule ready list */
     eos_schedule_insert_task(task);
+    /* only the task suspended by eos_task_suspend is an event receiver */
+    if (stat == EOS_TASK_SUSPEND)
+    {
+        eos_task_receivable_update(task_);
+    }
 
     /* enable interrupt */
     eos_hw_interrupt_enable(temp);
@@ -2255,6 +2266,10 @@ static void eos_task_idle_entry(void *parameter)
 #endif /* EOS_USING_IDLE_HOOK */
 
         eos_defunct_execute();
+
+#ifdef EOS_USING_TICKLESS
+        eos_tick_sleep();
+#endif /* EOS_USING_TICKLESS */
     }
 }
 
@@ -2279,8 +2294,36 @@ void eos_task_idle_init(void)
 
 }
 
+#ifdef EOS_USING_TIMER_WHEEL
+/*
+ * The hierarchical timing wheel. A slot of the level 0 is for one tick, and a
+ * slot of the level n for (1 << (n * EOS_TIMER_WHEEL_BITS)) ticks. The timer
+ * is put into the lowest level where its timeout tick is in the same slots of
+ * the higher levels as the wheel tick, and is moved down when the wheel comes
+ * into its slot, so starting, stopping and calling a timer take no search.
+ */
+#define EOS_TIMER_WHEEL_SLOTS           (1U << EOS_TIMER_WHEEL_BITS)
+#define EOS_TIMER_WHEEL_MASK            (EOS_TIMER_WHEEL_SLOTS - 1U)
+#define EOS_TIMER_WHEEL_LEVELS          ((32U + EOS_TIMER_WHEEL_BITS - 1U) / EOS_TIMER_WHEEL_BITS)
+#define EOS_TIMER_WHEEL_MAP_SIZE        ((EOS_TIMER_WHEEL_SLOTS + 31U) / 32U)
+
+typedef struct ek_timer_wheel
+{
+    eos_u32_t tick;                         /**< the tick of the current slot */
+    eos_u32_t map[EOS_TIMER_WHEEL_LEVELS][EOS_TIMER_WHEEL_MAP_SIZE];
+                                            /**< the slots which may be not empty */
+    ek_list_t slot[EOS_TIMER_WHEEL_LEVELS][EOS_TIMER_WHEEL_SLOTS];
+} ek_timer_wheel_t;
+
+typedef ek_timer_wheel_t ek_timer_list_t;
+#define EOS_TIMER_LIST_SIZE             1
+#else
+typedef ek_list_t ek_timer_list_t;
+#define EOS_TIMER_LIST_SIZE             EOS_TIMER_SKIP_LIST_LEVEL
+#endif /* EOS_USING_TIMER_WHEEL */
+
 /* hard timer list */
-static ek_list_t _timer_list[EOS_TIMER_SKIP_LIST_LEVEL];
+static ek_timer_list_t _timer_list[EOS_TIMER_LIST_SIZE];
 
 #ifdef EOS_USING_SOFT_TIMER
 
@@ -2298,7 +2341,7 @@ static ek_list_t _timer_list[EOS_TIMER_SKIP_LIST_LEVEL];
 /* soft timer status */
 static eos_u8_t _soft_timer_status = EOS_SOFT_TIMER_IDLE;
 /* soft timer list */
-static ek_list_t _soft_timer_list[EOS_TIMER_SKIP_LIST_LEVEL];
+static ek_timer_list_t _soft_timer_list[EOS_TIMER_LIST_SIZE];
 static ek_task_t _timer_task;
 static eos_u32_t _timer_task_stack[EOS_TIMER_THREAD_STACK_SIZE / 4];
 #endif /* EOS_USING_SOFT_TIMER */
@@ -2330,6 +2373,10 @@ static void _timer_init(ek_timer_handle_t timer,
 
     timer->timeout_tick = 0;
     timer->init_tick    = time;
+#ifdef EOS_USING_TIMER_SLACK
+    timer->slack_tick   = 0;
+    timer->soft_tick    = 0;
+#endif
 
     /* initialize timer list */
     for (eos_u32_t i = 0; i < EOS_TIMER_SKIP_LIST_LEVEL; i++)
@@ -2339,6 +2386,19 @@ static void _timer_init(ek_timer_handle_t timer,
 }
 
 
+#ifndef EOS_USING_TIMER_WHEEL
+/**
+ * @brief Initialize the timer list
+ * @param timer_list is the array of time list
+ */
+static void _timer_list_init(ek_timer_list_t timer_list[])
+{
+    for (eos_u32_t i = 0; i < EOS_TIMER_SKIP_LIST_LEVEL; i++)
+    {
+        eos_list_init(&timer_list[i]);
+    }
+}
+
 /**
  * @brief  Find the next emtpy timer ticks
  * @param timer_list is the array of time list
@@ -2346,7 +2406,7 @@ static void _timer_init(ek_timer_handle_t timer,
  * @return  Return the operation status. If the return value is EOS_EOK, the function is successfully executed.
  *          If the return value is any other values, it means this operation failed.
  */
-static eos_err_t _timer_list_next_timeout(ek_list_t timer_list[], eos_u32_t *timeout_tick)
+static eos_err_t _timer_list_next_timeout(ek_timer_list_t timer_list[], eos_u32_t *timeout_tick)
 {
     ek_timer_handle_t timer;
     register eos_base_t level;
@@ -2373,6 +2433,449 @@ static eos_err_t _timer_list_next_timeout(ek_list_t timer_list[], eos_u32_t *tim
     return EOS_ERROR;
 }
 
+/**
+ * @brief Insert the timer into the timer list by its timeout tick
+ * @note The interrupts should be disabled.
+ * @param timer_list is the array of time list
+ * @param timer the timer removed from the lists
+ */
+static void _timer_list_insert(ek_timer_list_t timer_list[], ek_timer_handle_t timer)
+{
+    unsigned int row_lvl;
+    ek_list_t *row_head[EOS_TIMER_SKIP_LIST_LEVEL];
+    unsigned int tst_nr;
+    static unsigned int random_nr;
+
+    row_head[0]  = &timer_list[0];
+    for (row_lvl = 0; row_lvl < EOS_TIMER_SKIP_LIST_LEVEL; row_lvl++)
+    {
+        for (; row_head[row_lvl] != timer_list[row_lvl].prev;
+             row_head[row_lvl]  = row_head[row_lvl]->next)
+        {
+            ek_timer_handle_t t;
+            ek_list_t *p = row_head[row_lvl]->next;
+
+            /* fix up the entry pointer */
+            t = eos_list_entry(p, ek_timer_t, row[row_lvl]);
+
+            /* If we have two timers that timeout at the same time, it's
+             * preferred that the timer inserted early get called early.
+             * So insert the new timer to the end the the some-timeout timer
+             * list.
+             */
+            if ((t->timeout_tick - timer->timeout_tick) == 0)
+            {
+                continue;
+            }
+            else if ((t->timeout_tick - timer->timeout_tick) < EOS_TICK_MAX / 2)
+            {
+                break;
+            }
+        }
+        if (row_lvl != EOS_TIMER_SKIP_LIST_LEVEL - 1)
+        {
+            row_head[row_lvl + 1] = row_head[row_lvl] + 1;
+        }
+    }
+
+    /* Interestingly, this super simple timer insert counter works very very
+     * well on distributing the list height uniformly. By means of "very very
+     * well", I mean it beats the randomness of timer->timeout_tick very easily
+     * (actually, the timeout_tick is not random and easy to be attacked). */
+    random_nr++;
+    tst_nr = random_nr;
+
+    eos_list_insert_after(row_head[EOS_TIMER_SKIP_LIST_LEVEL - 1],
+                         &(timer->row[EOS_TIMER_SKIP_LIST_LEVEL - 1]));
+    for (row_lvl = 2; row_lvl <= EOS_TIMER_SKIP_LIST_LEVEL; row_lvl++)
+    {
+        if (!(tst_nr & EOS_TIMER_SKIP_LIST_MASK))
+            eos_list_insert_after(row_head[EOS_TIMER_SKIP_LIST_LEVEL - row_lvl],
+                                 &(timer->row[EOS_TIMER_SKIP_LIST_LEVEL - row_lvl]));
+        else
+            break;
+        /* Shift over the bits we have tested. Works well with 1 bit and 2
+         * bits. */
+        tst_nr >>= (EOS_TIMER_SKIP_LIST_MASK + 1) >> 1;
+    }
+}
+
+/**
+ * @brief Get the first timer which is due at the current tick
+ * @note The interrupts should be disabled.
+ * @param timer_list is the array of time list
+ * @param current_tick is the current tick
+ * @param group is true if a timer is called in this check, and then the next
+ *        timer whose timeout without the slack has come is called too.
+ * @return the timer due, or EOS_NULL if none
+ */
+static ek_timer_handle_t _timer_list_due(ek_timer_list_t timer_list[],
+                                         eos_u32_t current_tick,
+                                         eos_bool_t group)
+{
+    ek_timer_handle_t timer;
+
+    if (eos_list_isempty(&timer_list[EOS_TIMER_SKIP_LIST_LEVEL - 1]))
+    {
+        return EOS_NULL;
+    }
+
+    timer = eos_list_entry(timer_list[EOS_TIMER_SKIP_LIST_LEVEL - 1].next,
+                            ek_timer_t, row[EOS_TIMER_SKIP_LIST_LEVEL - 1]);
+
+    /*
+     * It supposes that the new tick shall less than the half duration of
+     * tick max.
+     */
+    if ((current_tick - timer->timeout_tick) < EOS_TICK_MAX / 2)
+    {
+        return timer;
+    }
+
+#ifdef EOS_USING_TIMER_SLACK
+    if (group && (current_tick - timer->soft_tick) < EOS_TICK_MAX / 2)
+    {
+        return timer;
+    }
+#else
+    (void)group;
+#endif
+
+    return EOS_NULL;
+}
+#else
+/**
+ * @brief Find the first slot set in the map, from the slot begin to the slot end
+ * @param map is the map of a level
+ * @return the slot found, or the slot end if none
+ */
+static eos_u32_t _timer_wheel_find(eos_u32_t map[], eos_u32_t begin, eos_u32_t end)
+{
+    eos_u32_t bits;
+
+    while (begin < end)
+    {
+        bits = map[begin >> 5] & (0xffffffffU << (begin & 31U));
+        if (bits != 0)
+        {
+            begin = (begin & ~31U) + (eos_u32_t)__eos_ffs((int)bits) - 1U;
+            return (begin < end) ? begin : end;
+        }
+        begin = (begin & ~31U) + 32U;
+    }
+
+    return end;
+}
+
+/**
+ * @brief Find the next slot not empty after the wheel tick, in the order of
+ *        the time. The empty slots met are cleared in the map.
+ * @param wheel is the timer wheel
+ * @param tick is the tick when the slot is reached
+ * @return the level of the slot, or EOS_TIMER_WHEEL_LEVELS if none
+ */
+static eos_u32_t _timer_wheel_next(ek_timer_wheel_t *wheel, eos_u32_t *tick)
+{
+    eos_u32_t shift, current, index, end;
+
+    for (eos_u32_t level = 0; level < EOS_TIMER_WHEEL_LEVELS; level++)
+    {
+        shift = level * EOS_TIMER_WHEEL_BITS;
+        current = (wheel->tick >> shift) & EOS_TIMER_WHEEL_MASK;
+        index = current + 1U;
+        end = EOS_TIMER_WHEEL_SLOTS;
+
+        while (1)
+        {
+            index = _timer_wheel_find(wheel->map[level], index, end);
+            if (index == end)
+            {
+                /* The top level turns around when the tick overflows. */
+                if (level == EOS_TIMER_WHEEL_LEVELS - 1U &&
+                    end == EOS_TIMER_WHEEL_SLOTS && current != 0)
+                {
+                    index = 0;
+                    end = current;
+                    continue;
+                }
+                break;
+            }
+
+            if (!eos_list_isempty(&wheel->slot[level][index]))
+            {
+                *tick = index << shift;
+                if (level != EOS_TIMER_WHEEL_LEVELS - 1U)
+                {
+                    shift += EOS_TIMER_WHEEL_BITS;
+                    *tick |= (wheel->tick >> shift) << shift;
+                }
+
+                return level;
+            }
+
+            wheel->map[level][index >> 5] &= ~(1U << (index & 31U));
+            index++;
+        }
+    }
+
+    return EOS_TIMER_WHEEL_LEVELS;
+}
+
+/**
+ * @brief Put the timer into the slot of its timeout tick
+ * @param wheel is the timer wheel
+ * @param timer the timer removed from the slots
+ */
+static void _timer_wheel_insert(ek_timer_wheel_t *wheel, ek_timer_handle_t timer)
+{
+    eos_u32_t tick = timer->timeout_tick;
+    eos_u32_t level = 0;
+    eos_u32_t index;
+
+    /* The timer due already is put into the current slot. */
+    if ((tick - wheel->tick) >= EOS_TICK_MAX / 2)
+    {
+        tick = wheel->tick;
+    }
+
+    while ((level + 1U) < EOS_TIMER_WHEEL_LEVELS &&
+           ((tick ^ wheel->tick) >> ((level + 1U) * EOS_TIMER_WHEEL_BITS)) != 0)
+    {
+        level++;
+    }
+
+    /* The timers moved down from the higher level are always started before
+     * the ones put into the slot directly, so adding the timer to the tail
+     * keeps the timers of the same timeout tick in the order of starting. */
+    index = (tick >> (level * EOS_TIMER_WHEEL_BITS)) & EOS_TIMER_WHEEL_MASK;
+    eos_list_insert_before(&wheel->slot[level][index], &timer->row[0]);
+    wheel->map[level][index >> 5] |= (1U << (index & 31U));
+}
+
+/**
+ * @brief Move the timers down from the slots which begin at the wheel tick,
+ *        from the highest level.
+ * @param wheel is the timer wheel
+ */
+static void _timer_wheel_cascade(ek_timer_wheel_t *wheel)
+{
+    ek_timer_handle_t t;
+    ek_list_t *slot;
+    eos_u32_t level = 0;
+    eos_u32_t index;
+
+    while ((level + 1U) < EOS_TIMER_WHEEL_LEVELS &&
+           (wheel->tick & ((1U << ((level + 1U) * EOS_TIMER_WHEEL_BITS)) - 1U)) == 0)
+    {
+        level++;
+    }
+
+    for (; level > 0; level--)
+    {
+        index = (wheel->tick >> (level * EOS_TIMER_WHEEL_BITS)) & EOS_TIMER_WHEEL_MASK;
+        slot = &wheel->slot[level][index];
+        wheel->map[level][index >> 5] &= ~(1U << (index & 31U));
+
+        while (!eos_list_isempty(slot))
+        {
+            t = eos_list_entry(slot->next, ek_timer_t, row[0]);
+            eos_list_remove(&t->row[0]);
+            _timer_wheel_insert(wheel, t);
+        }
+    }
+}
+
+/**
+ * @brief Initialize the timer wheel
+ * @param timer_list is the timer wheel
+ */
+static void _timer_list_init(ek_timer_list_t timer_list[])
+{
+    ek_timer_wheel_t *wheel = &timer_list[0];
+
+    wheel->tick = eos_tick_get();
+    for (eos_u32_t level = 0; level < EOS_TIMER_WHEEL_LEVELS; level++)
+    {
+        for (eos_u32_t i = 0; i < EOS_TIMER_WHEEL_MAP_SIZE; i++)
+        {
+            wheel->map[level][i] = 0;
+        }
+        for (eos_u32_t i = 0; i < EOS_TIMER_WHEEL_SLOTS; i++)
+        {
+            eos_list_init(&wheel->slot[level][i]);
+        }
+    }
+}
+
+/**
+ * @brief  Find the next emtpy timer ticks
+ * @param timer_list is the timer wheel
+ * @param timeout_tick is the next timer's ticks
+ * @return  Return the operation status. If the return value is EOS_EOK, the function is successfully executed.
+ *          If the return value is any other values, it means this operation failed.
+ */
+static eos_err_t _timer_list_next_timeout(ek_timer_list_t timer_list[], eos_u32_t *timeout_tick)
+{
+    ek_timer_wheel_t *wheel = &timer_list[0];
+    ek_timer_handle_t timer;
+    ek_list_t *slot, *node;
+    register eos_base_t level;
+    eos_u32_t tick, slot_level;
+
+    /* disable interrupt */
+    level = eos_hw_interrupt_disable();
+
+    slot = &wheel->slot[0][wheel->tick & EOS_TIMER_WHEEL_MASK];
+    if (!eos_list_isempty(slot))
+    {
+        timer = eos_list_entry(slot->next, ek_timer_t, row[0]);
+        *timeout_tick = timer->timeout_tick;
+
+        /* enable interrupt */
+        eos_hw_interrupt_enable(level);
+
+        return EOS_EOK;
+    }
+
+    slot_level = _timer_wheel_next(wheel, &tick);
+    if (slot_level != EOS_TIMER_WHEEL_LEVELS)
+    {
+        *timeout_tick = tick;
+
+        /* The timers of a higher slot are not sorted. */
+        if (slot_level != 0)
+        {
+            slot = &wheel->slot[slot_level][(tick >> (slot_level * EOS_TIMER_WHEEL_BITS)) &
+                                            EOS_TIMER_WHEEL_MASK];
+            *timeout_tick = eos_list_entry(slot->next, ek_timer_t, row[0])->timeout_tick;
+            for (node = slot->next; node != slot; node = node->next)
+            {
+                timer = eos_list_entry(node, ek_timer_t, row[0]);
+                if ((timer->timeout_tick - wheel->tick) < (*timeout_tick - wheel->tick))
+                {
+                    *timeout_tick = timer->timeout_tick;
+                }
+            }
+        }
+
+        /* enable interrupt */
+        eos_hw_interrupt_enable(level);
+
+        return EOS_EOK;
+    }
+
+    /* enable interrupt */
+    eos_hw_interrupt_enable(level);
+
+    return EOS_ERROR;
+}
+
+/**
+ * @brief Insert the timer into the timer wheel by its timeout tick
+ * @note The interrupts should be disabled.
+ * @param timer_list is the timer wheel
+ * @param timer the timer removed from the slots
+ */
+static void _timer_list_insert(ek_timer_list_t timer_list[], ek_timer_handle_t timer)
+{
+    ek_timer_wheel_t *wheel = &timer_list[0];
+    eos_u32_t tick;
+
+    /* The wheel without any timer is not checked, and follows the tick here
+     * before it is left behind too far. */
+    if ((eos_tick_get() - wheel->tick) >= EOS_TICK_MAX / 4 &&
+        eos_list_isempty(&wheel->slot[0][wheel->tick & EOS_TIMER_WHEEL_MASK]) &&
+        _timer_wheel_next(wheel, &tick) == EOS_TIMER_WHEEL_LEVELS)
+    {
+        wheel->tick = eos_tick_get();
+    }
+
+    _timer_wheel_insert(wheel, timer);
+}
+
+/**
+ * @brief Get the first timer which is due at the current tick. The wheel goes
+ *        on to the current tick, jumping over the empty slots.
+ * @note The interrupts should be disabled.
+ * @param timer_list is the timer wheel
+ * @param current_tick is the current tick
+ * @param group is true if a timer is called in this check, and then the first
+ *        timer of the next slot is called too if its timeout without the slack
+ *        has come.
+ * @return the timer due, or EOS_NULL if none
+ */
+static ek_timer_handle_t _timer_list_due(ek_timer_list_t timer_list[],
+                                         eos_u32_t current_tick,
+                                         eos_bool_t group)
+{
+    ek_timer_wheel_t *wheel = &timer_list[0];
+    ek_list_t *slot;
+    eos_u32_t index, tick;
+
+    while (1)
+    {
+        index = wheel->tick & EOS_TIMER_WHEEL_MASK;
+        slot = &wheel->slot[0][index];
+        if (!eos_list_isempty(slot))
+        {
+            return eos_list_entry(slot->next, ek_timer_t, row[0]);
+        }
+        wheel->map[0][index >> 5] &= ~(1U << (index & 31U));
+
+        if (current_tick == wheel->tick)
+        {
+#ifdef EOS_USING_TIMER_SLACK
+            eos_u32_t level;
+
+            if (group && (level = _timer_wheel_next(wheel, &tick)) != EOS_TIMER_WHEEL_LEVELS)
+            {
+                ek_timer_handle_t timer;
+
+                index = (tick >> (level * EOS_TIMER_WHEEL_BITS)) & EOS_TIMER_WHEEL_MASK;
+                slot = &wheel->slot[level][index];
+                timer = eos_list_entry(slot->next, ek_timer_t, row[0]);
+                if ((current_tick - timer->soft_tick) < EOS_TICK_MAX / 2)
+                {
+                    return timer;
+                }
+            }
+#else
+            (void)group;
+#endif
+            return EOS_NULL;
+        }
+
+        /* The next tick in the same slot of the level 1, checked every tick. */
+        if ((current_tick - wheel->tick) == 1 && (current_tick & EOS_TIMER_WHEEL_MASK) != 0)
+        {
+            wheel->tick = current_tick;
+            continue;
+        }
+
+        if (_timer_wheel_next(wheel, &tick) == EOS_TIMER_WHEEL_LEVELS)
+        {
+            wheel->tick = current_tick;
+            return EOS_NULL;
+        }
+
+        /* The tick is set back. */
+        if ((current_tick - wheel->tick) >= EOS_TICK_MAX / 2)
+        {
+            return EOS_NULL;
+        }
+
+        if ((tick - wheel->tick) > (current_tick - wheel->tick))
+        {
+            wheel->tick = current_tick;
+            return EOS_NULL;
+        }
+
+        wheel->tick = tick;
+        _timer_wheel_cascade(wheel);
+    }
+}
+#endif /* EOS_USING_TIMER_WHEEL */
+
 /**
  * @brief Remove the timer
  * @param timer the point of the timer
@@ -2487,35 +2990,43 @@ eos_err_t eos_timer_detach(eos_timer_handle_t timer_)
 }
 
 /**
- * @brief This function will start the timer
+ * @brief [internal] Start the timer
+ *        The internal called function of eos_timer_start
+ * @see eos_timer_start
  * @param timer the timer to be started
+ * @param restart is true if the periodic timer is started again after called
  * @return the operation status, EOS_EOK on OK, EOS_ERROR on error
  */
-eos_err_t eos_timer_start(eos_timer_handle_t timer_)
+static eos_err_t _timer_start(ek_timer_handle_t timer, eos_bool_t restart)
 {
-    unsigned int row_lvl;
-    ek_list_t *timer_list;
+    ek_timer_list_t *timer_list;
     register eos_base_t level;
     register eos_bool_t need_schedule;
-    ek_list_t *row_head[EOS_TIMER_SKIP_LIST_LEVEL];
-    unsigned int tst_nr;
-    static unsigned int random_nr;
-    ek_timer_handle_t timer = (ek_timer_handle_t)timer_;
-
-    /* parameter check */
-    EOS_ASSERT(timer != EOS_NULL);
-    EOS_ASSERT(eos_object_get_type(&timer->super) == EOS_Object_Timer);
 
     need_schedule = false;
 
     /* stop timer firstly */
     level = eos_hw_interrupt_disable();
     /* remove timer from list */
-    _timer_remove(timer_);
+    _timer_remove((eos_timer_handle_t)timer);
     /* change status of timer */
     timer->super.flag &= ~EOS_TIMER_FLAG_ACTIVATED;
 
     timer->timeout_tick = eos_tick_get() + timer->init_tick;
+#ifdef EOS_USING_TIMER_SLACK
+    /* The periodic timer called late or early by the slack keeps its period
+     * from the last timeout, if it's not passed yet. */
+    if (restart &&
+        (eos_tick_get() - (timer->soft_tick + timer->init_tick)) >= EOS_TICK_MAX / 2)
+    {
+        timer->timeout_tick = timer->soft_tick + timer->init_tick;
+    }
+    /* It's called at the end of the slack, or earlier with another timer. */
+    timer->soft_tick = timer->timeout_tick;
+    timer->timeout_tick += timer->slack_tick;
+#else
+    (void)restart;
+#endif
 
 #ifdef EOS_USING_SOFT_TIMER
     if (timer->super.flag & EOS_TIMER_FLAG_SOFT_TIMER)
@@ -2530,58 +3041,7 @@ eos_err_t eos_timer_start(eos_timer_handle_t timer_)
         timer_list = _timer_list;
     }
 
-    row_head[0]  = &timer_list[0];
-    for (row_lvl = 0; row_lvl < EOS_TIMER_SKIP_LIST_LEVEL; row_lvl++)
-    {
-        for (; row_head[row_lvl] != timer_list[row_lvl].prev;
-             row_head[row_lvl]  = row_head[row_lvl]->next)
-        {
-            ek_timer_handle_t t;
-            ek_list_t *p = row_head[row_lvl]->next;
-
-            /* fix up the entry pointer */
-            t = eos_list_entry(p, ek_timer_t, row[row_lvl]);
-
-            /* If we have two timers that timeout at the same time, it's
-             * preferred that the timer inserted early get called early.
-             * So insert the new timer to the end the the some-timeout timer
-             * list.
-             */
-            if ((t->timeout_tick - timer->timeout_tick) == 0)
-            {
-                continue;
-            }
-            else if ((t->timeout_tick - timer->timeout_tick) < EOS_TICK_MAX / 2)
-            {
-                break;
-            }
-        }
-        if (row_lvl != EOS_TIMER_SKIP_LIST_LEVEL - 1)
-        {
-            row_head[row_lvl + 1] = row_head[row_lvl] + 1;
-        }
-    }
-
-    /* Interestingly, this super simple timer insert counter works very very
-     * well on distributing the list height uniformly. By means of "very very
-     * well", I mean it beats the randomness of timer->timeout_tick very easily
-     * (actually, the timeout_tick is not random and easy to be attacked). */
-    random_nr++;
-    tst_nr = random_nr;
-
-    eos_list_insert_after(row_head[EOS_TIMER_SKIP_LIST_LEVEL - 1],
-                         &(timer->row[EOS_TIMER_SKIP_LIST_LEVEL - 1]));
-    for (row_lvl = 2; row_lvl <= EOS_TIMER_SKIP_LIST_LEVEL; row_lvl++)
-    {
-        if (!(tst_nr & EOS_TIMER_SKIP_LIST_MASK))
-            eos_list_insert_after(row_head[EOS_TIMER_SKIP_LIST_LEVEL - row_lvl],
-                                 &(timer->row[EOS_TIMER_SKIP_LIST_LEVEL - row_lvl]));
-        else
-            break;
-        /* Shift over the bits we have tested. Works well with 1 bit and 2
-         * bits. */
-        tst_nr >>= (EOS_TIMER_SKIP_LIST_MASK + 1) >> 1;
-    }
+    _timer_list_insert(timer_list, timer);
 
     timer->super.flag |= EOS_TIMER_FLAG_ACTIVATED;
 
@@ -2610,6 +3070,22 @@ eos_err_t eos_timer_start(eos_timer_handle_t timer_)
     return EOS_EOK;
 }
 
+/**
+ * @brief This function will start the timer
+ * @param timer the timer to be started
+ * @return the operation status, EOS_EOK on OK, EOS_ERROR on error
+ */
+eos_err_t eos_timer_start(eos_timer_handle_t timer_)
+{
+    ek_timer_handle_t timer = (ek_timer_handle_t)timer_;
+
+    /* parameter check */
+    EOS_ASSERT(timer != EOS_NULL);
+    EOS_ASSERT(eos_object_get_type(&timer->super) == EOS_Object_Timer);
+
+    return _timer_start(timer, false);
+}
+
 /**
  * @brief This function will stop the timer
  * @param timer the timer to be stopped
@@ -2749,6 +3225,27 @@ eos_err_t eos_timer_set_time(eos_timer_handle_t timer_, eos_u32_t time)
     return EOS_EOK;
 }
 
+#ifdef EOS_USING_TIMER_SLACK
+eos_err_t eos_timer_set_slack(eos_timer_handle_t timer_, eos_u32_t slack)
+{
+    register eos_base_t level;
+    ek_timer_handle_t timer = (ek_timer_handle_t)timer_;
+
+    /* parameter check */
+    EOS_ASSERT(timer != EOS_NULL);
+    EOS_ASSERT(eos_object_get_type(&timer->super) == EOS_Object_Timer);
+    EOS_ASSERT(slack < (EOS_TICK_MAX / 2));
+
+    level = eos_hw_interrupt_disable();
+
+    timer->slack_tick = slack;
+
+    eos_hw_interrupt_enable(level);
+
+    return EOS_EOK;
+}
+#endif
+
 eos_u32_t eos_timer_get_time(eos_timer_handle_t timer_)
 {
     register eos_base_t level;
@@ -2788,6 +3285,7 @@ void eos_timer_check(void)
     eos_u32_t current_tick;
     register eos_base_t level;
     ek_list_t list;
+    eos_bool_t group = false;
 
     eos_list_init(&list);
 
@@ -2796,48 +3294,36 @@ void eos_timer_check(void)
     /* disable interrupt */
     level = eos_hw_interrupt_disable();
 
-    while (!eos_list_isempty(&_timer_list[EOS_TIMER_SKIP_LIST_LEVEL - 1]))
+    while ((t = _timer_list_due(_timer_list, current_tick, group)) != EOS_NULL)
     {
-        t = eos_list_entry(_timer_list[EOS_TIMER_SKIP_LIST_LEVEL - 1].next,
-                          ek_timer_t, row[EOS_TIMER_SKIP_LIST_LEVEL - 1]);
+        group = true;
 
-        /*
-         * It supposes that the new tick shall less than the half duration of
-         * tick max.
-         */
-        if ((current_tick - t->timeout_tick) < EOS_TICK_MAX / 2)
+        /* remove timer from timer list firstly */
+        _timer_remove((eos_timer_handle_t)t);
+        if (!(t->super.flag & EOS_TIMER_FLAG_PERIODIC))
         {
-            /* remove timer from timer list firstly */
-            _timer_remove((eos_timer_handle_t)t);
-            if (!(t->super.flag & EOS_TIMER_FLAG_PERIODIC))
-            {
-                t->super.flag &= ~EOS_TIMER_FLAG_ACTIVATED;
-            }
-            /* add timer to temporary list  */
-            eos_list_insert_after(&list, &(t->row[EOS_TIMER_SKIP_LIST_LEVEL - 1]));
-            /* call timeout function */
-            t->timeout_func(t->parameter);
+            t->super.flag &= ~EOS_TIMER_FLAG_ACTIVATED;
+        }
+        /* add timer to temporary list  */
+        eos_list_insert_after(&list, &(t->row[EOS_TIMER_SKIP_LIST_LEVEL - 1]));
+        /* call timeout function */
+        t->timeout_func(t->parameter);
 
-            /* re-get tick */
-            current_tick = eos_tick_get();
+        /* re-get tick */
+        current_tick = eos_tick_get();
 
-            /* Check whether the timer object is detached or started again */
-            if (eos_list_isempty(&list))
-            {
-                continue;
-            }
-            eos_list_remove(&(t->row[EOS_TIMER_SKIP_LIST_LEVEL - 1]));
-            if ((t->super.flag & EOS_TIMER_FLAG_PERIODIC) &&
-                (t->super.flag & EOS_TIMER_FLAG_ACTIVATED))
-            {
-                /* start it */
-                t->super.flag &= ~EOS_TIMER_FLAG_ACTIVATED;
-                eos_timer_start((eos_timer_handle_t)t);
-            }
+        /* Check whether the timer object is detached or started again */
+        if (eos_list_isempty(&list))
+        {
+            continue;
         }
-        else
+        eos_list_remove(&(t->row[EOS_TIMER_SKIP_LIST_LEVEL - 1]));
+        if ((t->super.flag & EOS_TIMER_FLAG_PERIODIC) &&
+            (t->super.flag & EOS_TIMER_FLAG_ACTIVATED))
         {
-            break;
+            /* start it */
+            t->super.flag &= ~EOS_TIMER_FLAG_ACTIVATED;
+            _timer_start(t, true);
         }
     }
 
@@ -2863,66 +3349,52 @@ eos_u32_t eos_timer_next_timeout_tick(void)
  */
 void eos_soft_timer_check(void)
 {
-    eos_u32_t current_tick;
     ek_timer_handle_t t;
     register eos_base_t level;
     ek_list_t list;
+    eos_bool_t group = false;
 
     eos_list_init(&list);
 
     /* disable interrupt */
     level = eos_hw_interrupt_disable();
 
-    while (!eos_list_isempty(&_soft_timer_list[EOS_TIMER_SKIP_LIST_LEVEL - 1]))
+    while ((t = _timer_list_due(_soft_timer_list, eos_tick_get(), group)) != EOS_NULL)
     {
-        t = eos_list_entry(_soft_timer_list[EOS_TIMER_SKIP_LIST_LEVEL - 1].next,
-                            ek_timer_t, row[EOS_TIMER_SKIP_LIST_LEVEL - 1]);
+        group = true;
 
-        current_tick = eos_tick_get();
-
-        /*
-         * It supposes that the new tick shall less than the half duration of
-         * tick max.
-         */
-        if ((current_tick - t->timeout_tick) < EOS_TICK_MAX / 2)
+        /* remove timer from timer list firstly */
+        _timer_remove((eos_timer_handle_t)t);
+        if (!(t->super.flag & EOS_TIMER_FLAG_PERIODIC))
         {
-            /* remove timer from timer list firstly */
-            _timer_remove((eos_timer_handle_t)t);
-            if (!(t->super.flag & EOS_TIMER_FLAG_PERIODIC))
-            {
-                t->super.flag &= ~EOS_TIMER_FLAG_ACTIVATED;
-            }
-            /* add timer to temporary list  */
-            eos_list_insert_after(&list, &(t->row[EOS_TIMER_SKIP_LIST_LEVEL - 1]));
+            t->super.flag &= ~EOS_TIMER_FLAG_ACTIVATED;
+        }
+        /* add timer to temporary list  */
+        eos_list_insert_after(&list, &(t->row[EOS_TIMER_SKIP_LIST_LEVEL - 1]));
 
-            _soft_timer_status = EOS_SOFT_TIMER_BUSY;
-            /* enable interrupt */
-            eos_hw_interrupt_enable(level);
+        _soft_timer_status = EOS_SOFT_TIMER_BUSY;
+        /* enable interrupt */
+        eos_hw_interrupt_enable(level);
 
-            /* call timeout function */
-            t->timeout_func(t->parameter);
+        /* call timeout function */
+        t->timeout_func(t->parameter);
 
-            /* disable interrupt */
-            level = eos_hw_interrupt_disable();
+        /* disable interrupt */
+        level = eos_hw_interrupt_disable();
 
-            _soft_timer_status = EOS_SOFT_TIMER_IDLE;
-            /* Check whether the timer object is detached or started again */
-            if (eos_list_isempty(&list))
-            {
-                continue;
-            }
-            eos_list_remove(&(t->row[EOS_TIMER_SKIP_LIST_LEVEL - 1]));
-            if ((t->super.flag & EOS_TIMER_FLAG_PERIODIC) &&
-                (t->super.flag & EOS_TIMER_FLAG_ACTIVATED))
-            {
-                /* start it */
-                t->super.flag &= ~EOS_TIMER_FLAG_ACTIVATED;
-                eos_timer_start((eos_timer_handle_t)t);
-            }
+        _soft_timer_status = EOS_SOFT_TIMER_IDLE;
+        /* Check whether the timer object is detached or started again */
+        if (eos_list_isempty(&list))
+        {
+            continue;
         }
-        else
+        eos_list_remove(&(t->row[EOS_TIMER_SKIP_LIST_LEVEL - 1]));
+        if ((t->super.flag & EOS_TIMER_FLAG_PERIODIC) &&
+            (t->super.flag & EOS_TIMER_FLAG_ACTIVATED))
         {
-            break; /* not check anymore */
+            /* start it */
+            t->super.flag &= ~EOS_TIMER_FLAG_ACTIVATED;
+            _timer_start(t, true);
         }
     }
     /* enable interrupt */
@@ -2973,10 +3445,7 @@ static void _timer_task_entry(void *parameter)
  */
 void eos_system_timer_init(void)
 {
-    for (eos_u32_t i = 0; i < sizeof(_timer_list) / sizeof(_timer_list[0]); i++)
-    {
-        eos_list_init(_timer_list + i);
-    }
+    _timer_list_init(_timer_list);
 }
 
 /**
@@ -2986,12 +3455,7 @@ void eos_system_timer_init(void)
 void eos_system_timer_task_init(void)
 {
 #ifdef EOS_USING_SOFT_TIMER
-    for (eos_u32_t i = 0;
-         i < sizeof(_soft_timer_list) / sizeof(_soft_timer_list[0]);
-         i++)
-    {
-        eos_list_init(_soft_timer_list + i);
-    }
+    _timer_list_init(_soft_timer_list);
 
     /* start software timer task */
     ek_task_init(&_timer_task,
@@ -3072,6 +3536,55 @@ void eos_tick_increase(void)
     eos_timer_check();
 }
 
+#ifdef EOS_USING_TICKLESS
+/**
+ * @brief    This function will stop the tick in the idle task until the next
+ *           timeout, and make up the ticks passed when it wakes up. The tick
+ *           goes on if any other task of the idle priority is ready, as the
+ *           time slice is needed then.
+ */
+static void eos_tick_sleep(void)
+{
+    eos_base_t level;
+    eos_u32_t next_timeout;
+    eos_u32_t tick;
+
+    level = eos_hw_interrupt_disable();
+
+    if (eos_task_ready_priority_group != 0)
+    {
+        eos_hw_interrupt_enable(level);
+        return;
+    }
+
+    if (_timer_list_next_timeout(_timer_list, &next_timeout) == EOS_EOK)
+    {
+        tick = next_timeout - eos_tick_;
+
+        /* The timeout is due already. */
+        if (tick == 0 || tick >= EOS_TICK_MAX / 2)
+        {
+            eos_hw_interrupt_enable(level);
+            return;
+        }
+    }
+    else
+    {
+        tick = (eos_u32_t)EOS_WAIT_FOREVER;
+    }
+
+    tick = eos_hw_tick_sleep(tick);
+    if (tick != 0)
+    {
+        /* No timeout is in the ticks before the last one. */
+        eos_tick_ += (tick - 1);
+        eos_tick_increase();
+    }
+
+    eos_hw_interrupt_enable(level);
+}
+#endif /* EOS_USING_TICKLESS */
+
 /**
  * @brief    This function will calculate the tick from millisecond.
  * @param    ms is the specified millisecond.
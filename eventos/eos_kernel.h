@@ -43,6 +43,15 @@ typedef ek_obj_t *ek_obj_handle_t;    /**< Type for kernel objects. */
 #define EOS_TIMER_SKIP_LIST_LEVEL        1
 #endif
 
+/* The slots of every level of the timer wheel are (1 << EOS_TIMER_WHEEL_BITS). */
+#ifndef EOS_TIMER_WHEEL_BITS
+#define EOS_TIMER_WHEEL_BITS             6
+#endif
+
+#if defined(EOS_USING_TIMER_WHEEL) && (EOS_TIMER_SKIP_LIST_LEVEL != 1)
+#error "The timer wheel needs no skip list, EOS_TIMER_SKIP_LIST_LEVEL should be 1."
+#endif
+
 /**
  * timer structure
  */
@@ -57,6 +66,10 @@ typedef struct ek_timer
 
     eos_u32_t init_tick;
     eos_u32_t timeout_tick;
+#ifdef EOS_USING_TIMER_SLACK
+    eos_u32_t slack_tick;                   /**< the ticks it may be called late */
+    eos_u32_t soft_tick;                    /**< the timeout tick without the slack */
+#endif
 } ek_timer_t;
 
 typedef struct ek_timer *ek_timer_handle_t;
@@ -1,7 +1,6 @@
 /* include ------------------------------------------------------------------ */
 #include "eos_led.h"
-#include "eventos.h"
-#include "event_def.h"
+#include "eos.h"
 #include <stdio.h>
 
 #if (EOS_USE_SM_MODE != 0)
@@ -22,20 +21,21 @@ static eos_ret_t state_off(eos_led_t * const me, eos_event_t const * const e);
 /* api ---------------------------------------------------- */
 void eos_led_init(void)
 {
-    eos_sm_init(&led.super, 1, 0);
-    eos_sm_start(&led.super, EOS_STATE_CAST(state_init));
-
+    static eos_u64_t stack_led[64];
+    eos_sm_init(&led.super, "sm_led", 1, stack_led, sizeof(stack_led));
     led.status = 0;
+
+    eos_sm_start(&led.super, EOS_STATE_CAST(state_init));
 }
 
 /* static state function ---------------------------------------------------- */
 static eos_ret_t state_init(eos_led_t * const me, eos_event_t const * const e)
 {
 #if (EOS_USE_PUB_SUB != 0)
-    EOS_EVENT_SUB(Event_Time_500ms);
+    eos_event_sub("Event_Time_500ms");
 #endif
 #if (EOS_USE_TIME_EVENT != 0)
-    eos_event_pub_period(Event_Time_500ms, 500);
+    eos_event_publish_period("Event_Time_500ms", 500);
 #endif
 
     return EOS_TRAN(state_off);
@@ -43,33 +43,31 @@ static eos_ret_t state_init(eos_led_t * const me, eos_event_t const * const e)
 
 static eos_ret_t state_on(eos_led_t * const me, eos_event_t const * const e)
 {
-    switch (e->topic) {
-        case Event_Enter:
-            printf("State On!\n");
-            me->status = 1;
-            return EOS_Ret_Handled;
-
-        case Event_Time_500ms:
-            return EOS_TRAN(state_off);
+    if (eos_event_topic(e, "Event_Enter")) {
+        printf("State On!\n");
+        me->status = 1;
+        return EOS_Ret_Handled;
+    }
 
-        default:
-            return EOS_SUPER(eos_state_top);
+    if (eos_event_topic(e, "Event_Time_500ms")) {
+        return EOS_TRAN(state_off);
     }
+
+    return EOS_SUPER(eos_state_top);
 }
 
 static eos_ret_t state_off(eos_led_t * const me, eos_event_t const * const e)
 {
-    switch (e->topic) {
-        case Event_Enter:
-            printf("State Off!\n");
-            me->status = 0;
-            return EOS_Ret_Handled;
-
-        case Event_Time_500ms:
-            return EOS_TRAN(state_on);
+    if (eos_event_topic(e, "Event_Enter")) {
+        printf("State Off!\n");
+        me->status = 0;
+        return EOS_Ret_Handled;
+    }
 
-        default:
-            return EOS_SUPER(eos_state_top);
+    if (eos_event_topic(e, "Event_Time_500ms")) {
+        return EOS_TRAN(state_on);
     }
+
+    return EOS_SUPER(eos_state_top);
 }
 #endif
@@ -1,26 +1,17 @@
 /* include ------------------------------------------------------------------ */
-#include "eventos.h"                                // EventOS Nano头文件
-#include "event_def.h"                              // 事件主题的枚举
+#include "eos.h"                                    // EventOS头文件
 #include "eos_led.h"                                // LED灯闪烁状态机
 
-/* define ------------------------------------------------------------------- */
-#if (EOS_USE_PUB_SUB != 0)
-static eos_u32_t eos_sub_table[Event_Max];          // 订阅表数据空间
-#endif
-
 /* main function ------------------------------------------------------------ */
 int main(void)
 {
     eos_init();                                     // EventOS初始化
-#if (EOS_USE_PUB_SUB != 0)
-    eos_sub_init(eos_sub_table, Event_Max);         // 订阅表初始化
-#endif
 
-#if (EOS_USE_SM_MODE)
+#if (EOS_USE_SM_MODE != 0)
     eos_led_init();                                 // LED状态机初始化
 #endif
 
-    eos_run();                                      // EventOS启动
+    eos_kernel_start();                             // EventOS启动
 
     return 0;
 }
\ No newline at end of file
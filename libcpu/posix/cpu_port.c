@@ -0,0 +1,571 @@
+/*
+************************************************************************************************************************
+* File    : cpu_port.c
+* Version : V1.00.00
+************************************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                             INCLUDE FILES
+*********************************************************************************************************
+*/
+#define _GNU_SOURCE
+
+#include  "eos.h"
+#include  <ucontext.h>
+#include  <signal.h>
+#include  <pthread.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <errno.h>
+#include  <time.h>
+#include  <sys/time.h>
+#include  "cpu_port.h"
+
+EOS_TAG("CpuPosix")
+
+/*
+*********************************************************************************************************
+*                                             POSIX TASK STRUCTURE
+*  All the tasks run in one host thread, and every task has a ucontext and a host stack malloced
+*  here, because the signal frames and the libc calls need much more stack than a task on the MCU.
+*  Only the pointer to the structure is put onto the task stack, and the kernel sees it as the
+*  stack pointer of the task. The structure is kept when the task is deleted, and reused when a
+*  task is created on the same stack again.
+*********************************************************************************************************
+*/
+typedef struct posix_task
+{
+    struct posix_task       *next;
+    eos_u8_t                *stack_addr;            // The key to reuse the structure.
+    void                    (* entry)(void *parameter);
+    void                    *parameter;
+    void                    (* exit)(void);
+    ucontext_t              context;
+    eos_u8_t                stack[EOS_POSIX_STACK_SIZE];
+} posix_task_t;
+
+typedef struct posix_interrupt
+{
+    void                    (* isr)(void);
+    eos_u32_t               period;                 // In ticks, 0 is not periodic.
+    eos_u32_t               count;
+} posix_interrupt_t;
+
+/*
+*********************************************************************************************************
+*                                             LOCAL DEFINES
+*********************************************************************************************************
+*/
+/*
+ * The interrupts are disabled in software, so it costs no system call. The signal handler only marks
+ * the interrupt pending when they are disabled, and it's handled when they are enabled again.
+ */
+static volatile sig_atomic_t posix_irq_disabled = 1;
+static volatile eos_u32_t posix_irq_pending = 0;
+static posix_interrupt_t posix_irq[CPU_INTERRUPT_MAX];
+
+/*
+ * The switch asked by the kernel in the ISR, done when all the pending ISRs are handled.
+ */
+static volatile eos_u32_t posix_switch_flag = 0;
+static eos_pointer_t posix_switch_from;
+static eos_pointer_t posix_switch_to;
+
+static posix_task_t *posix_task_list = EOS_NULL;
+static posix_task_t *volatile posix_task_current = EOS_NULL;
+
+static pthread_t posix_thread;
+static eos_bool_t posix_init_done = false;
+static eos_bool_t posix_started = false;
+static struct timespec posix_time_start;
+static eos_u64_t posix_tick = 0;
+
+/*
+*********************************************************************************************************
+*                                             PRIVATE FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+static void posix_init(void);
+static void posix_signal_handler(int signo);
+static void posix_interrupt_dispatch(void);
+static void posix_task_entry(void);
+static void posix_periodic_pass(eos_u32_t tick);
+#if (EOS_POSIX_VIRTUAL_TIME == 0)
+static void posix_tick_isr(void);
+static eos_u64_t posix_clock_ns(void);
+static void posix_timer_set(eos_u64_t value_ns, eos_bool_t periodic);
+#endif
+#ifdef EOS_USING_TICKLESS
+static void posix_interrupt_wait(void);
+#endif
+
+#define posix_barrier()             __atomic_signal_fence(__ATOMIC_SEQ_CST)
+#define posix_task_of(sp_)          (*(posix_task_t **)(*(void **)(sp_)))
+
+/*
+*********************************************************************************************************
+*                                            eos_hw_stack_init()
+* Description : Initialize stack of task
+* Argument(s) : void *entry, void *parameter, eos_u8_t *stack_addr, void *exit
+* Return(s)   : eos_u8_t*
+* Caller(s)   : ek_task_init
+* Note(s)     : The task stack only holds the pointer to its posix_task_t.
+*********************************************************************************************************
+*/
+eos_u8_t *eos_hw_stack_init(void *entry, void *parameter, eos_u8_t *stack_addr, void *exit)
+{
+    posix_task_t *task;
+    eos_u8_t *stk;
+
+    posix_init();
+
+    for (task = posix_task_list; task != EOS_NULL; task = task->next)
+    {
+        if (task->stack_addr == stack_addr)
+        {
+            break;
+        }
+    }
+    if (task == EOS_NULL)
+    {
+        task = malloc(sizeof(posix_task_t));
+        EOS_ASSERT(task != EOS_NULL);
+        task->stack_addr = stack_addr;
+        task->next = posix_task_list;
+        posix_task_list = task;
+    }
+    EOS_ASSERT(task != posix_task_current);
+
+    task->entry = (void (*)(void *))entry;
+    task->parameter = parameter;
+    task->exit = (void (*)(void))exit;
+
+    getcontext(&task->context);
+    task->context.uc_stack.ss_sp = task->stack;
+    task->context.uc_stack.ss_size = sizeof(task->stack);
+    task->context.uc_link = EOS_NULL;
+    sigdelset(&task->context.uc_sigmask, SIGALRM);
+    sigdelset(&task->context.uc_sigmask, SIGUSR1);
+    makecontext(&task->context, posix_task_entry, 0);
+
+    stk = (eos_u8_t *)((eos_pointer_t)(stack_addr - sizeof(posix_task_t *)) &
+                       ~(eos_pointer_t)(sizeof(posix_task_t *) - 1));
+    *(posix_task_t **)stk = task;
+
+    return stk;
+} /*** eos_hw_stack_init ***/
+
+/*
+*********************************************************************************************************
+*                                            eos_hw_interrupt_disable()
+* Description : disable cpu interrupts
+* Argument(s) : void
+* Return(s)   : eos_base_t, the level before
+* Caller(s)   : Applications or os_kernel
+* Note(s)     : The interrupts are disabled before the kernel starts.
+*********************************************************************************************************
+*/
+eos_base_t eos_hw_interrupt_disable(void)
+{
+    eos_base_t level = posix_irq_disabled;
+
+    posix_irq_disabled = 1;
+    posix_barrier();
+
+    return level;
+} /*** eos_hw_interrupt_disable ***/
+
+/*
+*********************************************************************************************************
+*                                            eos_hw_interrupt_enable()
+* Description : enable cpu interrupts
+* Argument(s) : eos_base_t level
+* Return(s)   : void
+* Caller(s)   : Applications or os_kernel
+* Note(s)     : The interrupts pended in the critical section are handled here.
+*********************************************************************************************************
+*/
+void eos_hw_interrupt_enable(eos_base_t level)
+{
+    posix_barrier();
+    posix_irq_disabled = level;
+
+    if (level == 0 && posix_irq_pending != 0)
+    {
+        posix_irq_disabled = 1;
+        posix_interrupt_dispatch();
+        posix_irq_disabled = 0;
+    }
+} /*** eos_hw_interrupt_enable ***/
+
+/*
+*********************************************************************************************************
+*                                            eos_task_switch()
+* Description : switch the task in the task context
+* Argument(s) : eos_pointer_t from, eos_pointer_t to      // the address of the stack pointers
+* Return(s)   : void
+* Caller(s)   : eos_schedule
+* Note(s)     : Called with the interrupts disabled, and it returns when the task is switched back.
+*********************************************************************************************************
+*/
+void eos_task_switch(eos_pointer_t from, eos_pointer_t to)
+{
+    posix_task_t *task_from = posix_task_of(from);
+    posix_task_t *task_to = posix_task_of(to);
+
+    posix_task_current = task_to;
+    swapcontext(&task_from->context, &task_to->context);
+} /*** eos_task_switch ***/
+
+/*
+*********************************************************************************************************
+*                                            eos_task_switch_interrupt()
+* Description : switch the task in the interrupt context
+* Argument(s) : eos_pointer_t from, eos_pointer_t to      // the address of the stack pointers
+* Return(s)   : void
+* Caller(s)   : eos_schedule
+* Note(s)     : The switch is done when all the pending ISRs are handled, as PendSV on Cortex-M.
+*********************************************************************************************************
+*/
+void eos_task_switch_interrupt(eos_pointer_t from, eos_pointer_t to)
+{
+    if (posix_switch_flag == 0)
+    {
+        posix_switch_flag = 1;
+        posix_switch_from = from;
+    }
+
+    posix_switch_to = to;
+} /*** eos_task_switch_interrupt ***/
+
+/*
+*********************************************************************************************************
+*                                            eos_task_switch_to()
+* Description : switch to the first task
+* Argument(s) : eos_pointer_t to                          // the address of the stack pointer
+* Return(s)   : void
+* Caller(s)   : eos_kernel_start
+* Note(s)     : The tick is started here, and the stack of main() is not used any more.
+*********************************************************************************************************
+*/
+void eos_task_switch_to(eos_pointer_t to)
+{
+    posix_task_t *task_to = posix_task_of(to);
+
+    posix_init();
+
+    clock_gettime(CLOCK_MONOTONIC, &posix_time_start);
+    posix_tick = 0;
+    posix_started = true;
+
+#if (EOS_POSIX_VIRTUAL_TIME == 0)
+    posix_timer_set((eos_u64_t)EOS_TICK_MS * 1000000, true);
+#endif
+
+    posix_task_current = task_to;
+    setcontext(&task_to->context);
+
+    // never reach here!
+} /*** eos_task_switch_to ***/
+
+#ifdef EOS_USING_TICKLESS
+/*
+*********************************************************************************************************
+*                                            eos_hw_tick_sleep()
+* Description : stop the tick and sleep in the idle task
+* Argument(s) : eos_u32_t tick                            // EOS_WAIT_FOREVER for no timeout
+* Return(s)   : eos_u32_t, the ticks passed
+* Caller(s)   : eos_tick_sleep
+* Note(s)     : The sleep is cut at the next periodic interrupt, and the periodic interrupts passed
+*               are pended. In the virtual time it takes no time, and returns the ticks at once.
+*********************************************************************************************************
+*/
+eos_u32_t eos_hw_tick_sleep(eos_u32_t tick)
+{
+    eos_u32_t tick_passed;
+
+    for (eos_u32_t i = 0; i < CPU_INTERRUPT_MAX; i ++)
+    {
+        if (posix_irq[i].period != 0 && posix_irq[i].count < tick)
+        {
+            tick = posix_irq[i].count;
+        }
+    }
+
+#if (EOS_POSIX_VIRTUAL_TIME == 0)
+    eos_u64_t tick_ns = (eos_u64_t)EOS_TICK_MS * 1000000;
+
+    if (tick != (eos_u32_t)EOS_WAIT_FOREVER)
+    {
+        eos_u64_t deadline = (posix_tick + tick) * tick_ns;
+        eos_u64_t now = posix_clock_ns();
+
+        posix_timer_set((deadline > now) ? (deadline - now) : 1, false);
+    }
+    else
+    {
+        posix_timer_set(0, false);
+    }
+    posix_interrupt_wait();
+
+    tick_passed = (eos_u32_t)(posix_clock_ns() / tick_ns - posix_tick);
+    posix_timer_set(tick_ns - posix_clock_ns() % tick_ns, true);
+#else
+    if (tick == (eos_u32_t)EOS_WAIT_FOREVER)
+    {
+        // Only the interrupts from other host threads can come.
+        posix_interrupt_wait();
+        return 0;
+    }
+    tick_passed = tick;
+#endif
+
+    posix_tick += tick_passed;
+    posix_periodic_pass(tick_passed);
+
+    return tick_passed;
+} /*** eos_hw_tick_sleep ***/
+#endif
+
+/*
+*********************************************************************************************************
+*                                            eos_hw_interrupt_register()
+* Description : Register a simulated interrupt
+* Argument(s) : eos_u32_t irq, void (* isr)(void), eos_u32_t period_ms
+* Return(s)   : void
+* Caller(s)   : Applications
+* Note(s)     : CPU_INTERRUPT_TICK is used by the port.
+*********************************************************************************************************
+*/
+void eos_hw_interrupt_register(eos_u32_t irq, void (* isr)(void), eos_u32_t period_ms)
+{
+    EOS_ASSERT(irq < CPU_INTERRUPT_MAX && irq != CPU_INTERRUPT_TICK);
+
+    posix_init();
+
+    eos_base_t level = eos_hw_interrupt_disable();
+    posix_irq[irq].isr = isr;
+    posix_irq[irq].period = (period_ms == 0) ? 0 : ((period_ms + EOS_TICK_MS - 1) / EOS_TICK_MS);
+    posix_irq[irq].count = posix_irq[irq].period;
+    eos_hw_interrupt_enable(level);
+} /*** eos_hw_interrupt_register ***/
+
+/*
+*********************************************************************************************************
+*                                            eos_hw_interrupt_trigger()
+* Description : Trigger a simulated interrupt
+* Argument(s) : eos_u32_t irq
+* Return(s)   : void
+* Caller(s)   : Applications, ISRs or other host threads
+* Note(s)     : none
+*********************************************************************************************************
+*/
+void eos_hw_interrupt_trigger(eos_u32_t irq)
+{
+    EOS_ASSERT(irq < CPU_INTERRUPT_MAX);
+
+    posix_init();
+
+    __atomic_fetch_or(&posix_irq_pending, (1U << irq), __ATOMIC_SEQ_CST);
+    pthread_kill(posix_thread, SIGUSR1);
+} /*** eos_hw_interrupt_trigger ***/
+
+/*
+*********************************************************************************************************
+*                                             PRIVATE FUNCTION
+*********************************************************************************************************
+*/
+static void posix_init(void)
+{
+    struct sigaction action;
+
+    if (posix_init_done)
+    {
+        return;
+    }
+    posix_init_done = true;
+
+    posix_thread = pthread_self();
+#if (EOS_POSIX_VIRTUAL_TIME == 0)
+    posix_irq[CPU_INTERRUPT_TICK].isr = posix_tick_isr;
+#endif
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = posix_signal_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaddset(&action.sa_mask, SIGALRM);
+    sigaddset(&action.sa_mask, SIGUSR1);
+    sigaction(SIGALRM, &action, EOS_NULL);
+    sigaction(SIGUSR1, &action, EOS_NULL);
+}
+
+static void posix_signal_handler(int signo)
+{
+    int errno_saved = errno;
+
+    // The process signal may be sent to another host thread.
+    if (!pthread_equal(pthread_self(), posix_thread))
+    {
+        pthread_kill(posix_thread, signo);
+    }
+    else
+    {
+        if (signo == SIGALRM && posix_started)
+        {
+            __atomic_fetch_or(&posix_irq_pending, (1U << CPU_INTERRUPT_TICK), __ATOMIC_SEQ_CST);
+        }
+
+        if (posix_irq_disabled == 0)
+        {
+            posix_irq_disabled = 1;
+            posix_interrupt_dispatch();
+            posix_irq_disabled = 0;
+        }
+    }
+
+    errno = errno_saved;
+}
+
+/*
+ * Called with the interrupts disabled. The task may be switched out here, and the dispatch
+ * goes on when the task is switched back.
+ */
+static void posix_interrupt_dispatch(void)
+{
+    eos_u32_t pending;
+
+    while ((pending = __atomic_exchange_n(&posix_irq_pending, 0, __ATOMIC_SEQ_CST)) != 0)
+    {
+        for (eos_u32_t i = 0; i < CPU_INTERRUPT_MAX; i ++)
+        {
+            if ((pending & (1U << i)) != 0 && posix_irq[i].isr != EOS_NULL)
+            {
+                posix_irq[i].isr();
+            }
+        }
+
+        if (posix_switch_flag != 0)
+        {
+            posix_task_t *task_from = posix_task_of(posix_switch_from);
+            posix_task_t *task_to = posix_task_of(posix_switch_to);
+
+            posix_switch_flag = 0;
+            if (task_from != task_to)
+            {
+                posix_task_current = task_to;
+                swapcontext(&task_from->context, &task_to->context);
+            }
+        }
+    }
+}
+
+/*
+ * Pend the periodic interrupts whose periods end in the ticks passed.
+ */
+static void posix_periodic_pass(eos_u32_t tick)
+{
+    for (eos_u32_t i = 0; i < CPU_INTERRUPT_MAX; i ++)
+    {
+        if (posix_irq[i].period == 0)
+        {
+            continue;
+        }
+
+        if (posix_irq[i].count <= tick)
+        {
+            posix_irq[i].count = posix_irq[i].period - (tick - posix_irq[i].count) % posix_irq[i].period;
+            __atomic_fetch_or(&posix_irq_pending, (1U << i), __ATOMIC_SEQ_CST);
+        }
+        else
+        {
+            posix_irq[i].count -= tick;
+        }
+    }
+}
+
+#if (EOS_POSIX_VIRTUAL_TIME == 0)
+/*
+ * The ticks lost when the signal is blocked by the host are made up from the monotonic clock.
+ * It's not used in the virtual time, in which the ticks only pass in eos_hw_tick_sleep().
+ */
+static void posix_tick_isr(void)
+{
+    eos_u64_t tick_target = posix_clock_ns() / ((eos_u64_t)EOS_TICK_MS * 1000000);
+
+    eos_interrupt_enter();
+    while (posix_tick < tick_target)
+    {
+        posix_tick ++;
+        eos_tick_increase();
+        posix_periodic_pass(1);
+    }
+    eos_interrupt_leave();
+}
+
+static eos_u64_t posix_clock_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (eos_u64_t)((eos_s64_t)(now.tv_sec - posix_time_start.tv_sec) * 1000000000 +
+                       (now.tv_nsec - posix_time_start.tv_nsec));
+}
+
+/*
+ * Set SIGALRM after the time, and then every tick if periodic. The time 0 stops it.
+ */
+static void posix_timer_set(eos_u64_t value_ns, eos_bool_t periodic)
+{
+    struct itimerval timer;
+
+    memset(&timer, 0, sizeof(timer));
+    if (value_ns != 0)
+    {
+        value_ns = (value_ns < 1000) ? 1000 : value_ns;
+        timer.it_value.tv_sec = value_ns / 1000000000;
+        timer.it_value.tv_usec = (value_ns % 1000000000) / 1000;
+    }
+    if (periodic)
+    {
+        timer.it_interval.tv_sec = EOS_TICK_MS / 1000;
+        timer.it_interval.tv_usec = (EOS_TICK_MS % 1000) * 1000;
+    }
+    setitimer(ITIMER_REAL, &timer, EOS_NULL);
+}
+#endif
+
+#ifdef EOS_USING_TICKLESS
+/*
+ * Sleep until any signal of the port comes, unless an interrupt is pending already.
+ */
+static void posix_interrupt_wait(void)
+{
+    sigset_t mask;
+    sigset_t mask_old;
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGALRM);
+    sigaddset(&mask, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &mask, &mask_old);
+    if (posix_irq_pending == 0)
+    {
+        sigsuspend(&mask_old);
+    }
+    sigprocmask(SIG_SETMASK, &mask_old, EOS_NULL);
+}
+#endif
+
+static void posix_task_entry(void)
+{
+    posix_task_t *task = posix_task_current;
+
+    // A new task starts with the interrupts enabled.
+    eos_hw_interrupt_enable(0);
+
+    task->entry(task->parameter);
+    task->exit();
+}
@@ -0,0 +1,65 @@
+/*
+************************************************************************************************************************
+* File    : cpu_port.h
+* Version : V1.00.00
+************************************************************************************************************************
+*/
+
+#ifndef _CPU_PORT_H_
+#define _CPU_PORT_H_
+
+#include "eos.h"
+
+/*
+*********************************************************************************************************
+*                                             CPU INTERRUPT PRIORITY
+*  The simulated interrupts are handled from the lowest number, and the tick is the first one.
+*********************************************************************************************************
+*/
+#define CPU_INTERRUPT_TICK          0x00
+#define CPU_INTERRUPT_MAX           32
+
+/*
+*********************************************************************************************************
+*                                             CONFIGURATION
+*********************************************************************************************************
+*/
+/* The host stack of every task, the task stack only holds the pointer to it. */
+#ifndef EOS_POSIX_STACK_SIZE
+#define EOS_POSIX_STACK_SIZE        (64 * 1024)
+#endif
+
+/*
+ * The virtual time. The tick is not driven by the host clock, and only goes on in the tickless
+ * idle, jumping to the next timeout or the next periodic interrupt at once when all the tasks are
+ * blocked. The tasks take no time, so the runs are reproducible, and the task busy forever stops
+ * the time. It needs EOS_USING_TICKLESS.
+ */
+#ifndef EOS_POSIX_VIRTUAL_TIME
+#define EOS_POSIX_VIRTUAL_TIME      0
+#endif
+
+#if (EOS_POSIX_VIRTUAL_TIME != 0) && !defined(EOS_USING_TICKLESS)
+#error "The virtual time of the posix port needs EOS_USING_TICKLESS."
+#endif
+
+/*
+*********************************************************************************************************
+*                                             FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+/*
+ * The ISR is called with the interrupts disabled, and should call eos_interrupt_enter() and
+ * eos_interrupt_leave() as a real one. A period in ms makes the interrupt triggered by the tick,
+ * and 0 means that it's only triggered by eos_hw_interrupt_trigger().
+ */
+void eos_hw_interrupt_register(eos_u32_t irq, void (* isr)(void), eos_u32_t period_ms);
+
+/*
+ * Trigger a simulated interrupt. It can be called from the tasks, the ISRs, the signal handlers
+ * and other host threads. The ISR runs at once if the interrupts are enabled, or else when they
+ * are enabled again.
+ */
+void eos_hw_interrupt_trigger(eos_u32_t irq);
+
+#endif /* _CPU_PORT_H_ */
@@ -0,0 +1,585 @@
+
+/* include ------------------------------------------------------------------ */
+#include "ekv.h"
+#include <string.h>
+
+/* private define ----------------------------------------------------------- */
+#define EKV_SECTOR_MAGIC                    (0x53564b45U)       /* "EKVS" */
+#define EKV_RECORD_MAGIC                    (0x5aa5U)
+#define EKV_SEQ_ERASED                      (0xffffffffU)
+#define EKV_SEQ_GARBAGE                     (0xfffffffeU)
+#define EKV_SECTOR_NONE                     (0xffffU)
+#define EKV_ALIGN(size)                     (((size) + 3U) & ~3U)
+
+/* private data structure --------------------------------------------------- */
+typedef struct ekv_sector_head
+{
+    uint32_t magic;
+    uint32_t seq;
+} ekv_sector_head_t;
+
+/* The record is the head, the key and the value, aligned to 4 bytes. The CRC
+   covers all the fields after it in the head, the key and the value. */
+typedef struct ekv_record_head
+{
+    uint16_t magic;
+    uint16_t value_size;
+    uint8_t key_size;
+    uint8_t reserved[3];
+    uint32_t crc;
+} ekv_record_head_t;
+
+#define EKV_RECORD_HEAD_SIZE                ((uint32_t)sizeof(ekv_record_head_t))
+#define EKV_RECORD_CRC_OFFSET               (2U)
+#define EKV_RECORD_CRC_SIZE                 (6U)
+
+/* private function --------------------------------------------------------- */
+static uint32_t ekv_crc32(uint32_t crc, const void *data, uint32_t size);
+static uint32_t ekv_hash(const char *key, uint8_t size);
+static int32_t ekv_record_read_(ekv_t *const me, uint32_t addr, uint32_t end);
+static int32_t ekv_index_find_(ekv_t *const me,
+                               const char *key, uint8_t key_size, uint32_t hash);
+static int32_t ekv_index_update_(ekv_t *const me, uint32_t addr);
+static int32_t ekv_sector_scan_(ekv_t *const me, uint16_t sector);
+static bool ekv_sector_blank_(ekv_t *const me, uint16_t sector);
+static int32_t ekv_sector_erase_(ekv_t *const me, uint16_t sector);
+static bool ekv_has_room_(ekv_t *const me, uint32_t size, uint16_t reserve);
+static int32_t ekv_append_(ekv_t *const me,
+                           uint32_t size, uint16_t reserve, uint32_t *addr);
+
+/* public function ---------------------------------------------------------- */
+int32_t ekv_init(ekv_t *const me, ekv_flash_t *flash)
+{
+    if (flash->sector_count > EKV_SECTOR_MAX ||
+        flash->sector_count <= EKV_GC_THRESHOLD ||
+        flash->sector_size < (EKV_RECORD_SIZE_MAX + sizeof(ekv_sector_head_t)))
+    {
+        return EKV_ERROR;
+    }
+
+    me->flash = flash;
+    me->count = 0;
+    me->seq_max = 0;
+    me->sector_head = EKV_SECTOR_NONE;
+    me->offset = 0;
+    me->erased = 0;
+    me->erase_count = 0;
+    me->record_broken = 0;
+
+    /* Get the state of all the sectors. */
+    for (uint16_t i = 0; i < flash->sector_count; i ++)
+    {
+        ekv_sector_head_t head;
+        if (flash->read(flash, i * flash->sector_size, &head, sizeof(head)) != 0)
+        {
+            return EKV_ERROR;
+        }
+
+        if (head.magic == EKV_SECTOR_MAGIC && head.seq < EKV_SEQ_GARBAGE)
+        {
+            me->seq[i] = head.seq;
+        }
+        else if (head.magic == 0xffffffffU && ekv_sector_blank_(me, i))
+        {
+            me->seq[i] = EKV_SEQ_ERASED;
+            me->erased ++;
+        }
+        else
+        {
+            /* Broken by a power loss in the erase. */
+            me->seq[i] = EKV_SEQ_GARBAGE;
+        }
+    }
+
+    /* Replay the used sectors from the oldest, so the latest record wins. */
+    uint32_t seq_last = 0;
+    bool first = true;
+    while (1)
+    {
+        uint16_t sector = EKV_SECTOR_NONE;
+        for (uint16_t i = 0; i < flash->sector_count; i ++)
+        {
+            if (me->seq[i] < EKV_SEQ_GARBAGE &&
+                (first || me->seq[i] > seq_last) &&
+                (sector == EKV_SECTOR_NONE || me->seq[i] < me->seq[sector]))
+            {
+                sector = i;
+            }
+        }
+        if (sector == EKV_SECTOR_NONE)
+        {
+            break;
+        }
+
+        int32_t offset = ekv_sector_scan_(me, sector);
+        if (offset < 0)
+        {
+            return offset;
+        }
+        first = false;
+        seq_last = me->seq[sector];
+        me->seq_max = seq_last;
+        me->sector_head = sector;
+        me->offset = (uint32_t)offset;
+    }
+
+    return EKV_OK;
+}
+
+int32_t ekv_set(ekv_t *const me, const char *key, const void *value, uint16_t size)
+{
+    uint32_t key_size = (uint32_t)strlen(key);
+    if (key_size == 0 || key_size > EKV_KEY_SIZE_MAX || size > EKV_VALUE_SIZE_MAX)
+    {
+        return EKV_ERROR;
+    }
+
+    uint32_t hash = ekv_hash(key, (uint8_t)key_size);
+    int32_t index = ekv_index_find_(me, key, (uint8_t)key_size, hash);
+    if (index < 0 && me->count >= EKV_MAX_KEYS)
+    {
+        return EKV_FULL;
+    }
+
+    /* Compact in place only when the background compaction is behind. A
+       compaction of a sector with only live records gains no room, but the
+       next sector may have some, so all sectors are tried at most once. */
+    uint32_t size_record = EKV_ALIGN(EKV_RECORD_HEAD_SIZE + key_size + size);
+    for (uint16_t i = 0; !ekv_has_room_(me, size_record, 1); i ++)
+    {
+        if (i >= me->flash->sector_count || ekv_gc(me) == EKV_ERROR)
+        {
+            return EKV_FULL;
+        }
+    }
+
+    /* Build the record in the buffer. */
+    ekv_record_head_t *head = (ekv_record_head_t *)me->buffer;
+    memset(me->buffer, 0xff, size_record);
+    head->magic = EKV_RECORD_MAGIC;
+    head->value_size = size;
+    head->key_size = (uint8_t)key_size;
+    memcpy(&me->buffer[EKV_RECORD_HEAD_SIZE], key, key_size);
+    memcpy(&me->buffer[EKV_RECORD_HEAD_SIZE + key_size], value, size);
+    uint32_t crc = ekv_crc32(0, &me->buffer[EKV_RECORD_CRC_OFFSET],
+                             EKV_RECORD_CRC_SIZE);
+    head->crc = ekv_crc32(crc, &me->buffer[EKV_RECORD_HEAD_SIZE],
+                          key_size + size);
+
+    uint32_t addr;
+    int32_t ret = ekv_append_(me, size_record, 1, &addr);
+    if (ret != EKV_OK)
+    {
+        return ret;
+    }
+
+    if (index < 0)
+    {
+        index = me->count ++;
+        me->index[index].hash = hash;
+    }
+    me->index[index].addr = addr;
+
+    return EKV_OK;
+}
+
+int32_t ekv_get(ekv_t *const me, const char *key, void *value, uint16_t size)
+{
+    uint32_t key_size = (uint32_t)strlen(key);
+    if (key_size == 0 || key_size > EKV_KEY_SIZE_MAX)
+    {
+        return EKV_NOT_FOUND;
+    }
+
+    int32_t index = ekv_index_find_(me, key, (uint8_t)key_size,
+                                    ekv_hash(key, (uint8_t)key_size));
+    if (index < 0)
+    {
+        return EKV_NOT_FOUND;
+    }
+
+    ekv_record_head_t head;
+    uint32_t addr = me->index[index].addr;
+    if (me->flash->read(me->flash, addr, &head, EKV_RECORD_HEAD_SIZE) != 0)
+    {
+        return EKV_ERROR;
+    }
+    if (size > head.value_size)
+    {
+        size = head.value_size;
+    }
+    if (me->flash->read(me->flash, addr + EKV_RECORD_HEAD_SIZE + key_size,
+                        value, size) != 0)
+    {
+        return EKV_ERROR;
+    }
+
+    return head.value_size;
+}
+
+bool ekv_gc_needed(ekv_t *const me)
+{
+    for (uint16_t i = 0; i < me->flash->sector_count; i ++)
+    {
+        if (me->seq[i] == EKV_SEQ_GARBAGE)
+        {
+            return true;
+        }
+    }
+
+    return (me->erased <= EKV_GC_THRESHOLD) ? true : false;
+}
+
+int32_t ekv_gc(ekv_t *const me)
+{
+    ekv_flash_t *flash = me->flash;
+
+    /* The sectors broken in the erase are erased first. */
+    for (uint16_t i = 0; i < flash->sector_count; i ++)
+    {
+        if (me->seq[i] == EKV_SEQ_GARBAGE)
+        {
+            return ekv_sector_erase_(me, i);
+        }
+    }
+
+    /* Find the oldest sector except the head. */
+    uint16_t sector = EKV_SECTOR_NONE;
+    for (uint16_t i = 0; i < flash->sector_count; i ++)
+    {
+        if (me->seq[i] < EKV_SEQ_GARBAGE && i != me->sector_head &&
+            (sector == EKV_SECTOR_NONE || me->seq[i] < me->seq[sector]))
+        {
+            sector = i;
+        }
+    }
+    if (sector == EKV_SECTOR_NONE)
+    {
+        return EKV_FULL;
+    }
+
+    /* Copy the live records to the head. The last erased sector is left to the
+       compaction, so it never runs out of room. */
+    uint32_t addr = sector * flash->sector_size + sizeof(ekv_sector_head_t);
+    uint32_t end = (sector + 1) * flash->sector_size;
+    uint32_t size_stale = 0;
+    while (addr < end)
+    {
+        int32_t size = ekv_record_read_(me, addr, end);
+        if (size <= 0)
+        {
+            size_stale += end - addr;
+            break;
+        }
+
+        ekv_record_head_t *head = (ekv_record_head_t *)me->buffer;
+        const char *key = (const char *)&me->buffer[EKV_RECORD_HEAD_SIZE];
+        int32_t index = -1;
+        if (head->magic == EKV_RECORD_MAGIC)
+        {
+            index = ekv_index_find_(me, key, head->key_size,
+                                    ekv_hash(key, head->key_size));
+        }
+        if (index >= 0 && me->index[index].addr == addr)
+        {
+            uint32_t addr_new;
+            int32_t ret = ekv_append_(me, (uint32_t)size, 0, &addr_new);
+            if (ret != EKV_OK)
+            {
+                return ret;
+            }
+            me->index[index].addr = addr_new;
+        }
+        else
+        {
+            size_stale += (uint32_t)size;
+        }
+        addr += (uint32_t)size;
+    }
+
+    int32_t ret = ekv_sector_erase_(me, sector);
+    if (ret != EKV_OK)
+    {
+        return ret;
+    }
+
+    /* No room is gained if all the records are live. */
+    return (size_stale == 0) ? EKV_FULL : EKV_OK;
+}
+
+/* private function --------------------------------------------------------- */
+static const uint32_t ekv_crc_table[16] =
+{
+    0x00000000U, 0x1db71064U, 0x3b6e20c8U, 0x26d930acU,
+    0x76dc4190U, 0x6b6b51f4U, 0x4db26158U, 0x5005713cU,
+    0xedb88320U, 0xf00f9344U, 0xd6d6a3e8U, 0xcb61b38cU,
+    0x9b64c2b0U, 0x86d3d2d4U, 0xa00ae278U, 0xbdbdf21cU,
+};
+
+/* The CRC32 of IEEE 802.3, with a table of 16 entries. */
+static uint32_t ekv_crc32(uint32_t crc, const void *data, uint32_t size)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    crc = ~crc;
+    for (uint32_t i = 0; i < size; i ++)
+    {
+        crc = ekv_crc_table[(crc ^ p[i]) & 0x0f] ^ (crc >> 4);
+        crc = ekv_crc_table[(crc ^ (p[i] >> 4)) & 0x0f] ^ (crc >> 4);
+    }
+
+    return ~crc;
+}
+
+/* time33 */
+static uint32_t ekv_hash(const char *key, uint8_t size)
+{
+    uint32_t hash = 5381;
+
+    for (uint8_t i = 0; i < size; i ++)
+    {
+        hash = (hash << 5) + hash + (uint8_t)key[i];
+    }
+
+    return hash;
+}
+
+/* Read the record at the address into the buffer. Return the size of it in the
+   flash, 0 at the end of the written part, or EKV_ERROR if the head is broken.
+   A record with a wrong CRC keeps its size, and its magic is cleared in the
+   buffer. */
+static int32_t ekv_record_read_(ekv_t *const me, uint32_t addr, uint32_t end)
+{
+    ekv_flash_t *flash = me->flash;
+    ekv_record_head_t *head = (ekv_record_head_t *)me->buffer;
+
+    if ((end - addr) < EKV_RECORD_HEAD_SIZE)
+    {
+        return 0;
+    }
+    if (flash->read(flash, addr, head, EKV_RECORD_HEAD_SIZE) != 0)
+    {
+        return EKV_ERROR;
+    }
+    if (head->magic == 0xffffU)
+    {
+        return 0;
+    }
+
+    uint32_t size = EKV_ALIGN(EKV_RECORD_HEAD_SIZE + head->key_size +
+                              head->value_size);
+    if (head->magic != EKV_RECORD_MAGIC ||
+        head->key_size == 0 || head->key_size > EKV_KEY_SIZE_MAX ||
+        head->value_size > EKV_VALUE_SIZE_MAX || size > (end - addr))
+    {
+        return EKV_ERROR;
+    }
+
+    if (flash->read(flash, addr + EKV_RECORD_HEAD_SIZE,
+                    &me->buffer[EKV_RECORD_HEAD_SIZE],
+                    size - EKV_RECORD_HEAD_SIZE) != 0)
+    {
+        return EKV_ERROR;
+    }
+    uint32_t crc = ekv_crc32(0, &me->buffer[EKV_RECORD_CRC_OFFSET],
+                             EKV_RECORD_CRC_SIZE);
+    crc = ekv_crc32(crc, &me->buffer[EKV_RECORD_HEAD_SIZE],
+                    head->key_size + head->value_size);
+    if (crc != head->crc)
+    {
+        me->record_broken ++;
+        head->magic = 0;
+    }
+
+    return (int32_t)size;
+}
+
+static int32_t ekv_index_find_(ekv_t *const me,
+                               const char *key, uint8_t key_size, uint32_t hash)
+{
+    char key_flash[EKV_KEY_SIZE_MAX];
+
+    for (uint16_t i = 0; i < me->count; i ++)
+    {
+        if (me->index[i].hash != hash)
+        {
+            continue;
+        }
+
+        /* Compare the key in the flash, as the RAM only holds the hash. */
+        ekv_record_head_t head;
+        uint32_t addr = me->index[i].addr;
+        if (me->flash->read(me->flash, addr, &head, EKV_RECORD_HEAD_SIZE) != 0 ||
+            head.key_size != key_size ||
+            me->flash->read(me->flash, addr + EKV_RECORD_HEAD_SIZE,
+                            key_flash, key_size) != 0)
+        {
+            continue;
+        }
+        if (memcmp(key_flash, key, key_size) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/* Point the index to the record in the buffer at the address. */
+static int32_t ekv_index_update_(ekv_t *const me, uint32_t addr)
+{
+    ekv_record_head_t *head = (ekv_record_head_t *)me->buffer;
+    const char *key = (const char *)&me->buffer[EKV_RECORD_HEAD_SIZE];
+    uint32_t hash = ekv_hash(key, head->key_size);
+
+    int32_t index = ekv_index_find_(me, key, head->key_size, hash);
+    if (index < 0)
+    {
+        if (me->count >= EKV_MAX_KEYS)
+        {
+            return EKV_FULL;
+        }
+        index = me->count ++;
+        me->index[index].hash = hash;
+    }
+    me->index[index].addr = addr;
+
+    return EKV_OK;
+}
+
+/* Add the records of the sector to the index. Return the offset after the last
+   record, or the sector size if the rest of the sector can not be written. */
+static int32_t ekv_sector_scan_(ekv_t *const me, uint16_t sector)
+{
+    uint32_t base = sector * me->flash->sector_size;
+    uint32_t end = base + me->flash->sector_size;
+    uint32_t addr = base + sizeof(ekv_sector_head_t);
+
+    while (addr < end)
+    {
+        int32_t size = ekv_record_read_(me, addr, end);
+        if (size == 0)
+        {
+            break;
+        }
+        if (size < 0)
+        {
+            me->record_broken ++;
+            return (int32_t)me->flash->sector_size;
+        }
+
+        ekv_record_head_t *head = (ekv_record_head_t *)me->buffer;
+        if (head->magic == EKV_RECORD_MAGIC)
+        {
+            int32_t ret = ekv_index_update_(me, addr);
+            if (ret != EKV_OK)
+            {
+                return ret;
+            }
+        }
+        addr += (uint32_t)size;
+    }
+
+    return (int32_t)(addr - base);
+}
+
+static bool ekv_sector_blank_(ekv_t *const me, uint16_t sector)
+{
+    uint32_t base = sector * me->flash->sector_size;
+
+    for (uint32_t offset = 0; offset < me->flash->sector_size;
+         offset += EKV_RECORD_SIZE_MAX)
+    {
+        uint32_t size = me->flash->sector_size - offset;
+        if (size > EKV_RECORD_SIZE_MAX)
+        {
+            size = EKV_RECORD_SIZE_MAX;
+        }
+        if (me->flash->read(me->flash, base + offset, me->buffer, size) != 0)
+        {
+            return false;
+        }
+        for (uint32_t i = 0; i < size; i ++)
+        {
+            if (me->buffer[i] != 0xff)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static int32_t ekv_sector_erase_(ekv_t *const me, uint16_t sector)
+{
+    if (me->flash->erase(me->flash, sector * me->flash->sector_size) != 0)
+    {
+        return EKV_ERROR;
+    }
+
+    me->seq[sector] = EKV_SEQ_ERASED;
+    me->erased ++;
+    me->erase_count ++;
+
+    return EKV_OK;
+}
+
+static bool ekv_has_room_(ekv_t *const me, uint32_t size, uint16_t reserve)
+{
+    if (me->sector_head != EKV_SECTOR_NONE &&
+        (me->offset + size) <= me->flash->sector_size)
+    {
+        return true;
+    }
+
+    return (me->erased > reserve) ? true : false;
+}
+
+/* Write the record in the buffer to the head. A new sector is opened if the
+   head is full, leaving the reserved count of erased sectors. */
+static int32_t ekv_append_(ekv_t *const me,
+                           uint32_t size, uint16_t reserve, uint32_t *addr)
+{
+    ekv_flash_t *flash = me->flash;
+
+    if (me->sector_head == EKV_SECTOR_NONE ||
+        (me->offset + size) > flash->sector_size)
+    {
+        if (me->erased <= reserve)
+        {
+            return EKV_FULL;
+        }
+
+        /* Open the next erased sector in the ring. */
+        uint16_t sector = (me->sector_head == EKV_SECTOR_NONE) ?
+                          0 : ((me->sector_head + 1) % flash->sector_count);
+        while (me->seq[sector] != EKV_SEQ_ERASED)
+        {
+            sector = (sector + 1) % flash->sector_count;
+        }
+
+        ekv_sector_head_t head;
+        head.magic = EKV_SECTOR_MAGIC;
+        head.seq = me->seq_max + 1;
+        if (flash->write(flash, sector * flash->sector_size,
+                         &head, sizeof(head)) != 0)
+        {
+            return EKV_ERROR;
+        }
+        me->seq_max = head.seq;
+        me->seq[sector] = head.seq;
+        me->erased --;
+        me->sector_head = sector;
+        me->offset = sizeof(ekv_sector_head_t);
+    }
+
+    *addr = me->sector_head * flash->sector_size + me->offset;
+    if (flash->write(flash, *addr, me->buffer, size) != 0)
+    {
+        return EKV_ERROR;
+    }
+    me->offset += size;
+
+    return EKV_OK;
+}
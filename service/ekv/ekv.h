@@ -0,0 +1,105 @@
+#ifndef EKV_H
+#define EKV_H
+
+/*
+ * The log-structured key-value store on the NOR flash.
+ *
+ * Every write appends a record with a CRC to the head sector, and the latest
+ * record of a key wins. The sectors are opened in a ring with an increasing
+ * sequence number, so the erases are spread over all sectors. The compaction
+ * copies the live records of the oldest sector to the head and erases it. It
+ * is done by ekv_gc(), which is called in a low-priority task, and the writer
+ * only appends. The RAM index holds one entry per key, and is rebuilt by one
+ * scan of the flash in ekv_init().
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* config ------------------------------------------------------------------- */
+#ifndef EKV_MAX_KEYS
+#define EKV_MAX_KEYS                        (64)
+#endif
+
+#ifndef EKV_SECTOR_MAX
+#define EKV_SECTOR_MAX                      (32)
+#endif
+
+#ifndef EKV_KEY_SIZE_MAX
+#define EKV_KEY_SIZE_MAX                    (32)
+#endif
+
+#ifndef EKV_VALUE_SIZE_MAX
+#define EKV_VALUE_SIZE_MAX                  (256)
+#endif
+
+/* The compaction is needed when no more erased sectors than it are left. */
+#ifndef EKV_GC_THRESHOLD
+#define EKV_GC_THRESHOLD                    (2)
+#endif
+
+/* define-------------------------------------------------------------------- */
+#define EKV_RECORD_SIZE_MAX                 (((12 + EKV_KEY_SIZE_MAX +          \
+                                               EKV_VALUE_SIZE_MAX) + 3) & ~3)
+
+enum
+{
+    EKV_OK = 0,
+    EKV_ERROR = -1,
+    EKV_NOT_FOUND = -2,
+    EKV_FULL = -3,
+};
+
+/* data structure ----------------------------------------------------------- */
+/*
+ * The flash driver. The erased byte is 0xff, and the write only clears bits.
+ * The address is from 0 to sector_size * sector_count. The functions return 0
+ * on success.
+ */
+typedef struct ekv_flash
+{
+    uint32_t sector_size;
+    uint16_t sector_count;
+    int32_t (* read)(struct ekv_flash *me, uint32_t addr, void *data, uint32_t size);
+    int32_t (* write)(struct ekv_flash *me,
+                      uint32_t addr, const void *data, uint32_t size);
+    int32_t (* erase)(struct ekv_flash *me, uint32_t addr);
+    void *user_data;
+} ekv_flash_t;
+
+typedef struct ekv_index
+{
+    uint32_t hash;
+    uint32_t addr;                          /* The latest record of the key */
+} ekv_index_t;
+
+typedef struct ekv
+{
+    ekv_flash_t *flash;
+    ekv_index_t index[EKV_MAX_KEYS];
+    uint32_t seq[EKV_SECTOR_MAX];           /* The sequence of each sector */
+    uint32_t seq_max;
+    uint32_t offset;                        /* The write offset in the head */
+    uint16_t count;                         /* The count of the keys */
+    uint16_t sector_head;
+    uint16_t erased;                        /* The count of the erased sectors */
+
+    uint32_t erase_count;
+    uint32_t record_broken;
+    uint8_t buffer[EKV_RECORD_SIZE_MAX];
+} ekv_t;
+
+/* function ----------------------------------------------------------------- */
+int32_t ekv_init(ekv_t *const me, ekv_flash_t *flash);
+int32_t ekv_set(ekv_t *const me, const char *key, const void *value, uint16_t size);
+int32_t ekv_get(ekv_t *const me, const char *key, void *value, uint16_t size);
+bool ekv_gc_needed(ekv_t *const me);
+int32_t ekv_gc(ekv_t *const me);
+
+/* The flash simulator on a file, for the host. */
+int32_t ekv_flash_file_init(ekv_flash_t *flash, const char *path,
+                            uint32_t sector_size, uint16_t sector_count);
+void ekv_flash_file_exit(ekv_flash_t *flash);
+
+#endif
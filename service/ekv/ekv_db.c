@@ -0,0 +1,135 @@
+/*
+ * The persistent value keys of the EventOS db on ekv. The keys are saved and
+ * the flash is compacted in one low-priority task, so a writer of the db never
+ * waits for the flash write or the sector erase.
+ */
+
+/* include ------------------------------------------------------------------ */
+#include "ekv.h"
+#include "ekv_db.h"
+#include "eos.h"
+
+/* private data ------------------------------------------------------------- */
+static ekv_t *ekv_db;
+static eos_task_t task_ekv;
+static eos_sem_t sem_ekv;
+static eos_mutex_t mutex_ekv;
+/* The copy of the key saved by the flush. */
+static uint32_t ekv_db_buffer[(EKV_VALUE_SIZE_MAX + 3) / 4];
+
+/* private function --------------------------------------------------------- */
+static bool ekv_db_load(const char *key, void *data, eos_u32_t size);
+static bool ekv_db_save(const char *key, const void *data, eos_u32_t size);
+static void ekv_db_notify(void);
+static void task_func_ekv(void *parameter);
+
+static const eos_db_persist_t ekv_db_persist =
+{
+    ekv_db_load, ekv_db_save, ekv_db_notify, EKV_VALUE_SIZE_MAX, ekv_db_buffer,
+};
+
+/* public function ---------------------------------------------------------- */
+int32_t ekv_db_init(ekv_t *const me, ekv_flash_t *flash,
+                    void *stack, uint32_t stack_size, uint8_t priority)
+{
+    /* Rebuild the index before the persistent keys are registered. */
+    int32_t ret = ekv_init(me, flash);
+    if (ret != EKV_OK)
+    {
+        return ret;
+    }
+    ekv_db = me;
+
+    eos_sem_init(&sem_ekv, 0);
+    eos_mutex_init(&mutex_ekv);
+    eos_db_persist_set(&ekv_db_persist);
+
+    eos_task_init(&task_ekv, "TaskEkv", task_func_ekv, EOS_NULL,
+                  stack, stack_size, priority);
+    eos_task_startup(&task_ekv);
+
+    /* The sectors broken by a power loss are erased in the task. */
+    eos_sem_release(&sem_ekv);
+
+    return EKV_OK;
+}
+
+/* private function --------------------------------------------------------- */
+static bool ekv_db_load(const char *key, void *data, eos_u32_t size)
+{
+    if (size > EKV_VALUE_SIZE_MAX)
+    {
+        return false;
+    }
+
+    /* The keys are mostly registered before the kernel starts, when there is
+       no task to hold the mutex, and no other task to share ekv with. */
+    bool running = (eos_task_self() != EOS_NULL) ? true : false;
+    if (running)
+    {
+        eos_mutex_take(&mutex_ekv, EOS_WAIT_FOREVER);
+    }
+
+    /* The stored value is ignored if the size of the key is changed. */
+    int32_t ret = ekv_get(ekv_db, key, data, 0);
+    if (ret == (int32_t)size)
+    {
+        ret = ekv_get(ekv_db, key, data, (uint16_t)size);
+    }
+
+    if (running)
+    {
+        eos_mutex_release(&mutex_ekv);
+    }
+
+    return (ret == (int32_t)size) ? true : false;
+}
+
+static bool ekv_db_save(const char *key, const void *data, eos_u32_t size)
+{
+    if (size > EKV_VALUE_SIZE_MAX)
+    {
+        return false;
+    }
+
+    eos_mutex_take(&mutex_ekv, EOS_WAIT_FOREVER);
+    int32_t ret = ekv_set(ekv_db, key, data, (uint16_t)size);
+    eos_mutex_release(&mutex_ekv);
+
+    return (ret == EKV_OK) ? true : false;
+}
+
+/* Called in the writer of the db, with the interrupt disabled. */
+static void ekv_db_notify(void)
+{
+    eos_sem_release(&sem_ekv);
+}
+
+static void task_func_ekv(void *parameter)
+{
+    (void)parameter;
+
+    while (1)
+    {
+        eos_sem_take(&sem_ekv, EOS_WAIT_FOREVER);
+        bool saved = (eos_db_persist_flush() >= 0) ? true : false;
+
+        /* Compact one sector at a time, so the mutex is not held long. */
+        bool gc_done = false;
+        while (gc_done == false)
+        {
+            eos_mutex_take(&mutex_ekv, EOS_WAIT_FOREVER);
+            gc_done = (ekv_gc_needed(ekv_db) == false ||
+                       ekv_gc(ekv_db) != EKV_OK) ? true : false;
+            eos_mutex_release(&mutex_ekv);
+        }
+
+        /* The keys not saved, such as the flash was full before the
+           compaction, are still marked, and are saved again later. */
+        if (saved == false)
+        {
+            eos_task_delay_ms(EKV_DB_RETRY_MS);
+            eos_sem_release(&sem_ekv);
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef EKV_DB_H
+#define EKV_DB_H
+
+/* include ------------------------------------------------------------------ */
+#include "ekv.h"
+
+/* config ------------------------------------------------------------------- */
+/* The keys not saved are tried again after this time. */
+#ifndef EKV_DB_RETRY_MS
+#define EKV_DB_RETRY_MS                     (100)
+#endif
+
+/* function ----------------------------------------------------------------- */
+/* Store the persistent value keys of the db on ekv. It is called after
+   eos_init() and before the persistent keys are registered, and starts the
+   storage task at the given priority, which should be the lowest one. */
+int32_t ekv_db_init(ekv_t *const me, ekv_flash_t *flash,
+                    void *stack, uint32_t stack_size, uint8_t priority);
+
+#endif
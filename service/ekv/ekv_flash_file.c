@@ -0,0 +1,134 @@
+
+/*
+ * The NOR flash simulator on a file, for the test of ekv on the host. The
+ * write clears the bits only, as the real flash does, and the erase sets all
+ * the bytes of the sector to 0xff.
+ */
+
+/* include ------------------------------------------------------------------ */
+#include "ekv.h"
+#include <stdio.h>
+#include <string.h>
+
+/* private function --------------------------------------------------------- */
+static int32_t flash_file_read(ekv_flash_t *me,
+                               uint32_t addr, void *data, uint32_t size);
+static int32_t flash_file_write(ekv_flash_t *me,
+                                uint32_t addr, const void *data, uint32_t size);
+static int32_t flash_file_erase(ekv_flash_t *me, uint32_t addr);
+
+/* public function ---------------------------------------------------------- */
+int32_t ekv_flash_file_init(ekv_flash_t *flash, const char *path,
+                            uint32_t sector_size, uint16_t sector_count)
+{
+    flash->sector_size = sector_size;
+    flash->sector_count = sector_count;
+    flash->read = flash_file_read;
+    flash->write = flash_file_write;
+    flash->erase = flash_file_erase;
+
+    /* Keep the content of an existing file, as the flash after a reboot. */
+    FILE *file = fopen(path, "r+b");
+    if (file == NULL)
+    {
+        file = fopen(path, "w+b");
+        if (file == NULL)
+        {
+            return EKV_ERROR;
+        }
+    }
+    flash->user_data = file;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    long size_flash = (long)sector_size * sector_count;
+    for (; size < size_flash; size ++)
+    {
+        fputc(0xff, file);
+    }
+    fflush(file);
+
+    return EKV_OK;
+}
+
+void ekv_flash_file_exit(ekv_flash_t *flash)
+{
+    fclose((FILE *)flash->user_data);
+    flash->user_data = NULL;
+}
+
+/* private function --------------------------------------------------------- */
+static int32_t flash_file_read(ekv_flash_t *me,
+                               uint32_t addr, void *data, uint32_t size)
+{
+    FILE *file = (FILE *)me->user_data;
+
+    if ((addr + size) > (me->sector_size * me->sector_count) ||
+        fseek(file, (long)addr, SEEK_SET) != 0 ||
+        fread(data, 1, size, file) != size)
+    {
+        return EKV_ERROR;
+    }
+
+    return EKV_OK;
+}
+
+static int32_t flash_file_write(ekv_flash_t *me,
+                                uint32_t addr, const void *data, uint32_t size)
+{
+    FILE *file = (FILE *)me->user_data;
+    uint8_t buffer[64];
+
+    for (uint32_t offset = 0; offset < size; offset += sizeof(buffer))
+    {
+        uint32_t count = size - offset;
+        if (count > sizeof(buffer))
+        {
+            count = sizeof(buffer);
+        }
+        if (flash_file_read(me, addr + offset, buffer, count) != EKV_OK)
+        {
+            return EKV_ERROR;
+        }
+        for (uint32_t i = 0; i < count; i ++)
+        {
+            buffer[i] &= ((const uint8_t *)data)[offset + i];
+        }
+        if (fseek(file, (long)(addr + offset), SEEK_SET) != 0 ||
+            fwrite(buffer, 1, count, file) != count)
+        {
+            return EKV_ERROR;
+        }
+    }
+    fflush(file);
+
+    return EKV_OK;
+}
+
+static int32_t flash_file_erase(ekv_flash_t *me, uint32_t addr)
+{
+    FILE *file = (FILE *)me->user_data;
+    uint8_t buffer[64];
+
+    memset(buffer, 0xff, sizeof(buffer));
+    addr -= addr % me->sector_size;
+    if (fseek(file, (long)addr, SEEK_SET) != 0)
+    {
+        return EKV_ERROR;
+    }
+    for (uint32_t offset = 0; offset < me->sector_size; offset += sizeof(buffer))
+    {
+        uint32_t count = me->sector_size - offset;
+        if (count > sizeof(buffer))
+        {
+            count = sizeof(buffer);
+        }
+        if (fwrite(buffer, 1, count, file) != count)
+        {
+            return EKV_ERROR;
+        }
+    }
+    fflush(file);
+
+    return EKV_OK;
+}
@@ -0,0 +1,249 @@
+/*
+ * The test of ekv on the host, with the flash simulated by a file.
+ *
+ * Random values are written to the keys, and the compaction runs when needed,
+ * as the background task does. The store is reopened from the file now and
+ * then, as after a reboot, and all the keys are checked against a model. The
+ * power loss is simulated by cutting a write or an erase in the middle, after
+ * which every key must hold its last written value, or the previous one for
+ * the cut write. In the end, the erase counts of the sectors are compared.
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ekv.h"
+
+/* private config ----------------------------------------------------------- */
+#define TEST_FILE                       "build/flash.bin"
+#define TEST_SECTOR_SIZE                4096
+#define TEST_SECTOR_COUNT               8
+#define TEST_KEYS                       40
+#define TEST_TIMES                      200000
+#define TEST_REBOOT_PERIOD              997
+#define TEST_POWER_LOSS_PERIOD          4999
+
+/* private data structure --------------------------------------------------- */
+typedef struct test_key
+{
+    char name[16];
+    uint16_t size;
+    uint8_t value[EKV_VALUE_SIZE_MAX];
+    uint8_t value_last[EKV_VALUE_SIZE_MAX];
+    bool written;
+} test_key_t;
+
+/* private data ------------------------------------------------------------- */
+static ekv_flash_t flash;
+static ekv_t kv;
+static test_key_t keys[TEST_KEYS];
+static uint32_t rand_seed = 1;
+static uint32_t error = 0;
+
+/* The byte budget of the writes and the erases before the power loss, and the
+   erase count of each sector. */
+static int32_t power_budget = -1;
+static uint32_t erase_count[TEST_SECTOR_COUNT];
+static int32_t (* flash_write)(ekv_flash_t *me,
+                               uint32_t addr, const void *data, uint32_t size);
+static int32_t (* flash_erase)(ekv_flash_t *me, uint32_t addr);
+
+/* flash with power loss ---------------------------------------------------- */
+static int32_t test_flash_write(ekv_flash_t *me,
+                                uint32_t addr, const void *data, uint32_t size)
+{
+    if (power_budget >= 0)
+    {
+        if (power_budget < (int32_t)size)
+        {
+            flash_write(me, addr, data, (uint32_t)power_budget);
+            power_budget = 0;
+            return EKV_ERROR;
+        }
+        power_budget -= (int32_t)size;
+    }
+
+    return flash_write(me, addr, data, size);
+}
+
+static int32_t test_flash_erase(ekv_flash_t *me, uint32_t addr)
+{
+    if (power_budget >= 0 && power_budget < TEST_SECTOR_SIZE)
+    {
+        /* Half of the sector is erased, and the head is kept broken. */
+        uint8_t data[TEST_SECTOR_SIZE / 2];
+        memset(data, 0, sizeof(data));
+        flash_write(me, addr + TEST_SECTOR_SIZE / 2, data, sizeof(data));
+        power_budget = 0;
+        return EKV_ERROR;
+    }
+
+    erase_count[addr / TEST_SECTOR_SIZE] ++;
+
+    return flash_erase(me, addr);
+}
+
+/* test --------------------------------------------------------------------- */
+static uint32_t test_rand(void)
+{
+    rand_seed = rand_seed * 1103515245U + 12345U;
+
+    return (rand_seed >> 16) & 0x7fff;
+}
+
+static void test_open(void)
+{
+    if (flash.user_data != NULL)
+    {
+        ekv_flash_file_exit(&flash);
+    }
+    if (ekv_flash_file_init(&flash, TEST_FILE,
+                            TEST_SECTOR_SIZE, TEST_SECTOR_COUNT) != EKV_OK)
+    {
+        printf("Failed to open %s.\n", TEST_FILE);
+        exit(-1);
+    }
+    flash_write = flash.write;
+    flash_erase = flash.erase;
+    flash.write = test_flash_write;
+    flash.erase = test_flash_erase;
+
+    if (ekv_init(&kv, &flash) != EKV_OK)
+    {
+        printf("Failed to init ekv.\n");
+        exit(-1);
+    }
+}
+
+static void test_check(uint32_t times, int32_t key_cut)
+{
+    uint8_t value[EKV_VALUE_SIZE_MAX];
+
+    for (int32_t i = 0; i < TEST_KEYS; i ++)
+    {
+        int32_t ret = ekv_get(&kv, keys[i].name, value, keys[i].size);
+        if (!keys[i].written)
+        {
+            if (ret != EKV_NOT_FOUND)
+            {
+                printf("%u: %s is not written, but found.\n", times, keys[i].name);
+                error ++;
+            }
+            continue;
+        }
+
+        if (ret == keys[i].size && memcmp(value, keys[i].value, ret) == 0)
+        {
+            continue;
+        }
+
+        /* The write cut by the power loss may be lost. */
+        if (i == key_cut && ret == keys[i].size &&
+            memcmp(value, keys[i].value_last, ret) == 0)
+        {
+            memcpy(keys[i].value, keys[i].value_last, keys[i].size);
+            continue;
+        }
+
+        printf("%u: %s is wrong, %d.\n", times, keys[i].name, ret);
+        error ++;
+    }
+}
+
+static void test_gc(void)
+{
+    while (ekv_gc_needed(&kv) && ekv_gc(&kv) == EKV_OK)
+    {
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    remove(TEST_FILE);
+    test_open();
+
+    for (int32_t i = 0; i < TEST_KEYS; i ++)
+    {
+        sprintf(keys[i].name, "Key_%d", i);
+        keys[i].size = 1 + (i * 37) % EKV_VALUE_SIZE_MAX / 4;
+        keys[i].written = false;
+    }
+
+    uint32_t power_loss = 0;
+    for (uint32_t times = 1; times <= TEST_TIMES; times ++)
+    {
+        int32_t i = test_rand() % TEST_KEYS;
+        memcpy(keys[i].value_last, keys[i].value, keys[i].size);
+        for (uint16_t j = 0; j < keys[i].size; j ++)
+        {
+            keys[i].value[j] = (uint8_t)test_rand();
+        }
+
+        /* Cut the power in this write, or in the compaction after it. */
+        bool cut = ((times % TEST_POWER_LOSS_PERIOD) == 0) ? true : false;
+        if (cut)
+        {
+            power_budget = test_rand() % (TEST_SECTOR_SIZE * 2);
+        }
+
+        int32_t ret = ekv_set(&kv, keys[i].name, keys[i].value, keys[i].size);
+        bool written = keys[i].written;
+        keys[i].written = true;
+        if (ret == EKV_OK)
+        {
+            test_gc();
+        }
+
+        if (cut)
+        {
+            /* Reboot after the power loss. */
+            power_budget = -1;
+            power_loss ++;
+            if (!written && ret != EKV_OK)
+            {
+                keys[i].written = false;
+            }
+            test_open();
+            test_check(times, (ret == EKV_OK) ? -1 : i);
+            test_gc();
+        }
+        else if (ret != EKV_OK)
+        {
+            printf("%u: Failed to set %s, %d.\n", times, keys[i].name, ret);
+            error ++;
+        }
+        else if ((times % TEST_REBOOT_PERIOD) == 0)
+        {
+            test_open();
+            test_check(times, -1);
+        }
+    }
+
+    test_open();
+    test_check(TEST_TIMES, -1);
+
+    uint32_t erase_min = erase_count[0], erase_max = erase_count[0];
+    for (uint32_t i = 1; i < TEST_SECTOR_COUNT; i ++)
+    {
+        erase_min = (erase_count[i] < erase_min) ? erase_count[i] : erase_min;
+        erase_max = (erase_count[i] > erase_max) ? erase_count[i] : erase_max;
+    }
+    printf("%u writes, %u power losses, %u broken records.\n",
+           TEST_TIMES, power_loss, kv.record_broken);
+    printf("The erase count of the sectors, %u ~ %u.\n", erase_min, erase_max);
+    if (erase_max > (erase_min * 2 + 2))
+    {
+        printf("The erases are not spread.\n");
+        error ++;
+    }
+
+    ekv_flash_file_exit(&flash);
+    printf("%s\n", (error == 0) ? "Passed." : "Failed.");
+
+    return (error == 0) ? 0 : -1;
+}
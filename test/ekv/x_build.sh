@@ -0,0 +1,11 @@
+#!/bin/sh
+# Build and run the test of ekv on the host.
+
+mkdir -p build
+
+gcc -std=gnu99 -O2 -g -Wall \
+    main.c \
+    ../../service/ekv/ekv.c \
+    ../../service/ekv/ekv_flash_file.c \
+    -I ../../service/ekv \
+    -o build/ekv && ./build/ekv
@@ -0,0 +1,11 @@
+#include "bsp.h"
+#include "cpu_port.h"
+
+#define BSP_INTERRUPT_TIMER                 0x01
+
+void timer_isr_1ms(void);
+
+void timer_init(uint32_t time_ms)
+{
+    eos_hw_interrupt_register(BSP_INTERRUPT_TIMER, timer_isr_1ms, time_ms);
+}
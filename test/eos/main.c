@@ -12,7 +12,7 @@ int main(void)
     eos_init();                                     // EventOS初始化
     
     // Start EventOS Database.
-    static uint8_t db_memory[5120];
+    static uint8_t db_memory[6144];
     eos_db_init(db_memory, sizeof(db_memory));
 
     test_init();
@@ -4,7 +4,10 @@
 #include "eos_config.h"
 
 #define TEST_TIME_MAX                   10000
+/* 0: the tests selected below, 1: test 18 of "./x_build.sh phash". */
+#ifndef TEST_MODE
 #define TEST_MODE                       0
+#endif
 
 #if (TEST_MODE == 0)
 
@@ -19,7 +22,21 @@
 #define TEST_EN_05_1                    0
 #define TEST_EN_06                      1
 #define TEST_EN_07                      0
+#define TEST_EN_08                      0
 #define TEST_EN_09                      0
+#define TEST_EN_10                      0
+#define TEST_EN_11                      0
+#define TEST_EN_12                      0
+#define TEST_EN_13                      0
+#define TEST_EN_14                      0
+#define TEST_EN_15                      0
+#define TEST_EN_16                      0
+#define TEST_EN_17                      0
+#define TEST_EN_18                      0
+
+#elif (TEST_MODE == 1)
+
+#define TEST_EN_18                      1
 
 #endif
 
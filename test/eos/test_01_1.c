@@ -151,7 +151,7 @@ static void task_func_e_give1(void *parameter)
         eos_test.time = eos_tick_get_ms();
         eos_test.send_count ++;
         eos_test.send_give1_count ++;
-        eos_test.send_speed = eos_test.send_count / eos_test.time;
+        eos_test.send_speed = (eos_test.time == 0) ? 0 : (eos_test.send_count / eos_test.time);
         
         eos_event_send_id(task_id, "Event_One");
     }
@@ -166,7 +166,7 @@ static void task_func_e_give2(void *parameter)
         eos_test.time = eos_tick_get_ms();
         eos_test.send_count ++;
         eos_test.send_give2_count ++;
-        eos_test.send_speed = eos_test.send_count / eos_test.time;
+        eos_test.send_speed = (eos_test.time == 0) ? 0 : (eos_test.send_count / eos_test.time);
         
         eos_event_send_id(task_id, "Event_One");
     }
@@ -0,0 +1,357 @@
+#include "test.h"
+#include <stdint.h>
+#include "eos.h"
+#include "bsp.h"
+
+#if (TEST_EN_10 != 0)
+
+/*
+ * The fragmentation benchmark of the heap. The same pseudo-random workload of
+ * event-record-sized and db-key-sized blocks runs on the TLSF heap and on a
+ * copy of the former first-fit heap, and the time, the failures and the
+ * largest free block in the end are recorded in eos_test. A heap larger than
+ * 32 KB must give one block of nearly all of it.
+ */
+
+/* private config ----------------------------------------------------------- */
+#define HEAP_TEST_SIZE                  5120
+#define HEAP_TEST_SLOTS                 64
+#define HEAP_TEST_TIMES                 20000
+#define HEAP_LARGE_SIZE                 40960
+
+/* private data structure --------------------------------------------------- */
+typedef struct heap_result
+{
+    uint32_t time_ms;
+    uint32_t malloc_count;
+    uint32_t malloc_failed;
+    uint32_t largest_free;
+} heap_result_t;
+
+typedef struct eos_test
+{
+    uint32_t error;
+    uint32_t finished;
+
+    heap_result_t tlsf;
+    heap_result_t first_fit;
+
+    /* The statistics of the TLSF heap after the benchmark, and the db heap. */
+    eos_heap_stat_t tlsf_stat;
+    eos_heap_stat_t db_stat;
+    uint32_t walk_used_blocks;
+    uint32_t walk_free_blocks;
+    uint32_t large_block;
+
+    uint32_t e_sm;
+    uint32_t e_reactor;
+    uint32_t idle_count;
+} eos_test_t;
+
+typedef struct task_test
+{
+    eos_task_t *task;
+    const char *name;
+    uint8_t prio;
+    void *stack;
+    uint32_t stack_size;
+    void (* func)(void *parameter);
+} task_test_info_t;
+
+/* The former first-fit heap, only kept here as the reference. */
+typedef struct ff_block
+{
+    struct ff_block *next;
+    uint32_t is_free                    : 1;
+    uint32_t size                       : 31;
+} ff_block_t;
+
+typedef struct ff_heap
+{
+    uint8_t *data;
+    ff_block_t *list;
+    uint32_t size;
+} ff_heap_t;
+
+typedef void (* heap_init_t)(void *heap, void *data, uint32_t size);
+typedef void *(* heap_malloc_t)(void *heap, uint32_t size);
+typedef void (* heap_free_t)(void *heap, void *data);
+
+static void task_func_bench(void *parameter);
+
+/* private data ------------------------------------------------------------- */
+static uint64_t stack_bench[128];
+static eos_task_t task_bench;
+
+static uint64_t heap_memory[HEAP_TEST_SIZE / sizeof(uint64_t)];
+static eos_heap_t heap_tlsf;
+static ff_heap_t heap_ff;
+static void *slot[HEAP_TEST_SLOTS];
+static uint64_t heap_large_memory[HEAP_LARGE_SIZE / sizeof(uint64_t)];
+static eos_heap_t heap_large;
+
+eos_test_t eos_test;
+
+static const task_test_info_t task_test_info[] =
+{
+    {
+        &task_bench, "TaskBench", TaskPrio_Middle,
+        stack_bench, sizeof(stack_bench),
+        task_func_bench
+    },
+};
+
+/* public function ---------------------------------------------------------- */
+void test_init(void)
+{
+    for (uint32_t i = 0;
+         i < (sizeof(task_test_info) / sizeof(task_test_info_t));
+         i ++)
+    {
+        eos_task_init(task_test_info[i].task,
+                       task_test_info[i].name,
+                       task_test_info[i].func,
+                       EOS_NULL,
+                       task_test_info[i].stack,
+                       task_test_info[i].stack_size,
+                       task_test_info[i].prio);
+        eos_task_startup(task_test_info[i].task);
+    }
+
+    timer_init(1);
+}
+
+void eos_sm_count(void)
+{
+    eos_test.e_sm ++;
+}
+
+void eos_reactor_count(void)
+{
+    eos_test.e_reactor ++;
+}
+
+void timer_isr_1ms(void)
+{
+    eos_interrupt_enter();
+    eos_interrupt_leave();
+}
+
+void eos_idle_count(void)
+{
+    eos_test.idle_count ++;
+}
+
+/* first-fit heap ----------------------------------------------------------- */
+static void ff_init(void *heap, void *data, uint32_t size)
+{
+    ff_heap_t *me = (ff_heap_t *)heap;
+
+    me->data = data;
+    me->list = (ff_block_t *)data;
+    me->size = size;
+    me->list->next = EOS_NULL;
+    me->list->size = size - sizeof(ff_block_t);
+    me->list->is_free = 1;
+}
+
+static void *ff_malloc(void *heap, uint32_t size)
+{
+    ff_heap_t *me = (ff_heap_t *)heap;
+    ff_block_t *block = me->list;
+
+    size = (size + 3) & ~3U;
+    while (block != EOS_NULL)
+    {
+        if (block->is_free == 1 && block->size > (size + sizeof(ff_block_t)))
+        {
+            break;
+        }
+        block = block->next;
+    }
+    if (block == EOS_NULL)
+    {
+        return EOS_NULL;
+    }
+
+    if (block->size <= (size + sizeof(ff_block_t)))
+    {
+        block->is_free = 0;
+    }
+    else
+    {
+        ff_block_t *new_block =
+            (ff_block_t *)((uint8_t *)block + size + sizeof(ff_block_t));
+        new_block->size = block->size - size - sizeof(ff_block_t);
+        new_block->is_free = 1;
+        new_block->next = block->next;
+        block->next = new_block;
+        block->size = size;
+        block->is_free = 0;
+    }
+
+    return (void *)((uint8_t *)block + sizeof(ff_block_t));
+}
+
+static void ff_free(void *heap, void *data)
+{
+    ff_heap_t *me = (ff_heap_t *)heap;
+    ff_block_t *block_crt = (ff_block_t *)((uint8_t *)data - sizeof(ff_block_t));
+    ff_block_t *block = me->list;
+    ff_block_t *block_last = EOS_NULL;
+
+    while (block != EOS_NULL && !(block->is_free == 0 && block == block_crt))
+    {
+        block_last = block;
+        block = block->next;
+    }
+    if (block == EOS_NULL)
+    {
+        eos_test.error ++;
+        return;
+    }
+
+    block->is_free = 1;
+    if (block_last != EOS_NULL && block_last->is_free == 1)
+    {
+        block_last->size += (block->size + sizeof(ff_block_t));
+        block_last->next = block->next;
+        block = block_last;
+    }
+    if (block->next != EOS_NULL && block->next->is_free == 1)
+    {
+        block->size += (block->next->size + sizeof(ff_block_t));
+        block->next = block->next->next;
+    }
+}
+
+/* tlsf heap ---------------------------------------------------------------- */
+static void tlsf_init(void *heap, void *data, uint32_t size)
+{
+    eos_heap_init((eos_heap_t *)heap, data, size);
+}
+
+static void *tlsf_malloc(void *heap, uint32_t size)
+{
+    return eos_heap_malloc((eos_heap_t *)heap, size);
+}
+
+static void tlsf_free(void *heap, void *data)
+{
+    eos_heap_free((eos_heap_t *)heap, data);
+}
+
+/* benchmark ---------------------------------------------------------------- */
+static uint32_t rand_seed;
+
+static uint32_t bench_rand(void)
+{
+    rand_seed = rand_seed * 1103515245U + 12345U;
+    return (rand_seed >> 16) & 0x7fff;
+}
+
+static void heap_bench(void *heap, heap_result_t *result,
+                       heap_init_t h_init, heap_malloc_t h_malloc,
+                       heap_free_t h_free)
+{
+    h_init(heap, heap_memory, sizeof(heap_memory));
+    for (uint32_t i = 0; i < HEAP_TEST_SLOTS; i ++)
+    {
+        slot[i] = EOS_NULL;
+    }
+    rand_seed = 1;
+
+    uint32_t time = eos_tick_get_ms();
+    for (uint32_t i = 0; i < HEAP_TEST_TIMES; i ++)
+    {
+        uint32_t index = bench_rand() % HEAP_TEST_SLOTS;
+        if (slot[index] != EOS_NULL)
+        {
+            h_free(heap, slot[index]);
+            slot[index] = EOS_NULL;
+            continue;
+        }
+
+        /* Mostly the event records, and sometimes the db keys. */
+        uint32_t size = ((bench_rand() % 4) == 0) ?
+                        (16 + bench_rand() % 256) : 12;
+        slot[index] = h_malloc(heap, size);
+        result->malloc_count ++;
+        if (slot[index] == EOS_NULL)
+        {
+            result->malloc_failed ++;
+        }
+    }
+    result->time_ms = eos_tick_get_ms() - time;
+
+    /* The largest block which can be applied with the remaining blocks. */
+    uint32_t low = 0, high = sizeof(heap_memory);
+    while (low < high)
+    {
+        uint32_t mid = (low + high + 1) / 2;
+        void *data = h_malloc(heap, mid);
+        if (data != EOS_NULL)
+        {
+            h_free(heap, data);
+            low = mid;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+    result->largest_free = low;
+}
+
+static void heap_walker(void *data, eos_u32_t size, bool used, void *parameter)
+{
+    (void)data;
+    (void)size;
+    (void)parameter;
+
+    if (used)
+    {
+        eos_test.walk_used_blocks ++;
+    }
+    else
+    {
+        eos_test.walk_free_blocks ++;
+    }
+}
+
+static void task_func_bench(void *parameter)
+{
+    (void)parameter;
+
+    heap_bench(&heap_ff, &eos_test.first_fit, ff_init, ff_malloc, ff_free);
+    heap_bench(&heap_tlsf, &eos_test.tlsf, tlsf_init, tlsf_malloc, tlsf_free);
+
+    eos_heap_stat(&heap_tlsf, &eos_test.tlsf_stat);
+    eos_heap_stat(eos_heap_get(EosHeap_Db), &eos_test.db_stat);
+    eos_heap_walk(&heap_tlsf, heap_walker, EOS_NULL);
+    if (eos_test.walk_free_blocks != eos_test.tlsf_stat.free_blocks)
+    {
+        eos_test.error ++;
+    }
+
+    /* The first levels follow the heap size, so the block is not capped. */
+    eos_heap_init(&heap_large, heap_large_memory, sizeof(heap_large_memory));
+    eos_test.large_block = HEAP_LARGE_SIZE - 6144;
+    void *data = eos_heap_malloc(&heap_large, eos_test.large_block);
+    if (data == EOS_NULL)
+    {
+        eos_test.error ++;
+    }
+    else
+    {
+        eos_heap_free(&heap_large, data);
+    }
+    eos_test.finished = 1;
+
+    while (1)
+    {
+        eos_task_delay_ms(1000);
+    }
+}
+
+#endif
@@ -0,0 +1,170 @@
+#include "test.h"
+#include <stdint.h>
+#include "eos.h"
+#include "bsp.h"
+
+#if (TEST_EN_11 != 0)
+
+/*
+ * The zero-copy stream test. TaskGive1 writes an increasing byte sequence in
+ * place with reserve/commit at full load, and TaskValue reads it in place with
+ * peek/consume every 1ms and checks the sequence. The ring buffer size is not
+ * a power of 2 and the writes are not aligned to it, so the contiguous part
+ * returned at the wrap is covered.
+ */
+
+/* private config ----------------------------------------------------------- */
+#define STREAM_TEST_SIZE                1000
+
+/* private data structure --------------------------------------------------- */
+typedef struct eos_test
+{
+    uint32_t error;
+    uint8_t isr_func_enable;
+
+    uint32_t time;
+    uint32_t commit_count;
+    uint32_t read_count;
+    uint32_t e_sm;
+    uint32_t e_reactor;
+
+    uint32_t isr_count;
+    uint32_t idle_count;
+} eos_test_t;
+
+typedef struct task_test
+{
+    eos_task_t *task;
+    const char *name;
+    uint8_t prio;
+    void *stack;
+    uint32_t stack_size;
+    void (* func)(void *parameter);
+} task_test_info_t;
+
+static void task_func_e_give1(void *parameter);
+static void task_func_e_value(void *parameter);
+
+/* private data ------------------------------------------------------------- */
+static uint64_t stack_e_give1[64];
+static eos_task_t task_e_give1;
+static uint64_t stack_e_value[64];
+static eos_task_t task_e_value;
+
+eos_test_t eos_test;
+
+static const task_test_info_t task_test_info[] =
+{
+    {
+        &task_e_give1, "TaskGive1", TaskPrio_Give1,
+        stack_e_give1, sizeof(stack_e_give1),
+        task_func_e_give1
+    },
+    {
+        &task_e_value, "TaskValue", TaskPrio_Value,
+        stack_e_value, sizeof(stack_e_value),
+        task_func_e_value
+    },
+};
+
+/* public function ---------------------------------------------------------- */
+void test_init(void)
+{
+    eos_db_register("Event_Stream", STREAM_TEST_SIZE, EOS_DB_ATTRIBUTE_STREAM);
+
+    for (uint32_t i = 0;
+         i < (sizeof(task_test_info) / sizeof(task_test_info_t));
+         i ++)
+    {
+        eos_task_init(task_test_info[i].task,
+                       task_test_info[i].name,
+                       task_test_info[i].func,
+                       EOS_NULL,
+                       task_test_info[i].stack,
+                       task_test_info[i].stack_size,
+                       task_test_info[i].prio);
+        eos_task_startup(task_test_info[i].task);
+    }
+
+    timer_init(1);
+}
+
+void eos_sm_count(void)
+{
+    eos_test.e_sm ++;
+}
+
+void eos_reactor_count(void)
+{
+    eos_test.e_reactor ++;
+}
+
+void timer_isr_1ms(void)
+{
+    eos_interrupt_enter();
+    eos_test.isr_count ++;
+    eos_interrupt_leave();
+}
+
+void eos_idle_count(void)
+{
+    eos_test.idle_count ++;
+}
+
+/* public function ---------------------------------------------------------- */
+static void task_func_e_give1(void *parameter)
+{
+    (void)parameter;
+    uint8_t seq_write = 0;
+
+    while (1)
+    {
+        eos_test.time = eos_tick_get_ms();
+
+        uint8_t *buffer;
+        uint32_t size = eos_db_stream_reserve("Event_Stream", (void **)&buffer);
+        if (size > 37)
+        {
+            size = 37;
+        }
+
+        for (uint32_t i = 0; i < size; i ++)
+        {
+            buffer[i] = seq_write ++;
+        }
+        eos_db_stream_commit("Event_Stream", size);
+
+        eos_test.commit_count += size;
+        if (size == 0)
+        {
+            eos_task_delay_ms(1);
+        }
+    }
+}
+
+static void task_func_e_value(void *parameter)
+{
+    (void)parameter;
+    uint8_t seq_read = 0;
+
+    while (1)
+    {
+        uint8_t *buffer;
+        uint32_t size = eos_db_stream_peek("Event_Stream", (void **)&buffer);
+        for (uint32_t i = 0; i < size; i ++)
+        {
+            if (buffer[i] != seq_read)
+            {
+                eos_test.error ++;
+                seq_read = buffer[i];
+            }
+            seq_read ++;
+        }
+        eos_db_stream_consume("Event_Stream", size);
+        eos_test.read_count += size;
+
+        eos_task_delay_ms(1);
+    }
+}
+
+#endif
@@ -0,0 +1,300 @@
+#include "test.h"
+#include <stdint.h>
+#include "eos.h"
+#include "bsp.h"
+
+#if (TEST_EN_12 != 0)
+
+/*
+ * The channel test. TaskGive1 sends an increasing byte sequence into a buffered
+ * channel on a stream key at full load, and TaskValue receives it without any
+ * polling and checks the sequence. The 1ms interrupt sends the value channel
+ * without waiting, and TaskHigh receives it with a timeout. The interrupt also
+ * publishes Event_Tick every 10ms, which TaskHigh gets after each receive
+ * without waiting, so none of the events given during the channel wait is
+ * lost. TaskMiddle sends a counter to TaskGive2 through a rendezvous channel
+ * every 2ms.
+ */
+
+/* private config ----------------------------------------------------------- */
+#define CHAN_TEST_STREAM_SIZE           100
+#define CHAN_TEST_CHUNK                 7
+#define CHAN_TEST_TICK                  10
+
+/* private data structure --------------------------------------------------- */
+typedef struct e_value
+{
+    uint32_t count;
+    uint32_t value;
+} e_value_t;
+
+typedef struct eos_test
+{
+    uint32_t error;
+    uint8_t isr_func_enable;
+
+    uint32_t time;
+    uint32_t send_count;
+    uint32_t recv_count;
+    uint32_t value_count;
+    uint32_t value_timeout;
+    uint32_t tick_count;
+    uint32_t rendezvous_count;
+    uint32_t rendezvous_timeout;
+    uint32_t e_sm;
+    uint32_t e_reactor;
+
+    uint32_t isr_count;
+    uint32_t idle_count;
+} eos_test_t;
+
+typedef struct task_test
+{
+    eos_task_t *task;
+    const char *name;
+    uint8_t prio;
+    void *stack;
+    uint32_t stack_size;
+    void (* func)(void *parameter);
+} task_test_info_t;
+
+static void task_func_e_give1(void *parameter);
+static void task_func_e_give2(void *parameter);
+static void task_func_e_value(void *parameter);
+static void task_func_high(void *parameter);
+static void task_func_middle(void *parameter);
+
+/* private data ------------------------------------------------------------- */
+static uint64_t stack_e_give1[64];
+static eos_task_t task_e_give1;
+static uint64_t stack_e_give2[64];
+static eos_task_t task_e_give2;
+static uint64_t stack_e_value[64];
+static eos_task_t task_e_value;
+static uint64_t stack_high[64];
+static eos_task_t task_high;
+static uint64_t stack_middle[64];
+static eos_task_t task_middle;
+
+static eos_chan_t chan_stream;
+static eos_chan_t chan_value;
+static eos_chan_t chan_rendezvous;
+
+eos_test_t eos_test;
+
+static const task_test_info_t task_test_info[] =
+{
+    {
+        &task_e_give1, "TaskGive1", TaskPrio_Give1,
+        stack_e_give1, sizeof(stack_e_give1),
+        task_func_e_give1
+    },
+    {
+        &task_e_give2, "TaskGive2", TaskPrio_Give2,
+        stack_e_give2, sizeof(stack_e_give2),
+        task_func_e_give2
+    },
+    {
+        &task_e_value, "TaskValue", TaskPrio_Value,
+        stack_e_value, sizeof(stack_e_value),
+        task_func_e_value
+    },
+    {
+        &task_high, "TaskHigh", TaskPrio_High,
+        stack_high, sizeof(stack_high),
+        task_func_high
+    },
+    {
+        &task_middle, "TaskMiddle", TaskPrio_Middle,
+        stack_middle, sizeof(stack_middle),
+        task_func_middle
+    },
+};
+
+/* public function ---------------------------------------------------------- */
+void test_init(void)
+{
+    eos_db_register("Event_Stream", CHAN_TEST_STREAM_SIZE,
+                    EOS_DB_ATTRIBUTE_STREAM);
+    eos_db_register("Event_Value", sizeof(e_value_t), EOS_DB_ATTRIBUTE_VALUE);
+
+    eos_chan_init(&chan_stream, "Event_Stream");
+    eos_chan_init(&chan_value, "Event_Value");
+    eos_chan_init(&chan_rendezvous, EOS_NULL);
+
+    for (uint32_t i = 0;
+         i < (sizeof(task_test_info) / sizeof(task_test_info_t));
+         i ++)
+    {
+        eos_task_init(task_test_info[i].task,
+                       task_test_info[i].name,
+                       task_test_info[i].func,
+                       EOS_NULL,
+                       task_test_info[i].stack,
+                       task_test_info[i].stack_size,
+                       task_test_info[i].prio);
+        eos_task_startup(task_test_info[i].task);
+    }
+
+    eos_test.isr_func_enable = 1;
+    timer_init(1);
+}
+
+void eos_sm_count(void)
+{
+    eos_test.e_sm ++;
+}
+
+void eos_reactor_count(void)
+{
+    eos_test.e_reactor ++;
+}
+
+void timer_isr_1ms(void)
+{
+    eos_interrupt_enter();
+
+    if (eos_test.isr_func_enable != 0)
+    {
+        e_value_t value;
+
+        eos_test.isr_count ++;
+        value.count = eos_test.isr_count;
+        value.value = eos_tick_get_ms();
+        eos_chan_send(&chan_value, &value, sizeof(e_value_t), EOS_WAIT_NO);
+        if ((eos_test.isr_count % CHAN_TEST_TICK) == 0)
+        {
+            eos_event_publish("Event_Tick");
+        }
+    }
+
+    eos_interrupt_leave();
+}
+
+void eos_idle_count(void)
+{
+    eos_test.idle_count ++;
+}
+
+/* public function ---------------------------------------------------------- */
+static void task_func_e_give1(void *parameter)
+{
+    (void)parameter;
+    uint8_t buffer[CHAN_TEST_CHUNK];
+    uint8_t seq_write = 0;
+
+    while (1)
+    {
+        eos_test.time = eos_tick_get_ms();
+
+        for (uint32_t i = 0; i < CHAN_TEST_CHUNK; i ++)
+        {
+            buffer[i] = seq_write ++;
+        }
+        if (eos_chan_send(&chan_stream, buffer, CHAN_TEST_CHUNK,
+                          EOS_WAIT_FOREVER) != EOS_EOK)
+        {
+            eos_test.error ++;
+        }
+        eos_test.send_count += CHAN_TEST_CHUNK;
+    }
+}
+
+static void task_func_e_give2(void *parameter)
+{
+    (void)parameter;
+    uint32_t count, count_last = 0;
+
+    while (1)
+    {
+        eos_s32_t ret = eos_chan_recv(&chan_rendezvous, &count, sizeof(count),
+                                      EOS_WAIT_FOREVER);
+        if (ret != sizeof(count) || count != (count_last + 1))
+        {
+            eos_test.error ++;
+        }
+        count_last = count;
+        eos_test.rendezvous_count ++;
+    }
+}
+
+static void task_func_e_value(void *parameter)
+{
+    (void)parameter;
+    uint8_t buffer[32];
+    uint8_t seq_read = 0;
+
+    while (1)
+    {
+        eos_s32_t size = eos_chan_recv(&chan_stream, buffer, sizeof(buffer),
+                                       EOS_WAIT_FOREVER);
+        if (size <= 0)
+        {
+            eos_test.error ++;
+            continue;
+        }
+
+        for (eos_s32_t i = 0; i < size; i ++)
+        {
+            if (buffer[i] != seq_read)
+            {
+                eos_test.error ++;
+                seq_read = buffer[i];
+            }
+            seq_read ++;
+        }
+        eos_test.recv_count += size;
+    }
+}
+
+static void task_func_high(void *parameter)
+{
+    (void)parameter;
+    e_value_t value;
+    eos_event_t e;
+
+    eos_event_sub("Event_Tick");
+
+    while (1)
+    {
+        if (eos_chan_recv(&chan_value, &value, sizeof(e_value_t), 10) ==
+            EOS_ETIMEOUT)
+        {
+            eos_test.value_timeout ++;
+            continue;
+        }
+        eos_test.value_count ++;
+
+        /* The events published during the wait are all in the mailbox. */
+        while (eos_task_wait_event(&e, EOS_WAIT_NO))
+        {
+            eos_test.tick_count ++;
+        }
+        if ((value.count / CHAN_TEST_TICK) != eos_test.tick_count)
+        {
+            eos_test.error ++;
+            eos_test.tick_count = value.count / CHAN_TEST_TICK;
+        }
+    }
+}
+
+static void task_func_middle(void *parameter)
+{
+    (void)parameter;
+    uint32_t count = 0;
+
+    while (1)
+    {
+        count ++;
+        if (eos_chan_send(&chan_rendezvous, &count, sizeof(count), 100) !=
+            EOS_EOK)
+        {
+            /* The receiver checks the next count strictly. */
+            count --;
+            eos_test.rendezvous_timeout ++;
+        }
+        eos_task_delay_ms(2);
+    }
+}
+
+#endif
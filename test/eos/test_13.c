@@ -0,0 +1,271 @@
+#include "test.h"
+#include <stdint.h>
+#include <string.h>
+#include "eos.h"
+#include "bsp.h"
+
+#if (TEST_EN_13 != 0)
+
+/*
+ * The change-only test of the linked value keys. TaskGive1 rewrites a telemetry
+ * value every 1ms, in which only the first word changes every 10 writes, and
+ * TaskValue is woken by its event and checks the changed words by the delta.
+ * TaskMiddle publishes a multi-buffer frame every 2ms, which changes every 4
+ * times, and TaskHigh pins it on its event. The events must never exceed the
+ * changes.
+ */
+
+/* private config ----------------------------------------------------------- */
+#define TELEMETRY_WORDS                 16
+#define FRAME_WORDS                     64
+
+/* private data structure --------------------------------------------------- */
+typedef struct eos_test
+{
+    uint32_t error;
+    uint8_t isr_func_enable;
+
+    uint32_t time;
+    uint32_t telemetry_write;
+    uint32_t telemetry_change;
+    uint32_t telemetry_event;
+    uint32_t frame_write;
+    uint32_t frame_change;
+    uint32_t frame_event;
+    uint32_t e_sm;
+    uint32_t e_reactor;
+
+    uint32_t isr_count;
+    uint32_t idle_count;
+} eos_test_t;
+
+typedef struct task_test
+{
+    eos_task_t *task;
+    const char *name;
+    uint8_t prio;
+    void *stack;
+    uint32_t stack_size;
+    void (* func)(void *parameter);
+} task_test_info_t;
+
+static void task_func_e_give1(void *parameter);
+static void task_func_e_value(void *parameter);
+static void task_func_high(void *parameter);
+static void task_func_middle(void *parameter);
+
+/* private data ------------------------------------------------------------- */
+static uint64_t stack_e_give1[64];
+static eos_task_t task_e_give1;
+static uint64_t stack_e_value[64];
+static eos_task_t task_e_value;
+static uint64_t stack_high[64];
+static eos_task_t task_high;
+static uint64_t stack_middle[64];
+static eos_task_t task_middle;
+
+eos_test_t eos_test;
+
+static const task_test_info_t task_test_info[] =
+{
+    {
+        &task_e_give1, "TaskGive1", TaskPrio_Give1,
+        stack_e_give1, sizeof(stack_e_give1),
+        task_func_e_give1
+    },
+    {
+        &task_e_value, "TaskValue", TaskPrio_Value,
+        stack_e_value, sizeof(stack_e_value),
+        task_func_e_value
+    },
+    {
+        &task_high, "TaskHigh", TaskPrio_High,
+        stack_high, sizeof(stack_high),
+        task_func_high
+    },
+    {
+        &task_middle, "TaskMiddle", TaskPrio_Middle,
+        stack_middle, sizeof(stack_middle),
+        task_func_middle
+    },
+};
+
+/* public function ---------------------------------------------------------- */
+void test_init(void)
+{
+    eos_db_register("Event_Telemetry", TELEMETRY_WORDS * 4,
+                    EOS_DB_ATTRIBUTE_VALUE |
+                    EOS_DB_ATTRIBUTE_LINK_EVENT |
+                    EOS_DB_ATTRIBUTE_CHANGE_ONLY);
+    eos_db_register("Event_Frame", FRAME_WORDS * 4,
+                    EOS_DB_ATTRIBUTE_VALUE |
+                    EOS_DB_ATTRIBUTE_LINK_EVENT |
+                    EOS_DB_ATTRIBUTE_CHANGE_ONLY |
+                    EOS_DB_ATTRIBUTE_MULTI_BUFFER);
+
+    for (uint32_t i = 0;
+         i < (sizeof(task_test_info) / sizeof(task_test_info_t));
+         i ++)
+    {
+        eos_task_init(task_test_info[i].task,
+                       task_test_info[i].name,
+                       task_test_info[i].func,
+                       EOS_NULL,
+                       task_test_info[i].stack,
+                       task_test_info[i].stack_size,
+                       task_test_info[i].prio);
+        eos_task_startup(task_test_info[i].task);
+    }
+
+    timer_init(1);
+}
+
+void eos_sm_count(void)
+{
+    eos_test.e_sm ++;
+}
+
+void eos_reactor_count(void)
+{
+    eos_test.e_reactor ++;
+}
+
+void timer_isr_1ms(void)
+{
+    eos_interrupt_enter();
+    eos_test.isr_count ++;
+    eos_interrupt_leave();
+}
+
+void eos_idle_count(void)
+{
+    eos_test.idle_count ++;
+}
+
+/* public function ---------------------------------------------------------- */
+static void task_func_e_give1(void *parameter)
+{
+    (void)parameter;
+    uint32_t telemetry[TELEMETRY_WORDS];
+
+    for (uint32_t i = 0; i < TELEMETRY_WORDS; i ++)
+    {
+        telemetry[i] = i;
+    }
+
+    while (1)
+    {
+        eos_test.time = eos_tick_get_ms();
+
+        /* Only the first word changes, every 10 writes. */
+        if ((eos_test.telemetry_write % 10) == 0)
+        {
+            telemetry[0] ++;
+            eos_test.telemetry_change ++;
+        }
+        eos_db_block_write("Event_Telemetry", telemetry);
+        eos_test.telemetry_write ++;
+
+        eos_task_delay_ms(1);
+    }
+}
+
+static void task_func_e_value(void *parameter)
+{
+    (void)parameter;
+    uint32_t telemetry[TELEMETRY_WORDS];
+    uint32_t mask[(TELEMETRY_WORDS + 31) / 32];
+    uint32_t version = 0;
+    eos_event_t e;
+
+    eos_event_sub("Event_Telemetry");
+
+    while (1)
+    {
+        if (!eos_task_wait_event(&e, 10000) ||
+            !eos_event_topic(&e, "Event_Telemetry"))
+        {
+            continue;
+        }
+        eos_test.telemetry_event ++;
+
+        /* All the words are changed in the first read. */
+        eos_db_block_read_delta("Event_Telemetry", telemetry, mask, &version);
+        uint32_t mask_expected = (eos_test.telemetry_event == 1) ?
+                                 ((1U << TELEMETRY_WORDS) - 1) : 1U;
+        if (mask[0] != mask_expected ||
+            eos_test.telemetry_event > eos_test.telemetry_change)
+        {
+            eos_test.error ++;
+        }
+    }
+}
+
+static void task_func_high(void *parameter)
+{
+    (void)parameter;
+    eos_event_t e;
+
+    eos_event_sub("Event_Frame");
+
+    while (1)
+    {
+        if (!eos_task_wait_event(&e, 10000) ||
+            !eos_event_topic(&e, "Event_Frame"))
+        {
+            continue;
+        }
+        eos_test.frame_event ++;
+
+        /* The frame is read in place, and all its words are the same. */
+        const uint32_t *frame = eos_db_value_pin("Event_Frame");
+        for (uint32_t i = 1; i < FRAME_WORDS; i ++)
+        {
+            if (frame[i] != frame[0])
+            {
+                eos_test.error ++;
+                break;
+            }
+        }
+        eos_db_value_unpin("Event_Frame", frame);
+
+        if (eos_test.frame_event > eos_test.frame_change)
+        {
+            eos_test.error ++;
+        }
+    }
+}
+
+static void task_func_middle(void *parameter)
+{
+    (void)parameter;
+    uint32_t count = 0;
+
+    while (1)
+    {
+        uint32_t *frame = eos_db_value_acquire("Event_Frame");
+        if (frame == EOS_NULL)
+        {
+            eos_test.error ++;
+            eos_task_delay_ms(2);
+            continue;
+        }
+
+        /* The frame changes every 4 writes. */
+        if ((eos_test.frame_write % 4) == 0)
+        {
+            count ++;
+            eos_test.frame_change ++;
+        }
+        for (uint32_t i = 0; i < FRAME_WORDS; i ++)
+        {
+            frame[i] = count;
+        }
+        eos_db_value_publish("Event_Frame", frame);
+        eos_test.frame_write ++;
+
+        eos_task_delay_ms(2);
+    }
+}
+
+#endif
@@ -0,0 +1,209 @@
+#include "test.h"
+#include <stdint.h>
+#include "eos.h"
+#include "bsp.h"
+
+#if (TEST_EN_14 != 0)
+
+/*
+ * The churn test of the object table. TaskGive1 delays the time events of all
+ * the topics every 1ms and cancels them before they come, so the timer objects
+ * are created and deleted far more times than the table size. TaskHigh keeps
+ * the periodic time event, and TaskValue keeps reading the value key, whose
+ * lookups must never fail during the churn. The statistics of the object table
+ * are kept, in which no cancelled timer may be left.
+ */
+
+/* private config ----------------------------------------------------------- */
+#define TIME_TOPICS                     6
+
+/* private data structure --------------------------------------------------- */
+typedef struct e_value
+{
+    uint32_t count;
+    uint32_t value;
+} e_value_t;
+
+typedef struct eos_test
+{
+    uint32_t error;
+    uint8_t isr_func_enable;
+
+    uint32_t time;
+    uint32_t churn_count;
+    uint32_t value_count;
+    uint32_t period_count;
+    eos_hash_stat_t hash_stat;
+    uint32_t e_sm;
+    uint32_t e_reactor;
+
+    uint32_t isr_count;
+    uint32_t idle_count;
+} eos_test_t;
+
+typedef struct task_test
+{
+    eos_task_t *task;
+    const char *name;
+    uint8_t prio;
+    void *stack;
+    uint32_t stack_size;
+    void (* func)(void *parameter);
+} task_test_info_t;
+
+static void task_func_e_give1(void *parameter);
+static void task_func_e_value(void *parameter);
+static void task_func_high(void *parameter);
+
+/* private data ------------------------------------------------------------- */
+static uint64_t stack_e_give1[64];
+static eos_task_t task_e_give1;
+static uint64_t stack_e_value[64];
+static eos_task_t task_e_value;
+static uint64_t stack_high[64];
+static eos_task_t task_high;
+
+eos_test_t eos_test;
+
+static const char *time_topic[TIME_TOPICS] =
+{
+    "Event_Time_0", "Event_Time_1", "Event_Time_2",
+    "Event_Time_3", "Event_Time_4", "Event_Time_5",
+};
+
+static const task_test_info_t task_test_info[] =
+{
+    {
+        &task_e_give1, "TaskGive1", TaskPrio_Give1,
+        stack_e_give1, sizeof(stack_e_give1),
+        task_func_e_give1
+    },
+    {
+        &task_e_value, "TaskValue", TaskPrio_Value,
+        stack_e_value, sizeof(stack_e_value),
+        task_func_e_value
+    },
+    {
+        &task_high, "TaskHigh", TaskPrio_High,
+        stack_high, sizeof(stack_high),
+        task_func_high
+    },
+};
+
+/* public function ---------------------------------------------------------- */
+void test_init(void)
+{
+    eos_db_register("Event_Value", sizeof(e_value_t), EOS_DB_ATTRIBUTE_VALUE);
+
+    for (uint32_t i = 0;
+         i < (sizeof(task_test_info) / sizeof(task_test_info_t));
+         i ++)
+    {
+        eos_task_init(task_test_info[i].task,
+                       task_test_info[i].name,
+                       task_test_info[i].func,
+                       EOS_NULL,
+                       task_test_info[i].stack,
+                       task_test_info[i].stack_size,
+                       task_test_info[i].prio);
+        eos_task_startup(task_test_info[i].task);
+    }
+
+    timer_init(1);
+}
+
+void eos_sm_count(void)
+{
+    eos_test.e_sm ++;
+}
+
+void eos_reactor_count(void)
+{
+    eos_test.e_reactor ++;
+}
+
+void timer_isr_1ms(void)
+{
+    eos_interrupt_enter();
+    eos_test.isr_count ++;
+    eos_interrupt_leave();
+}
+
+void eos_idle_count(void)
+{
+    eos_test.idle_count ++;
+}
+
+/* public function ---------------------------------------------------------- */
+static void task_func_e_give1(void *parameter)
+{
+    (void)parameter;
+
+    while (1)
+    {
+        eos_test.time = eos_tick_get_ms();
+
+        for (uint32_t i = 0; i < TIME_TOPICS; i ++)
+        {
+            eos_event_publish_delay(time_topic[i], 100 + i);
+        }
+        for (uint32_t i = 0; i < TIME_TOPICS; i ++)
+        {
+            eos_event_time_cancel(time_topic[i]);
+        }
+        eos_test.churn_count ++;
+
+        /* Only the periodic timer is left. */
+        eos_hash_stat(&eos_test.hash_stat);
+        if (eos_test.hash_stat.timer > 1)
+        {
+            eos_test.error ++;
+        }
+
+        eos_task_delay_ms(1);
+    }
+}
+
+static void task_func_e_value(void *parameter)
+{
+    (void)parameter;
+    e_value_t value = { 0, 0 };
+    e_value_t value_read = { 0, 0 };
+
+    while (1)
+    {
+        value.count ++;
+        value.value = ~value.count;
+        eos_db_block_write("Event_Value", &value);
+        eos_db_block_read("Event_Value", &value_read);
+        if (value_read.count != value.count || value_read.value != value.value)
+        {
+            eos_test.error ++;
+        }
+        eos_test.value_count ++;
+
+        eos_task_delay_ms(1);
+    }
+}
+
+static void task_func_high(void *parameter)
+{
+    (void)parameter;
+    eos_event_t e;
+
+    eos_event_sub("Event_Period");
+    eos_event_publish_period("Event_Period", 10);
+
+    while (1)
+    {
+        if (!eos_task_wait_event(&e, 10000) ||
+            !eos_event_topic(&e, "Event_Period"))
+        {
+            eos_test.error ++;
+            continue;
+        }
+        eos_test.period_count ++;
+    }
+}
+
+#endif
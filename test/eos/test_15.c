@@ -0,0 +1,208 @@
+#include "test.h"
+#include <stdint.h>
+#include "eos.h"
+#include "bsp.h"
+
+#if (TEST_EN_15 != 0)
+
+/*
+ * The publish benchmark. TaskGive1 publishes BENCH_TIMES events of a topic
+ * subscribed only by TaskValue, and then of a topic subscribed by all the
+ * parked tasks too, and the time of each is recorded in eos_test. The time of
+ * the first one should not grow with BENCH_PARKED_TASKS, since the publish
+ * only visits the subscribers.
+ */
+
+/* private config ----------------------------------------------------------- */
+#define BENCH_PARKED_TASKS              16
+#define BENCH_TIMES                     10000
+
+/* private data structure --------------------------------------------------- */
+typedef struct eos_test
+{
+    uint32_t error;
+    uint8_t isr_func_enable;
+    uint32_t finished;
+
+    uint32_t time_one_ms;
+    uint32_t time_all_ms;
+    uint32_t value_count;
+    uint32_t parked_count;
+    uint32_t e_sm;
+    uint32_t e_reactor;
+
+    uint32_t isr_count;
+    uint32_t idle_count;
+} eos_test_t;
+
+typedef struct task_test
+{
+    eos_task_t *task;
+    const char *name;
+    uint8_t prio;
+    void *stack;
+    uint32_t stack_size;
+    void (* func)(void *parameter);
+} task_test_info_t;
+
+static void task_func_e_give1(void *parameter);
+static void task_func_e_value(void *parameter);
+static void task_func_parked(void *parameter);
+
+/* private data ------------------------------------------------------------- */
+static uint64_t stack_e_give1[64];
+static eos_task_t task_e_give1;
+static uint64_t stack_e_value[64];
+static eos_task_t task_e_value;
+static uint64_t stack_parked[BENCH_PARKED_TASKS][64];
+static eos_task_t task_parked[BENCH_PARKED_TASKS];
+
+eos_test_t eos_test;
+
+static const char *parked_name[BENCH_PARKED_TASKS] =
+{
+    "TaskParked0", "TaskParked1", "TaskParked2", "TaskParked3",
+    "TaskParked4", "TaskParked5", "TaskParked6", "TaskParked7",
+    "TaskParked8", "TaskParked9", "TaskParked10", "TaskParked11",
+    "TaskParked12", "TaskParked13", "TaskParked14", "TaskParked15",
+};
+
+static const task_test_info_t task_test_info[] =
+{
+    {
+        &task_e_give1, "TaskGive1", TaskPrio_Give1,
+        stack_e_give1, sizeof(stack_e_give1),
+        task_func_e_give1
+    },
+    {
+        &task_e_value, "TaskValue", TaskPrio_Value,
+        stack_e_value, sizeof(stack_e_value),
+        task_func_e_value
+    },
+};
+
+/* public function ---------------------------------------------------------- */
+void test_init(void)
+{
+    for (uint32_t i = 0;
+         i < (sizeof(task_test_info) / sizeof(task_test_info_t));
+         i ++)
+    {
+        eos_task_init(task_test_info[i].task,
+                       task_test_info[i].name,
+                       task_test_info[i].func,
+                       EOS_NULL,
+                       task_test_info[i].stack,
+                       task_test_info[i].stack_size,
+                       task_test_info[i].prio);
+        eos_task_startup(task_test_info[i].task);
+    }
+
+    for (uint32_t i = 0; i < BENCH_PARKED_TASKS; i ++)
+    {
+        eos_task_init(&task_parked[i],
+                       parked_name[i],
+                       task_func_parked,
+                       EOS_NULL,
+                       stack_parked[i],
+                       sizeof(stack_parked[i]),
+                       TaskPrio_Middle);
+        eos_task_startup(&task_parked[i]);
+    }
+
+    timer_init(1);
+}
+
+void eos_sm_count(void)
+{
+    eos_test.e_sm ++;
+}
+
+void eos_reactor_count(void)
+{
+    eos_test.e_reactor ++;
+}
+
+void timer_isr_1ms(void)
+{
+    eos_interrupt_enter();
+    eos_test.isr_count ++;
+    eos_interrupt_leave();
+}
+
+void eos_idle_count(void)
+{
+    eos_test.idle_count ++;
+}
+
+/* public function ---------------------------------------------------------- */
+static uint32_t bench_publish(const char *topic)
+{
+    eos_topic_handle_t handle = eos_topic_handle(topic);
+    uint32_t time = eos_tick_get_ms();
+
+    for (uint32_t i = 0; i < BENCH_TIMES; i ++)
+    {
+        eos_event_publish_h(handle);
+    }
+
+    return eos_tick_get_ms() - time;
+}
+
+static void task_func_e_give1(void *parameter)
+{
+    (void)parameter;
+
+    /* Wait for all the subscribers. */
+    eos_task_delay_ms(10);
+
+    eos_test.time_one_ms = bench_publish("Event_One");
+    eos_test.time_all_ms = bench_publish("Event_All");
+    eos_test.finished = 1;
+
+    if (eos_test.value_count != (BENCH_TIMES * 2) ||
+        eos_test.parked_count != (BENCH_TIMES * BENCH_PARKED_TASKS))
+    {
+        eos_test.error ++;
+    }
+
+    while (1)
+    {
+        eos_task_delay_ms(1000);
+    }
+}
+
+static void task_func_e_value(void *parameter)
+{
+    (void)parameter;
+    eos_event_t e;
+
+    eos_event_sub("Event_One");
+    eos_event_sub("Event_All");
+
+    while (1)
+    {
+        if (eos_task_wait_event(&e, 10000))
+        {
+            eos_test.value_count ++;
+        }
+    }
+}
+
+static void task_func_parked(void *parameter)
+{
+    (void)parameter;
+    eos_event_t e;
+
+    eos_event_sub("Event_All");
+
+    while (1)
+    {
+        if (eos_task_wait_event(&e, 10000))
+        {
+            eos_test.parked_count ++;
+        }
+    }
+}
+
+#endif
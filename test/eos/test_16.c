@@ -0,0 +1,233 @@
+#include "test.h"
+#include <stdint.h>
+#include "eos.h"
+#include "bsp.h"
+
+#if (TEST_EN_16 != 0)
+
+/*
+ * The timer benchmark. BENCH_TIMERS periodic timers of pseudo-random periods
+ * are running, and TaskGive1 restarts a timer of a pseudo-random timeout
+ * BENCH_TIMES times, and then starts and stops it BENCH_TIMES times, and the
+ * time of each is recorded in eos_test. It is built with and without
+ * EOS_USING_TIMER_WHEEL to compare the timing wheel with the skip list.
+ *
+ * TaskHigh checks the order of the timers of the same timeout tick. The timers
+ * are started one by one with the timeout getting shorter, and they should be
+ * called in the order of starting, not before the timeout tick.
+ */
+
+/* private config ----------------------------------------------------------- */
+#define BENCH_TIMERS                    256
+#define BENCH_TIMES                     10000
+#define BENCH_TIMEOUT_MIN               1000
+#define BENCH_TIMEOUT_RANGE             60000
+
+#define ORDER_TIMERS                    8
+#define ORDER_TIMEOUT                   300
+#define ORDER_INTERVAL                  37
+
+/* private data structure --------------------------------------------------- */
+typedef struct eos_test
+{
+    uint32_t error;
+    uint8_t isr_func_enable;
+    uint32_t finished;
+
+    uint32_t time_start_ms;
+    uint32_t time_start_stop_ms;
+    uint32_t bench_count;
+    uint32_t order_count;
+    uint32_t e_sm;
+    uint32_t e_reactor;
+
+    uint32_t isr_count;
+    uint32_t idle_count;
+} eos_test_t;
+
+typedef struct task_test
+{
+    eos_task_t *task;
+    const char *name;
+    uint8_t prio;
+    void *stack;
+    uint32_t stack_size;
+    void (* func)(void *parameter);
+} task_test_info_t;
+
+static void task_func_e_give1(void *parameter);
+static void task_func_high(void *parameter);
+static void timer_bench_func(void *parameter);
+static void timer_order_func(void *parameter);
+
+/* private data ------------------------------------------------------------- */
+static uint64_t stack_e_give1[64];
+static eos_task_t task_e_give1;
+static uint64_t stack_high[64];
+static eos_task_t task_high;
+
+static eos_timer_t timer_bench[BENCH_TIMERS];
+static eos_timer_t timer_test;
+static eos_timer_t timer_order[ORDER_TIMERS];
+static uint32_t order_tick;
+static uint32_t order_index;
+static uint32_t random_seed = 1;
+
+eos_test_t eos_test;
+
+static const task_test_info_t task_test_info[] =
+{
+    {
+        &task_e_give1, "TaskGive1", TaskPrio_Give1,
+        stack_e_give1, sizeof(stack_e_give1),
+        task_func_e_give1
+    },
+    {
+        &task_high, "TaskHigh", TaskPrio_High,
+        stack_high, sizeof(stack_high),
+        task_func_high
+    },
+};
+
+/* public function ---------------------------------------------------------- */
+static uint32_t bench_random(void)
+{
+    random_seed = random_seed * 1103515245 + 12345;
+
+    return (random_seed >> 8);
+}
+
+void test_init(void)
+{
+    for (uint32_t i = 0;
+         i < (sizeof(task_test_info) / sizeof(task_test_info_t));
+         i ++)
+    {
+        eos_task_init(task_test_info[i].task,
+                       task_test_info[i].name,
+                       task_test_info[i].func,
+                       EOS_NULL,
+                       task_test_info[i].stack,
+                       task_test_info[i].stack_size,
+                       task_test_info[i].prio);
+        eos_task_startup(task_test_info[i].task);
+    }
+
+    for (uint32_t i = 0; i < BENCH_TIMERS; i ++)
+    {
+        eos_timer_init(&timer_bench[i], timer_bench_func, EOS_NULL,
+                       BENCH_TIMEOUT_MIN + bench_random() % BENCH_TIMEOUT_RANGE,
+                       EOS_TIMER_FLAG_PERIODIC | EOS_TIMER_FLAG_HARD_TIMER);
+        eos_timer_start(&timer_bench[i]);
+    }
+
+    eos_timer_init(&timer_test, timer_bench_func, EOS_NULL,
+                   BENCH_TIMEOUT_MIN, EOS_TIMER_FLAG_ONE_SHOT | EOS_TIMER_FLAG_HARD_TIMER);
+
+    for (uint32_t i = 0; i < ORDER_TIMERS; i ++)
+    {
+        eos_timer_init(&timer_order[i], timer_order_func, (void *)(uintptr_t)i,
+                       ORDER_TIMEOUT, EOS_TIMER_FLAG_ONE_SHOT | EOS_TIMER_FLAG_HARD_TIMER);
+    }
+
+    timer_init(1);
+}
+
+void eos_sm_count(void)
+{
+    eos_test.e_sm ++;
+}
+
+void eos_reactor_count(void)
+{
+    eos_test.e_reactor ++;
+}
+
+void timer_isr_1ms(void)
+{
+    eos_interrupt_enter();
+    eos_test.isr_count ++;
+    eos_interrupt_leave();
+}
+
+void eos_idle_count(void)
+{
+    eos_test.idle_count ++;
+}
+
+/* public function ---------------------------------------------------------- */
+static void timer_bench_func(void *parameter)
+{
+    (void)parameter;
+
+    eos_test.bench_count ++;
+}
+
+static void timer_order_func(void *parameter)
+{
+    /* Not called before the timeout tick. */
+    if ((uint32_t)(uintptr_t)parameter != order_index ||
+        (int32_t)(eos_tick_get() - order_tick) < 0)
+    {
+        eos_test.error ++;
+    }
+    order_index ++;
+}
+
+static uint32_t bench_start(uint32_t stop)
+{
+    uint32_t time = eos_tick_get_ms();
+
+    for (uint32_t i = 0; i < BENCH_TIMES; i ++)
+    {
+        eos_timer_set_time(&timer_test,
+                           BENCH_TIMEOUT_MIN + bench_random() % BENCH_TIMEOUT_RANGE);
+        eos_timer_start(&timer_test);
+        if (stop != 0)
+        {
+            eos_timer_stop(&timer_test);
+        }
+    }
+
+    return eos_tick_get_ms() - time;
+}
+
+static void task_func_e_give1(void *parameter)
+{
+    (void)parameter;
+
+    eos_test.time_start_ms = bench_start(0);
+    eos_test.time_start_stop_ms = bench_start(1);
+    eos_test.finished = 1;
+
+    while (1)
+    {
+        eos_task_delay_ms(1000);
+    }
+}
+
+static void task_func_high(void *parameter)
+{
+    (void)parameter;
+
+    while (1)
+    {
+        order_index = 0;
+        order_tick = eos_tick_get() + ORDER_TIMEOUT;
+        for (uint32_t i = 0; i < ORDER_TIMERS; i ++)
+        {
+            eos_timer_set_time(&timer_order[i], order_tick - eos_tick_get());
+            eos_timer_start(&timer_order[i]);
+            eos_task_delay(ORDER_INTERVAL);
+        }
+
+        eos_task_delay(ORDER_TIMEOUT);
+        if (order_index != ORDER_TIMERS)
+        {
+            eos_test.error ++;
+        }
+        eos_test.order_count ++;
+    }
+}
+
+#endif
@@ -0,0 +1,189 @@
+#include "test.h"
+#include <stdint.h>
+#include "eos.h"
+#include "bsp.h"
+
+#if (TEST_EN_17 != 0)
+
+/*
+ * The timer slack test. TaskHigh publishes the periodic time events of
+ * SLACK_TOPICS topics, started SLACK_PHASE ms one after another, and gives
+ * each of them the slack of SLACK_MS. TaskValue receives them, and counts the
+ * events and the ticks it is woken at. With EOS_USING_TIMER_SLACK, the time
+ * events of the overlapping windows come in the same tick, and the wakeups are
+ * far fewer than the events. The time event may come late or early by the
+ * slack, but the n-th one may never come before n periods.
+ */
+
+/* private config ----------------------------------------------------------- */
+#define SLACK_TOPICS                    4
+#define SLACK_PERIOD                    100
+#define SLACK_PHASE                     13
+#define SLACK_MS                        50
+
+/* private data structure --------------------------------------------------- */
+typedef struct eos_test
+{
+    uint32_t error;
+    uint8_t isr_func_enable;
+
+    uint32_t event_count;
+    uint32_t wake_count;
+    uint32_t e_sm;
+    uint32_t e_reactor;
+
+    uint32_t isr_count;
+    uint32_t idle_count;
+} eos_test_t;
+
+typedef struct task_test
+{
+    eos_task_t *task;
+    const char *name;
+    uint8_t prio;
+    void *stack;
+    uint32_t stack_size;
+    void (* func)(void *parameter);
+} task_test_info_t;
+
+static void task_func_e_value(void *parameter);
+static void task_func_high(void *parameter);
+
+/* private data ------------------------------------------------------------- */
+static uint64_t stack_e_value[64];
+static eos_task_t task_e_value;
+static uint64_t stack_high[64];
+static eos_task_t task_high;
+
+eos_test_t eos_test;
+
+static uint32_t tick_start[SLACK_TOPICS];
+
+static const char *slack_topic[SLACK_TOPICS] =
+{
+    "Event_Slack_0", "Event_Slack_1", "Event_Slack_2", "Event_Slack_3",
+};
+
+static const task_test_info_t task_test_info[] =
+{
+    {
+        &task_e_value, "TaskValue", TaskPrio_Value,
+        stack_e_value, sizeof(stack_e_value),
+        task_func_e_value
+    },
+    {
+        &task_high, "TaskHigh", TaskPrio_High,
+        stack_high, sizeof(stack_high),
+        task_func_high
+    },
+};
+
+/* public function ---------------------------------------------------------- */
+void test_init(void)
+{
+    for (uint32_t i = 0;
+         i < (sizeof(task_test_info) / sizeof(task_test_info_t));
+         i ++)
+    {
+        eos_task_init(task_test_info[i].task,
+                       task_test_info[i].name,
+                       task_test_info[i].func,
+                       EOS_NULL,
+                       task_test_info[i].stack,
+                       task_test_info[i].stack_size,
+                       task_test_info[i].prio);
+        eos_task_startup(task_test_info[i].task);
+    }
+
+    timer_init(1);
+}
+
+void eos_sm_count(void)
+{
+    eos_test.e_sm ++;
+}
+
+void eos_reactor_count(void)
+{
+    eos_test.e_reactor ++;
+}
+
+void timer_isr_1ms(void)
+{
+    eos_interrupt_enter();
+    eos_test.isr_count ++;
+    eos_interrupt_leave();
+}
+
+void eos_idle_count(void)
+{
+    eos_test.idle_count ++;
+}
+
+/* public function ---------------------------------------------------------- */
+static void task_func_e_value(void *parameter)
+{
+    (void)parameter;
+    eos_event_t e;
+    uint32_t tick_wake = 0;
+    uint32_t count[SLACK_TOPICS] = { 0 };
+
+    for (uint32_t i = 0; i < SLACK_TOPICS; i ++)
+    {
+        eos_event_sub(slack_topic[i]);
+    }
+
+    while (1)
+    {
+        if (!eos_task_wait_event(&e, 10000))
+        {
+            eos_test.error ++;
+            continue;
+        }
+
+        uint32_t tick = eos_tick_get();
+        if (tick != tick_wake)
+        {
+            tick_wake = tick;
+            eos_test.wake_count ++;
+        }
+        eos_test.event_count ++;
+
+        for (uint32_t i = 0; i < SLACK_TOPICS; i ++)
+        {
+            if (eos_event_topic(&e, slack_topic[i]))
+            {
+                count[i] ++;
+                if ((tick - tick_start[i]) < (count[i] * SLACK_PERIOD))
+                {
+                    eos_test.error ++;
+                }
+            }
+        }
+    }
+}
+
+static void task_func_high(void *parameter)
+{
+    (void)parameter;
+
+    /* Wait for the subscriber. */
+    eos_task_delay_ms(10);
+
+    for (uint32_t i = 0; i < SLACK_TOPICS; i ++)
+    {
+        tick_start[i] = eos_tick_get();
+        eos_event_publish_period(slack_topic[i], SLACK_PERIOD);
+#ifdef EOS_USING_TIMER_SLACK
+        eos_event_time_slack(slack_topic[i], SLACK_MS);
+#endif
+        eos_task_delay_ms(SLACK_PHASE);
+    }
+
+    while (1)
+    {
+        eos_task_delay_ms(1000);
+    }
+}
+
+#endif
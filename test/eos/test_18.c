@@ -0,0 +1,196 @@
+#include "test.h"
+#include <stdint.h>
+#include "eos.h"
+#include "bsp.h"
+
+#if (TEST_EN_18 != 0)
+
+/*
+ * The perfect hash test, built by "./x_build.sh phash" with the topic table of
+ * eos_phash.txt. The tasks, the topics and the timer of the test are static
+ * keys, so every lookup of them is exactly one probe. TaskHigh creates the
+ * static timer of Event_Static by eos_event_publish_delay(), deletes it, and
+ * creates it again, and then looks up the static task and value keys. Between
+ * the statistics of eos_hash_stat() before and after, the probes must equal the
+ * lookups, the timer must be counted in and out, and the longest probe of the
+ * dynamic slots must not change. TaskValue receives one Event_Static for each
+ * round.
+ */
+
+/* private config ----------------------------------------------------------- */
+#define STATIC_DELAY                    10
+
+/* private data structure --------------------------------------------------- */
+typedef struct eos_test
+{
+    uint32_t error;
+    uint8_t isr_func_enable;
+
+    uint32_t round_count;
+    uint32_t event_count;
+    uint32_t lookup_count;
+    uint32_t e_sm;
+    uint32_t e_reactor;
+
+    uint32_t isr_count;
+    uint32_t idle_count;
+} eos_test_t;
+
+typedef struct task_test
+{
+    eos_task_t *task;
+    const char *name;
+    uint8_t prio;
+    void *stack;
+    uint32_t stack_size;
+    void (* func)(void *parameter);
+} task_test_info_t;
+
+static void task_func_e_value(void *parameter);
+static void task_func_high(void *parameter);
+
+/* private data ------------------------------------------------------------- */
+static uint64_t stack_e_value[64];
+static eos_task_t task_e_value;
+static uint64_t stack_high[64];
+static eos_task_t task_high;
+
+eos_test_t eos_test;
+
+static const task_test_info_t task_test_info[] =
+{
+    {
+        &task_e_value, "TaskValue", TaskPrio_Value,
+        stack_e_value, sizeof(stack_e_value),
+        task_func_e_value
+    },
+    {
+        &task_high, "TaskHigh", TaskPrio_High,
+        stack_high, sizeof(stack_high),
+        task_func_high
+    },
+};
+
+/* public function ---------------------------------------------------------- */
+void test_init(void)
+{
+    for (uint32_t i = 0;
+         i < (sizeof(task_test_info) / sizeof(task_test_info_t));
+         i ++)
+    {
+        eos_task_init(task_test_info[i].task,
+                       task_test_info[i].name,
+                       task_test_info[i].func,
+                       EOS_NULL,
+                       task_test_info[i].stack,
+                       task_test_info[i].stack_size,
+                       task_test_info[i].prio);
+        eos_task_startup(task_test_info[i].task);
+    }
+
+    timer_init(1);
+}
+
+void eos_sm_count(void)
+{
+    eos_test.e_sm ++;
+}
+
+void eos_reactor_count(void)
+{
+    eos_test.e_reactor ++;
+}
+
+void timer_isr_1ms(void)
+{
+    eos_interrupt_enter();
+    eos_test.isr_count ++;
+    eos_interrupt_leave();
+}
+
+void eos_idle_count(void)
+{
+    eos_test.idle_count ++;
+}
+
+/* public function ---------------------------------------------------------- */
+static void task_func_e_value(void *parameter)
+{
+    (void)parameter;
+    eos_event_t e;
+
+    eos_event_sub("Event_Static");
+
+    while (1)
+    {
+        if (!eos_task_wait_event(&e, 10000))
+        {
+            eos_test.error ++;
+            continue;
+        }
+
+        if (eos_event_topic(&e, "Event_Static"))
+        {
+            eos_test.event_count ++;
+        }
+    }
+}
+
+static void task_func_high(void *parameter)
+{
+    (void)parameter;
+    eos_hash_stat_t stat[4];
+    uint8_t value[8] = { 0 };
+
+    /* Wait for the subscriber. */
+    eos_task_delay_ms(10);
+
+    while (1)
+    {
+        /* The static timer is created, deleted and created again. */
+        eos_hash_stat(&stat[0]);
+        eos_event_publish_delay("Event_Static", STATIC_DELAY);
+        eos_hash_stat(&stat[1]);
+        eos_event_time_cancel("Event_Static");
+        eos_hash_stat(&stat[2]);
+        eos_event_publish_delay("Event_Static", STATIC_DELAY);
+
+        /* The static task and value keys. */
+        if (eos_get_task_id("TaskValue") != eos_get_task_id("TaskValue"))
+        {
+            eos_test.error ++;
+        }
+        value[0] ++;
+        eos_db_block_write("Event_Value", value);
+        eos_db_block_read("Event_Value", value);
+        eos_hash_stat(&stat[3]);
+
+        if (stat[1].timer != (stat[0].timer + 1) ||
+            stat[1].used != (stat[0].used + 1) ||
+            stat[2].timer != stat[0].timer ||
+            stat[2].used != stat[0].used ||
+            stat[3].timer != (stat[0].timer + 1))
+        {
+            eos_test.error ++;
+        }
+        /* Every lookup of the static keys is one probe. */
+        if ((stat[3].probe - stat[0].probe) != (stat[3].lookup - stat[0].lookup) ||
+            stat[3].lookup == stat[0].lookup ||
+            stat[3].probe_max != stat[0].probe_max)
+        {
+            eos_test.error ++;
+        }
+        eos_test.lookup_count += (stat[3].lookup - stat[0].lookup);
+        eos_test.round_count ++;
+
+        /* The one-shot timer is left after the timeout, and deleted here. */
+        eos_task_delay_ms(STATIC_DELAY * 2);
+        eos_event_time_cancel("Event_Static");
+        if (eos_test.event_count != eos_test.round_count)
+        {
+            eos_test.error ++;
+        }
+    }
+}
+
+#endif
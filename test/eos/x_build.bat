@@ -17,7 +17,17 @@ test_05_0.c ^
 test_05_1.c ^
 test_06.c ^
 test_07.c ^
+test_08.c ^
 test_09.c ^
+test_10.c ^
+test_11.c ^
+test_12.c ^
+test_13.c ^
+test_14.c ^
+test_15.c ^
+test_16.c ^
+test_17.c ^
+test_18.c ^
 ..\eventos\eos.c ^
 ..\eventos\eos_kernel.c ^
 ..\libcpu\win32\cpu_port.c ^
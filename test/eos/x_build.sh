@@ -0,0 +1,63 @@
+#!/bin/sh
+
+mkdir -p build
+
+# The idle is tickless. The options may be given together:
+#   virtual     runs the tests in the virtual time of libcpu/posix.
+#   topic       builds with the topic table generated from eos_topic.txt.
+#   phash       builds test 18 with the perfect hash of eos_phash.txt.
+FLAGS="-DEOS_USING_TICKLESS"
+for option in "$@"; do
+    case "$option" in
+    virtual)
+        FLAGS="$FLAGS -DEOS_POSIX_VIRTUAL_TIME=1"
+        ;;
+    topic)
+        python3 ../../tools/eos_topic.py eos_topic.txt -o build/eos_topic.h \
+            -c ../../eventos/eos_config.h || exit 1
+        FLAGS="$FLAGS -DEOS_USE_TOPIC_TABLE=1 -I build"
+        ;;
+    phash)
+        python3 ../../tools/eos_phash.py eos_phash.txt -o build/eos_topic.h \
+            -c ../../eventos/eos_config.h || exit 1
+        FLAGS="$FLAGS -DEOS_USE_TOPIC_TABLE=1 -DTEST_MODE=1 -I build"
+        ;;
+    esac
+done
+
+gcc -std=gnu99 -g $FLAGS \
+main_posix.c \
+bsp_posix.c \
+hook.c \
+eos_led_sm.c \
+test.c \
+test_01_0.c \
+test_01_1.c \
+test_02_0.c \
+test_02_1.c \
+test_02_2.c \
+test_03.c \
+test_04.c \
+test_05_0.c \
+test_05_1.c \
+test_06.c \
+test_07.c \
+test_08.c \
+test_09.c \
+test_10.c \
+test_11.c \
+test_12.c \
+test_13.c \
+test_14.c \
+test_15.c \
+test_16.c \
+test_17.c \
+test_18.c \
+../../eventos/eos.c \
+../../eventos/eos_kernel.c \
+../../libcpu/posix/cpu_port.c \
+-I ../../eventos \
+-I . \
+-I ../../libcpu/posix \
+-o build/e \
+-lpthread
@@ -0,0 +1,499 @@
+/*
+ * The stress test of the lock-free db access on the host.
+ *
+ * One thread writes an increasing byte sequence into the stream keys in chunks
+ * of random sizes, and the other thread reads it out in chunks of random sizes
+ * and checks the sequence. The first key is accessed with the copy API through
+ * the topic handle, and must never disable the interrupt. The second key is
+ * accessed with reserve/commit and peek/consume in place. The sizes of the two
+ * keys are not a power of 2 and a power of 2 respectively.
+ *
+ * At last, one thread writes a value key filled with an increasing count, and
+ * the other thread reads it through the topic handle, and must never get a
+ * value half written or older than the last one. The read disables the
+ * interrupt only when the writer interleaves EOS_DB_READ_RETRY copies in a row,
+ * which must be rare.
+ * The same is done on a multi-buffer value key in place, with acquire/publish
+ * and pin/unpin, where the writer must always get a back buffer.
+ *
+ * The snapshot reads three value keys, one of which is multi-buffer, written
+ * in order with the same count. A coherent set never has a later key newer
+ * than an earlier one.
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "eos.h"
+
+/* private config ----------------------------------------------------------- */
+#ifndef STREAM_TEST_BYTES
+#define STREAM_TEST_BYTES               (64U * 1024U * 1024U)
+#endif
+#define STREAM_TEST_CHUNK               97
+#ifndef VALUE_TEST_TIMES
+#define VALUE_TEST_TIMES                (1000000U)
+#endif
+#ifndef VALUE_TEST_SIZE
+#define VALUE_TEST_SIZE                 256
+#endif
+
+/* private data structure --------------------------------------------------- */
+typedef struct stream_test
+{
+    const char *key;
+    eos_topic_handle_t handle;
+    bool zero_copy;
+    uint32_t seed;
+    uint32_t bytes;
+    uint32_t error;
+} stream_test_t;
+
+/* private data ------------------------------------------------------------- */
+static pthread_mutex_t mutex_interrupt;
+static volatile uint32_t count_interrupt = 0;
+static __thread uint32_t count_interrupt_thread = 0;
+static volatile bool value_done = false;
+static bool value_multi_buffer = false;
+static uint64_t db_memory[1024];
+
+/* port --------------------------------------------------------------------- */
+eos_base_t eos_hw_interrupt_disable(void)
+{
+    pthread_mutex_lock(&mutex_interrupt);
+    count_interrupt ++;
+    count_interrupt_thread ++;
+
+    return 0;
+}
+
+void eos_hw_interrupt_enable(eos_base_t level)
+{
+    (void)level;
+
+    pthread_mutex_unlock(&mutex_interrupt);
+}
+
+eos_u8_t *eos_hw_stack_init(void *entry, void *parameter,
+                            eos_u8_t *stack_addr, void *exit)
+{
+    (void)entry;
+    (void)parameter;
+    (void)exit;
+
+    return stack_addr;
+}
+
+void eos_task_switch(eos_ubase_t from, eos_ubase_t to)
+{
+    (void)from;
+    (void)to;
+}
+
+void eos_task_switch_to(eos_ubase_t to)
+{
+    (void)to;
+}
+
+void eos_task_switch_interrupt(eos_ubase_t from, eos_ubase_t to)
+{
+    (void)from;
+    (void)to;
+}
+
+void eos_port_assert(const char *tag, const char *name, eos_u32_t id)
+{
+    printf("Assert! %s, %s, %u.\n", tag, (name == EOS_NULL) ? "" : name, id);
+    exit(-1);
+}
+
+/* test --------------------------------------------------------------------- */
+static uint32_t test_rand(uint32_t *seed)
+{
+    *seed = *seed * 1103515245U + 12345U;
+
+    return ((*seed >> 16) % STREAM_TEST_CHUNK) + 1;
+}
+
+static void *thread_producer(void *parameter)
+{
+    stream_test_t *test = (stream_test_t *)parameter;
+    uint32_t seed = test->seed;
+    uint8_t seq = 0;
+    uint8_t buffer[STREAM_TEST_CHUNK];
+
+    for (uint32_t count = 0; count < STREAM_TEST_BYTES;)
+    {
+        uint32_t size = test_rand(&seed);
+        if (size > (STREAM_TEST_BYTES - count))
+        {
+            size = STREAM_TEST_BYTES - count;
+        }
+
+        if (test->zero_copy)
+        {
+            uint8_t *data;
+            uint32_t size_free = eos_db_stream_reserve(test->key, (void **)&data);
+            if (size_free == 0)
+            {
+                sched_yield();
+                continue;
+            }
+            size = (size_free < size) ? size_free : size;
+            for (uint32_t i = 0; i < size; i ++)
+            {
+                data[i] = seq ++;
+            }
+            eos_db_stream_commit(test->key, size);
+            count += size;
+        }
+        else
+        {
+            for (uint32_t i = 0; i < size; i ++)
+            {
+                buffer[i] = (uint8_t)(seq + i);
+            }
+            /* The stream asserts on writing more than the free bytes. */
+            while (eos_db_stream_space_h(test->handle) < size)
+            {
+                sched_yield();
+            }
+            eos_db_stream_write_h(test->handle, buffer, size);
+            seq += size;
+            count += size;
+        }
+    }
+
+    return EOS_NULL;
+}
+
+static void *thread_consumer(void *parameter)
+{
+    stream_test_t *test = (stream_test_t *)parameter;
+    uint32_t seed = test->seed ^ 0x5a5a5a5aU;
+    uint8_t seq = 0;
+    uint8_t buffer[STREAM_TEST_CHUNK];
+
+    while (test->bytes < STREAM_TEST_BYTES)
+    {
+        uint8_t *data = buffer;
+        uint32_t size;
+        if (test->zero_copy)
+        {
+            size = eos_db_stream_peek(test->key, (void **)&data);
+        }
+        else
+        {
+            size = eos_db_stream_read_h(test->handle,
+                                        buffer, test_rand(&seed));
+        }
+        if (size == 0)
+        {
+            sched_yield();
+            continue;
+        }
+
+        for (uint32_t i = 0; i < size; i ++)
+        {
+            if (data[i] != seq)
+            {
+                test->error ++;
+                seq = data[i];
+            }
+            seq ++;
+        }
+        if (test->zero_copy)
+        {
+            eos_db_stream_consume(test->key, size);
+        }
+        test->bytes += size;
+    }
+
+    return EOS_NULL;
+}
+
+static int stream_test_run(stream_test_t *test)
+{
+    pthread_t producer, consumer;
+
+    pthread_create(&consumer, EOS_NULL, thread_consumer, test);
+    pthread_create(&producer, EOS_NULL, thread_producer, test);
+    pthread_join(producer, EOS_NULL);
+    pthread_join(consumer, EOS_NULL);
+
+    printf("%s: %u bytes, %u errors.\n", test->key, test->bytes, test->error);
+
+    return (test->error == 0) ? 0 : -1;
+}
+
+static void *thread_value_writer(void *parameter)
+{
+    uint32_t *error = (uint32_t *)parameter;
+    eos_topic_handle_t handle = eos_topic_handle("Value_Seq");
+    uint32_t buffer[VALUE_TEST_SIZE / 4];
+
+    for (uint32_t count = 1; count <= VALUE_TEST_TIMES; count ++)
+    {
+        uint32_t *value = buffer;
+        if (value_multi_buffer)
+        {
+            value = (uint32_t *)eos_db_value_acquire("Value_Multi_Buffer");
+            if (value == EOS_NULL)
+            {
+                (*error) ++;
+                continue;
+            }
+        }
+        for (uint32_t i = 0; i < (VALUE_TEST_SIZE / 4); i ++)
+        {
+            value[i] = count;
+        }
+        if (value_multi_buffer)
+        {
+            eos_db_value_publish("Value_Multi_Buffer", value);
+        }
+        else
+        {
+            eos_db_block_write_h(handle, value);
+        }
+    }
+    value_done = true;
+
+    return EOS_NULL;
+}
+
+static void *thread_value_reader(void *parameter)
+{
+    uint32_t *error = (uint32_t *)parameter;
+    eos_topic_handle_t handle = eos_topic_handle("Value_Seq");
+    uint32_t buffer[VALUE_TEST_SIZE / 4];
+    const uint32_t *value = buffer;
+    uint32_t last = 0;
+    uint32_t count = 0;
+
+    /* Only the reads are counted, not the lookup of the handle. */
+    count_interrupt_thread = 0;
+    while (value_done == false)
+    {
+        if (value_multi_buffer)
+        {
+            value = (const uint32_t *)eos_db_value_pin("Value_Multi_Buffer");
+        }
+        else
+        {
+            eos_db_block_read_h(handle, buffer);
+        }
+        for (uint32_t i = 1; i < (VALUE_TEST_SIZE / 4); i ++)
+        {
+            if (value[i] != value[0])
+            {
+                (*error) ++;
+                break;
+            }
+        }
+        if (value[0] < last)
+        {
+            (*error) ++;
+        }
+        last = value[0];
+        count ++;
+        if (value_multi_buffer)
+        {
+            eos_db_value_unpin("Value_Multi_Buffer", value);
+        }
+    }
+
+    if (value_multi_buffer == false)
+    {
+        printf("The reader disables the interrupt %u times.\n",
+                count_interrupt_thread);
+        if (count_interrupt_thread > (count / 1000))
+        {
+            (*error) ++;
+        }
+    }
+    printf("%s: %u reads, %u errors.\n",
+           value_multi_buffer ? "Value_Multi_Buffer" : "Value_Seq",
+           count, *error);
+
+    return EOS_NULL;
+}
+
+static int value_test_run(bool multi_buffer)
+{
+    pthread_t writer, reader;
+    uint32_t error = 0;
+
+    value_multi_buffer = multi_buffer;
+    value_done = false;
+    pthread_create(&reader, EOS_NULL, thread_value_reader, &error);
+    pthread_create(&writer, EOS_NULL, thread_value_writer, &error);
+    pthread_join(writer, EOS_NULL);
+    pthread_join(reader, EOS_NULL);
+
+    return (error == 0) ? 0 : -1;
+}
+
+static const char *const snapshot_keys[] =
+{
+    "Snapshot_0", "Snapshot_1", "Snapshot_Multi_Buffer",
+};
+
+static void *thread_snapshot_writer(void *parameter)
+{
+    (void)parameter;
+
+    for (uint32_t count = 1; count <= VALUE_TEST_TIMES; count ++)
+    {
+        for (uint32_t i = 0; i < 3; i ++)
+        {
+            eos_db_block_write(snapshot_keys[i], &count);
+        }
+    }
+    value_done = true;
+
+    return EOS_NULL;
+}
+
+static void *thread_snapshot_reader(void *parameter)
+{
+    uint32_t *error = (uint32_t *)parameter;
+    eos_topic_handle_t handle[3];
+    uint32_t value[3];
+    void *const data[3] = { &value[0], &value[1], &value[2] };
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < 3; i ++)
+    {
+        handle[i] = eos_topic_handle(snapshot_keys[i]);
+    }
+
+    while (value_done == false)
+    {
+        if ((count & 1) == 0)
+        {
+            eos_db_snapshot_read(snapshot_keys, data, 3);
+        }
+        else
+        {
+            eos_db_snapshot_read_h(handle, data, 3);
+        }
+        if (value[0] < value[1] || value[1] < value[2] ||
+            (value[0] - value[2]) > 1)
+        {
+            (*error) ++;
+        }
+        count ++;
+    }
+    printf("Snapshot: %u reads, %u errors.\n", count, *error);
+
+    return EOS_NULL;
+}
+
+static int snapshot_test_run(void)
+{
+    pthread_t writer, reader;
+    uint32_t error = 0;
+
+    value_done = false;
+    pthread_create(&reader, EOS_NULL, thread_snapshot_reader, &error);
+    pthread_create(&writer, EOS_NULL, thread_snapshot_writer, EOS_NULL);
+    pthread_join(writer, EOS_NULL);
+    pthread_join(reader, EOS_NULL);
+
+    return (error == 0) ? 0 : -1;
+}
+
+/* The readers pin all the back buffers one by one, and then the write is
+   dropped and counted, not asserted, and the latest value is kept. */
+static int drop_test_run(void)
+{
+    const char *key = "Snapshot_Multi_Buffer";
+    const void *pin[EOS_DB_VALUE_BUFFERS];
+    uint32_t drop = eos_db_value_drop(key);
+    uint32_t value = 0;
+    uint32_t error = 0;
+
+    for (uint32_t i = 0; i < (EOS_DB_VALUE_BUFFERS - 1); i ++)
+    {
+        pin[i] = eos_db_value_pin(key);
+        value = i;
+        eos_db_block_write(key, &value);
+    }
+    pin[EOS_DB_VALUE_BUFFERS - 1] = eos_db_value_pin(key);
+    value = EOS_DB_VALUE_BUFFERS;
+    eos_db_block_write(key, &value);
+    if (eos_db_value_acquire(key) != EOS_NULL ||
+        eos_db_value_drop(key) != (drop + 2))
+    {
+        error ++;
+    }
+    eos_db_block_read(key, &value);
+    if (value != (EOS_DB_VALUE_BUFFERS - 2))
+    {
+        error ++;
+    }
+    for (uint32_t i = 0; i < EOS_DB_VALUE_BUFFERS; i ++)
+    {
+        eos_db_value_unpin(key, pin[i]);
+    }
+    printf("Drop: %u writes, %u errors.\n", eos_db_value_drop(key) - drop, error);
+
+    return (error == 0) ? 0 : -1;
+}
+
+int main(int argc, char ** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mutex_interrupt, &attr);
+
+    eos_init();
+    eos_db_init(db_memory, sizeof(db_memory));
+    eos_db_register("Stream_Copy", 1000,
+                    EOS_DB_ATTRIBUTE_STREAM | EOS_DB_ATTRIBUTE_SPSC);
+    eos_db_register("Stream_Zero_Copy", 1024,
+                    EOS_DB_ATTRIBUTE_STREAM | EOS_DB_ATTRIBUTE_SPSC);
+    eos_db_register("Value_Seq", VALUE_TEST_SIZE, EOS_DB_ATTRIBUTE_VALUE);
+    eos_db_register("Value_Multi_Buffer", VALUE_TEST_SIZE,
+                    EOS_DB_ATTRIBUTE_VALUE | EOS_DB_ATTRIBUTE_MULTI_BUFFER);
+    eos_db_register("Snapshot_0", sizeof(uint32_t), EOS_DB_ATTRIBUTE_VALUE);
+    eos_db_register("Snapshot_1", sizeof(uint32_t), EOS_DB_ATTRIBUTE_VALUE);
+    eos_db_register("Snapshot_Multi_Buffer", sizeof(uint32_t),
+                    EOS_DB_ATTRIBUTE_VALUE | EOS_DB_ATTRIBUTE_MULTI_BUFFER);
+
+    stream_test_t test_copy =
+    {
+        "Stream_Copy", eos_topic_handle("Stream_Copy"), false, 1, 0, 0
+    };
+    stream_test_t test_zero_copy =
+    {
+        "Stream_Zero_Copy", eos_topic_handle("Stream_Zero_Copy"), true, 2, 0, 0
+    };
+
+    int ret = 0;
+    uint32_t count = count_interrupt;
+    ret |= stream_test_run(&test_copy);
+    if (count_interrupt != count)
+    {
+        printf("The interrupt is disabled %u times.\n", count_interrupt - count);
+        ret = -1;
+    }
+    ret |= stream_test_run(&test_zero_copy);
+    ret |= value_test_run(false);
+    ret |= value_test_run(true);
+    ret |= snapshot_test_run();
+    ret |= drop_test_run();
+
+    printf("%s\n", (ret == 0) ? "Passed." : "Failed.");
+
+    return ret;
+}
@@ -0,0 +1,12 @@
+#!/bin/sh
+# Build and run the stress test of the lock-free db access on the host.
+
+mkdir -p build
+
+gcc -std=gnu99 -O2 -g -Wall \
+    main.c \
+    ../../eventos/eos.c \
+    ../../eventos/eos_kernel.c \
+    -I ../../eventos \
+    -lpthread \
+    -o build/stream && ./build/stream
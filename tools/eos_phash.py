@@ -0,0 +1,262 @@
+# Filename: eos_phash.py
+
+# Generate the topic header with a minimal perfect hash from a topic manifest.
+#
+# The manifest is the one of tools/eos_topic.py, in which the tasks and the
+# timers known at build time can be listed too:
+#
+#     # name              type        size    flags
+#     Event_Time_500ms    topic
+#     Event_Value         value       8       link_event
+#     TaskLed             actor
+#     Event_Blink         timer
+#
+# The keys are hashed with their type prefixes, 'A', 'E' or 'T', as ch_type[] in
+# eos.c, and the static objects take the IDs 0 ~ EOS_TOPIC_NUM - 1 given by the
+# perfect hash, so the lookup of a static key is exactly one probe:
+#
+#     x  = hash ^ (disp[hash % EOS_TOPIC_PHASH_BUCKETS] * 0x9e3779b9)
+#     id = mix32(x) % EOS_TOPIC_NUM
+#
+# The displacements are searched by hash and displace, from the biggest bucket.
+# The keys created at runtime are not in the perfect hash, and are put into the
+# dynamic slots after the static objects.
+#
+# The generated header is a superset of the one of eos_topic.py, and is used in
+# the same way, with EOS_USE_TOPIC_TABLE enabled. Only the topics are filled in
+# the object table, and the tasks and the timers are filled when created.
+#
+# Usage as a script:
+#     python tools/eos_phash.py topic.txt -o eos_topic.h -c eventos/eos_config.h
+#
+# Usage as a SCons tool:
+#     env = Environment(tools = ['default', 'eos_phash'], toolpath = ['tools'])
+#     env.EosPhash('build/eos_topic.h', 'topic.txt')
+
+import argparse
+import os
+import re
+import sys
+
+sys.path.append(os.path.dirname(os.path.abspath(__file__)))
+
+from eos_topic import TopicError, TYPES, TYPE_MACROS, FLAGS, OBJECTS
+from eos_topic import time33, parse_config, parse_manifest
+
+CH_TYPES = {
+    'A': 'EosObj_Actor',
+    'E': 'EosObj_Event',
+    'T': 'EosObj_Timer',
+}
+
+DISP_MAX = 0xffff
+
+
+def mix32(x):
+    x ^= x >> 16
+    x = (x * 0x7feb352d) & 0xffffffff
+    x ^= x >> 15
+    x = (x * 0x846ca68b) & 0xffffffff
+    x ^= x >> 16
+
+    return x
+
+
+def phash_index(hash, disp, num):
+    return mix32(hash ^ ((disp * 0x9e3779b9) & 0xffffffff)) % num
+
+
+def phash_search(hashes, buckets):
+    num = len(hashes)
+    members = [[] for i in range(buckets)]
+    for hash in hashes:
+        members[hash % buckets].append(hash)
+
+    disp = [0] * buckets
+    used = [False] * num
+    order = sorted(range(buckets), key = lambda b: len(members[b]), reverse = True)
+    for b in order:
+        if len(members[b]) == 0:
+            break
+        for d in range(DISP_MAX + 1):
+            index = [phash_index(hash, d, num) for hash in members[b]]
+            if len(set(index)) == len(index) and not any(used[i] for i in index):
+                for i in index:
+                    used[i] = True
+                disp[b] = d
+                break
+        else:
+            return None
+
+    return disp
+
+
+def phash_build(hashes):
+    # Fewer buckets give a smaller table, and more buckets an easier search.
+    buckets = max(1, (len(hashes) + 1) // 2)
+    while True:
+        disp = phash_search(hashes, buckets)
+        if disp is not None:
+            return disp
+        if buckets >= len(hashes):
+            raise TopicError('no perfect hash is found, rename the keys')
+        buckets += 1
+
+
+def generate_header(objects, max_objects, guard = 'EOS_TOPIC_H_'):
+    # The dynamic objects take the IDs after the static ones.
+    if len(objects) >= max_objects:
+        raise TopicError('the object table is full, enlarge EOS_MAX_OBJECTS')
+    if len(objects) == 0:
+        raise TopicError('no key is in the manifest')
+
+    keys = {}
+    for name, type, size, flags in objects:
+        ch_type = OBJECTS.get(type, 'E')
+        if (ch_type, name) in keys:
+            raise TopicError('%s %s is defined twice' % (type, name))
+        hash = time33(ch_type, name)
+        for (ch_other, other), item in keys.items():
+            if item[0] == hash:
+                raise TopicError('%s and %s have the same hash, rename one' %
+                                 (other, name))
+        keys[(ch_type, name)] = (hash, type, size, flags)
+
+    hashes = [item[0] for item in keys.values()]
+    disp = phash_build(hashes)
+    num = len(hashes)
+
+    items = [None] * num
+    for (ch_type, name), (hash, type, size, flags) in keys.items():
+        index = phash_index(hash, disp[hash % len(disp)], num)
+        attribute = TYPES.get(type, 0)
+        macros = [TYPE_MACROS.get(type, '0')]
+        for flag in flags:
+            attribute |= FLAGS[flag][0]
+            macros.append(FLAGS[flag][1])
+        items[index] = (name, ch_type, hash, size, attribute, ' | '.join(macros))
+    topics = [(index, item) for index, item in enumerate(items)
+              if item[1] == 'E']
+
+    out = []
+    out.append('/* Generated by tools/eos_phash.py, do not edit. */')
+    out.append('')
+    out.append('#ifndef %s' % guard)
+    out.append('#define %s' % guard)
+    out.append('')
+    out.append('#define EOS_TOPIC_MAX_OBJECTS                   %d' % max_objects)
+    out.append('#define EOS_TOPIC_NUM                           %d' % num)
+    out.append('#define EOS_TOPIC_PHASH_BUCKETS                 %d' % len(disp))
+    out.append('')
+    out.append('/* Topic ID, the same as e->eid. */')
+    out.append('enum eos_topic_id')
+    out.append('{')
+    for index, (name, ch_type, hash, size, attribute, macros) in topics:
+        out.append('    %-40s = %d,' % ('EosTopic_' + name, index))
+    out.append('};')
+    out.append('')
+    out.append('/* The time33 hash of the topic. */')
+    for index, (name, ch_type, hash, size, attribute, macros) in topics:
+        out.append('#define %-40s 0x%08xU' % ('EOS_TOPIC_HASH_' + name, hash))
+    out.append('')
+    out.append('/* The value size of the topic. */')
+    for index, (name, ch_type, hash, size, attribute, macros) in topics:
+        out.append('#define %-40s %d' % ('EOS_TOPIC_SIZE_' + name, size))
+    out.append('')
+    out.append('/* The DB attribute of the topic. */')
+    for index, (name, ch_type, hash, size, attribute, macros) in topics:
+        out.append('#define %-40s 0x%02xU' % ('EOS_TOPIC_ATTR_' + name, attribute))
+    out.append('')
+    out.append('/* The displacements of the perfect hash, only used in eos.c. */')
+    out.append('#define EOS_TOPIC_PHASH_DISP_INIT                                              \\')
+    out.append('{                                                                              \\')
+    for i in range(0, len(disp), 8):
+        line = '    ' + ' '.join('%d,' % d for d in disp[i:i + 8])
+        out.append('%-79s\\' % line)
+    out.append('}')
+    out.append('')
+    out.append('/* The static keys in the order of the IDs, only used in eos.c. */')
+    out.append('#define EOS_TOPIC_PHASH_KEY_INIT                                               \\')
+    out.append('{                                                                              \\')
+    for name, ch_type, hash, size, attribute, macros in items:
+        line = '    { "%s", 0x%08xU, %s },' % (name, hash, CH_TYPES[ch_type])
+        out.append('%-79s\\' % line)
+    out.append('}')
+    out.append('')
+    out.append('/* The initializer of eos.object[], only used in eos.c. */')
+    out.append('#define EOS_TOPIC_OBJECT_INIT                                                  \\')
+    out.append('{                                                                              \\')
+    for index, (name, ch_type, hash, size, attribute, macros) in topics:
+        line = '    [%d] = { .key = "%s", .type = EosObj_Event,' % (index, name)
+        out.append('%-79s\\' % line)
+        line = '             .hash = 0x%08xU,' % hash
+        out.append('%-79s\\' % line)
+        line = '             .attribute = %s,' % macros
+        out.append('%-79s\\' % line)
+        line = '             .size = %d },' % size
+        out.append('%-79s\\' % line)
+    out.append('}')
+    out.append('')
+    out.append('#endif')
+    out.append('')
+
+    return '\n'.join(out)
+
+
+def build(target, source, max_objects):
+    objects = parse_manifest(source, objects = True)
+    guard = re.sub(r'[^A-Za-z0-9]', '_', os.path.basename(target)).upper() + '_'
+    text = generate_header(objects, max_objects, guard)
+    with open(target, mode = 'w', encoding = 'utf-8', newline = '\n') as f:
+        f.write(text)
+
+
+# SCons tool ------------------------------------------------------------------
+def _scons_action(target, source, env):
+    max_objects = parse_config(env.subst('$EOS_CONFIG'))
+    build(str(target[0]), str(source[0]), max_objects)
+    return 0
+
+
+def generate(env):
+    from SCons.Builder import Builder
+    from SCons.Action import Action
+
+    env.SetDefault(EOS_CONFIG = '#eventos/eos_config.h')
+    env.SetDefault(EOS_PHASH_COMSTR = 'PHASH $TARGET')
+    action = Action(_scons_action, '$EOS_PHASH_COMSTR')
+
+    def emitter(target, source, env):
+        env.Depends(target, env.File(env.subst('$EOS_CONFIG')))
+        return target, source
+
+    env['BUILDERS']['EosPhash'] = Builder(action = action,
+                                          suffix = '.h',
+                                          src_suffix = '.txt',
+                                          emitter = emitter)
+
+
+def exists(env):
+    return True
+
+
+# Command line ----------------------------------------------------------------
+def main():
+    parser = argparse.ArgumentParser(description = 'Generate the EventOS topic header with a perfect hash.')
+    parser.add_argument('manifest')
+    parser.add_argument('-o', '--output', default = 'eos_topic.h')
+    parser.add_argument('-c', '--config', default = 'eventos/eos_config.h')
+    args = parser.parse_args()
+
+    try:
+        max_objects = parse_config(args.config)
+        build(args.output, args.manifest, max_objects)
+    except TopicError as e:
+        sys.stderr.write('eos_phash: %s\n' % e)
+        return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,272 @@
+# Filename: eos_topic.py
+
+# Generate the topic header from a topic manifest.
+#
+# The manifest is a plain text file, one topic per line:
+#
+#     # name              type        size    flags
+#     Event_Time_500ms    topic
+#     Event_Value         value       8       link_event persistent
+#     Event_Log           stream      1024    link_event
+#
+# type  : topic, value or stream. A topic has no size.
+# flags : link_event, global, persistent, multi_buffer and change_only for a
+#         value, and spsc for a stream.
+#
+# The generated header holds the topic IDs (the object index in the object
+# table), the time33 hashes, the sizes and the DB attributes, and the initializer
+# of the pre-populated object table. With EOS_USE_TOPIC_TABLE enabled, eos.c
+# includes it, so the topics need not be inserted at runtime and the handlers
+# can use switch (e->eid) instead of eos_event_topic().
+#
+# The topic IDs are given in the order of the manifest, and eos_init() puts them
+# into the hash slots, so only EOS_MAX_OBJECTS is read from eos_config.h.
+#
+# Usage as a script:
+#     python tools/eos_topic.py topic.txt -o eos_topic.h -c eventos/eos_config.h
+#
+# Usage as a SCons tool:
+#     env = Environment(tools = ['default', 'eos_topic'], toolpath = ['tools'])
+#     env.EosTopic('build/eos_topic.h', 'topic.txt')
+
+import argparse
+import os
+import re
+import sys
+
+OBJ_EVENT = 1
+CH_TYPE_EVENT = 'E'
+
+TYPES = {
+    'topic': 0x00,
+    'value': 0x01,
+    'stream': 0x02,
+}
+
+TYPE_MACROS = {
+    'topic': 'EOS_EVENT_ATTRIBUTE_TOPIC',
+    'value': 'EOS_DB_ATTRIBUTE_VALUE',
+    'stream': 'EOS_DB_ATTRIBUTE_STREAM',
+}
+
+FLAGS = {
+    'link_event': (0x40, 'EOS_DB_ATTRIBUTE_LINK_EVENT'),
+    'persistent': (0x20, 'EOS_DB_ATTRIBUTE_PERSISTENT'),
+    'global': (0x80, 'EOS_EVENT_ATTRIBUTE_GLOBAL'),
+    'spsc': (0x04, 'EOS_DB_ATTRIBUTE_SPSC'),
+    'multi_buffer': (0x08, 'EOS_DB_ATTRIBUTE_MULTI_BUFFER'),
+    'change_only': (0x10, 'EOS_DB_ATTRIBUTE_CHANGE_ONLY'),
+}
+
+# The actors and the timers are only pre-populated by tools/eos_phash.py.
+OBJECTS = {
+    'actor': 'A',
+    'timer': 'T',
+}
+
+RE_NAME = re.compile(r'^[A-Za-z_][A-Za-z0-9_]*$')
+
+
+class TopicError(Exception):
+    pass
+
+
+def time33(ch_type, string):
+    hash = 5381
+    hash = (hash + (hash << 5) + ord(ch_type)) & 0xffffffff
+    for ch in string.encode('utf-8'):
+        hash = (hash + (hash << 5) + ch) & 0xffffffff
+
+    return hash & 0x7fffffff
+
+
+def parse_config(path):
+    config = {}
+    with open(path, mode = 'r', encoding = 'utf-8') as f:
+        for line in f:
+            m = re.match(r'\s*#define\s+(EOS_MAX_OBJECTS)\s+(\d+)', line)
+            if m:
+                config[m.group(1)] = int(m.group(2))
+
+    if 'EOS_MAX_OBJECTS' not in config:
+        raise TopicError('EOS_MAX_OBJECTS is not defined in %s' % path)
+
+    return config['EOS_MAX_OBJECTS']
+
+
+def parse_manifest(path, objects = False):
+    topics = []
+    with open(path, mode = 'r', encoding = 'utf-8') as f:
+        for num, line in enumerate(f, 1):
+            line = line.split('#', 1)[0].strip()
+            if line == '':
+                continue
+
+            fields = line.split()
+            name = fields[0]
+            type = fields[1] if len(fields) > 1 else 'topic'
+            if not RE_NAME.match(name):
+                raise TopicError('%s:%d: %s is not a C identifier' %
+                                 (path, num, name))
+            if type in OBJECTS:
+                if not objects:
+                    raise TopicError('%s:%d: %s is only for eos_phash.py' %
+                                     (path, num, type))
+                if len(fields) > 2:
+                    raise TopicError('%s:%d: %s has no size or flag' %
+                                     (path, num, name))
+                topics.append((name, type, 0, []))
+                continue
+            if type not in TYPES:
+                raise TopicError('%s:%d: unknown type %s' % (path, num, type))
+
+            size = 0
+            flags = fields[2:]
+            if type != 'topic':
+                if len(fields) < 3 or not fields[2].isdigit():
+                    raise TopicError('%s:%d: %s needs a size' %
+                                     (path, num, name))
+                size = int(fields[2])
+                flags = fields[3:]
+                if size <= 0 or size > 0xffff:
+                    raise TopicError('%s:%d: the size must be 1 ~ 65535' %
+                                     (path, num))
+            for flag in flags:
+                if flag not in FLAGS:
+                    raise TopicError('%s:%d: unknown flag %s' %
+                                     (path, num, flag))
+            if 'spsc' in flags and type != 'stream':
+                raise TopicError('%s:%d: spsc is only for a stream' %
+                                 (path, num))
+            for flag in ('persistent', 'multi_buffer', 'change_only'):
+                if flag in flags and type != 'value':
+                    raise TopicError('%s:%d: %s is only for a value' %
+                                     (path, num, flag))
+
+            topics.append((name, type, size, flags))
+
+    return topics
+
+
+def generate_header(topics, max_objects, guard = 'EOS_TOPIC_H_'):
+    # The tasks and the timers take the objects after the topics.
+    if len(topics) >= max_objects:
+        raise TopicError('the object table is full, enlarge EOS_MAX_OBJECTS')
+
+    items = []
+    for index, (name, type, size, flags) in enumerate(topics):
+        if name in [item[0] for item in items]:
+            raise TopicError('topic %s is defined twice' % name)
+        hash = time33(CH_TYPE_EVENT, name)
+        attribute = TYPES[type]
+        macros = [TYPE_MACROS[type]]
+        for flag in flags:
+            attribute |= FLAGS[flag][0]
+            macros.append(FLAGS[flag][1])
+        items.append((name, index, hash, size, attribute, ' | '.join(macros)))
+
+    out = []
+    out.append('/* Generated by tools/eos_topic.py, do not edit. */')
+    out.append('')
+    out.append('#ifndef %s' % guard)
+    out.append('#define %s' % guard)
+    out.append('')
+    out.append('#define EOS_TOPIC_MAX_OBJECTS                   %d' % max_objects)
+    out.append('#define EOS_TOPIC_NUM                           %d' % len(items))
+    out.append('')
+    out.append('/* Topic ID, the same as e->eid. */')
+    out.append('enum eos_topic_id')
+    out.append('{')
+    for name, index, hash, size, attribute, macros in items:
+        out.append('    %-40s = %d,' % ('EosTopic_' + name, index))
+    out.append('};')
+    out.append('')
+    out.append('/* The time33 hash of the topic. */')
+    for name, index, hash, size, attribute, macros in items:
+        out.append('#define %-40s 0x%08xU' % ('EOS_TOPIC_HASH_' + name, hash))
+    out.append('')
+    out.append('/* The value size of the topic. */')
+    for name, index, hash, size, attribute, macros in items:
+        out.append('#define %-40s %d' % ('EOS_TOPIC_SIZE_' + name, size))
+    out.append('')
+    out.append('/* The DB attribute of the topic. */')
+    for name, index, hash, size, attribute, macros in items:
+        out.append('#define %-40s 0x%02xU' % ('EOS_TOPIC_ATTR_' + name, attribute))
+    out.append('')
+    out.append('/* The initializer of eos.object[], only used in eos.c. */')
+    out.append('#define EOS_TOPIC_OBJECT_INIT                                                  \\')
+    out.append('{                                                                              \\')
+    for name, index, hash, size, attribute, macros in items:
+        line = '    [%d] = { .key = "%s", .type = EosObj_Event,' % (index, name)
+        out.append('%-79s\\' % line)
+        line = '             .hash = 0x%08xU,' % hash
+        out.append('%-79s\\' % line)
+        line = '             .attribute = %s,' % macros
+        out.append('%-79s\\' % line)
+        line = '             .size = %d },' % size
+        out.append('%-79s\\' % line)
+    out.append('}')
+    out.append('')
+    out.append('#endif')
+    out.append('')
+
+    return '\n'.join(out)
+
+
+def build(target, source, max_objects):
+    topics = parse_manifest(source)
+    guard = re.sub(r'[^A-Za-z0-9]', '_', os.path.basename(target)).upper() + '_'
+    text = generate_header(topics, max_objects, guard)
+    with open(target, mode = 'w', encoding = 'utf-8', newline = '\n') as f:
+        f.write(text)
+
+
+# SCons tool ------------------------------------------------------------------
+def _scons_action(target, source, env):
+    max_objects = parse_config(env.subst('$EOS_CONFIG'))
+    build(str(target[0]), str(source[0]), max_objects)
+    return 0
+
+
+def generate(env):
+    from SCons.Builder import Builder
+    from SCons.Action import Action
+
+    env.SetDefault(EOS_CONFIG = '#eventos/eos_config.h')
+    env.SetDefault(EOS_TOPIC_COMSTR = 'TOPIC $TARGET')
+    action = Action(_scons_action, '$EOS_TOPIC_COMSTR')
+
+    def emitter(target, source, env):
+        env.Depends(target, env.File(env.subst('$EOS_CONFIG')))
+        return target, source
+
+    env['BUILDERS']['EosTopic'] = Builder(action = action,
+                                          suffix = '.h',
+                                          src_suffix = '.txt',
+                                          emitter = emitter)
+
+
+def exists(env):
+    return True
+
+
+# Command line ----------------------------------------------------------------
+def main():
+    parser = argparse.ArgumentParser(description = 'Generate the EventOS topic header.')
+    parser.add_argument('manifest')
+    parser.add_argument('-o', '--output', default = 'eos_topic.h')
+    parser.add_argument('-c', '--config', default = 'eventos/eos_config.h')
+    args = parser.parse_args()
+
+    try:
+        max_objects = parse_config(args.config)
+        build(args.output, args.manifest, max_objects)
+    except TopicError as e:
+        sys.stderr.write('eos_topic: %s\n' % e)
+        return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())